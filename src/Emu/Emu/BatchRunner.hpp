@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+#include <Emu/ThreadPool.hpp>
+
+
+namespace Emu
+{
+
+    struct BatchMachine
+    {
+        CPU * Cpu;
+        Memory * Ram;
+    };
+
+    struct BatchResult
+    {
+        uint64 CyclesUsed = 0;
+        bool Stopped = false;       // Stop condition was met
+        bool Halted = false;        // Hit an unhandled instruction
+    };
+
+    struct NeverStop
+    {
+        bool operator()(CPU const &, Memory const &) const
+        {
+            return false;
+        }
+    };
+
+
+    // Runs independent machines across a thread pool. Each machine runs in fixed slices of cycles
+    // and the stop condition is checked between slices, so a machine's result only depends on
+    // itself and never on the thread count or which worker picked it up. Results go into the
+    // caller's array, nothing is allocated per machine
+    struct BatchRunner
+    {
+        static constexpr uint32 DEFAULT_SLICE_CYCLES = 1000u;
+
+        ThreadPool & Pool;
+        uint32 SliceCycles = DEFAULT_SLICE_CYCLES;
+
+        explicit BatchRunner(ThreadPool & pool)
+            : Pool(pool)
+        { }
+
+        // Runs every machine for cycleBudget cycles or until stop(cpu, memory) returns true, results
+        // has to hold count entries
+        template <typename TStop = NeverStop>
+        void Run(BatchMachine const * machines, BatchResult * results, size_t count, uint64 cycleBudget, TStop const & stop = { })
+        {
+            Batch<TStop> batch { machines, results, cycleBudget, SliceCycles, stop };
+            Pool.Run(count, &RunMachine<TStop>, &batch);
+        }
+
+        template <typename TStop>
+        struct Batch
+        {
+            BatchMachine const * Machines;
+            BatchResult * Results;
+            uint64 CycleBudget;
+            uint32 SliceCycles;
+            TStop const & Stop;
+        };
+
+        template <typename TStop>
+        static void RunMachine(void * context, size_t index)
+        {
+            auto const & batch = *static_cast<Batch<TStop> *>(context);
+            auto & cpu = *batch.Machines[index].Cpu;
+            auto & memory = *batch.Machines[index].Ram;
+
+            BatchResult result;
+            while (result.CyclesUsed < batch.CycleBudget)
+            {
+                auto remaining = batch.CycleBudget - result.CyclesUsed;
+                auto slice = static_cast<uint32>(std::min<uint64>(remaining, batch.SliceCycles));
+
+                // An instruction can run past the end of a slice, count what it really used
+                result.CyclesUsed += cpu.Execute(slice, memory);
+
+                if (cpu.DebugFlags.UnhandledInstruction)
+                {
+                    result.Halted = true;
+                    break;
+                }
+
+                if (batch.Stop(cpu, memory))
+                {
+                    result.Stopped = true;
+                    break;
+                }
+            }
+
+            batch.Results[index] = result;
+        }
+    };
+
+}
\ No newline at end of file
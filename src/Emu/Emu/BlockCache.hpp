@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Emu/Memory.hpp>
+
+
+namespace Emu
+{
+
+    struct CPU;
+    struct MicroOp;
+
+    // Takes and returns the remaining cycles like CPU::InstructionHandler
+    using MicroOpHandler = uint32 (*)(CPU & cpu, uint32 cycles, Memory & memory, MicroOp const & op);
+
+    // Recompiled block, returns the cycles used and leaves PC at the next instruction to run
+    using NativeBlock = uint32 (*)(CPU * cpu, Memory * memory);
+
+    // One pre-decoded instruction, operand bytes and base cycles are resolved when the block is built
+    struct MicroOp
+    {
+        MicroOpHandler Handler;
+        Word Operand;
+        Byte OpCode;
+        Byte Length;
+        Byte Cycles;
+    };
+
+    // Straight-line run of instructions starting at Address, ending at a jump, subroutine call or return
+    struct DecodedBlock
+    {
+        static constexpr uint32 MAX_OPS = 16;
+
+        Word Address;
+        Byte Count;         // 0 when the slot is empty
+        Byte FirstPage;
+        Byte LastPage;
+        Byte MaxCycles;     // Base cycles plus every possible page crossing penalty
+        uint32 FirstPageGeneration;
+        uint32 LastPageGeneration;
+        uint32 ExecutionCount;
+        NativeBlock Native;
+        MicroOp Ops[MAX_OPS];
+
+        inline bool IsValid(Memory const & memory) const
+        {
+            return Count != 0
+                && memory.CodePageGenerations[FirstPage] == FirstPageGeneration
+                && memory.CodePageGenerations[LastPage] == LastPageGeneration;
+        }
+    };
+
+    // Direct mapped cache of decoded blocks keyed by start address
+    struct BlockCache
+    {
+        static constexpr uint32 MAX_BLOCKS = 1024;
+
+        std::unique_ptr<DecodedBlock[]> Blocks = std::make_unique<DecodedBlock[]>(MAX_BLOCKS);
+
+        inline DecodedBlock & Slot(Word address)
+        {
+            return Blocks[address % MAX_BLOCKS];
+        }
+
+        // Returns nullptr when the block needs to be decoded
+        inline DecodedBlock * Find(Word address, Memory const & memory)
+        {
+            auto & block = Slot(address);
+            return block.Count != 0 && block.Address == address && block.IsValid(memory) ? &block : nullptr;
+        }
+
+        void Clear()
+        {
+            for (uint32 i = 0; i < MAX_BLOCKS; ++i)
+            {
+                Blocks[i].Count = 0;
+                Blocks[i].Native = nullptr;
+            }
+        }
+
+        // Forgets compiled code while keeping the decoded blocks
+        void DropNative()
+        {
+            for (uint32 i = 0; i < MAX_BLOCKS; ++i)
+            {
+                Blocks[i].Native = nullptr;
+                Blocks[i].ExecutionCount = 0;
+            }
+        }
+    };
+
+}
\ No newline at end of file
@@ -1,11 +1,61 @@
 #pragma once
 
+#include <algorithm>
+
+#include <Emu/BlockCache.hpp>
 #include <Emu/Memory.hpp>
+#include <Emu/OpCodes.hpp>
+
 
+// Threaded dispatch needs the labels-as-values extension; define as 0 to force the portable table
+#if !defined(EMU_THREADED_DISPATCH)
+    #if defined(__GNUC__) || defined(__clang__)
+        #define EMU_THREADED_DISPATCH 1
+    #else
+        #define EMU_THREADED_DISPATCH 0
+    #endif
+#endif
+
+// Lazy flags keep the last result byte and only work out Z and N when the status is observed
+#if !defined(EMU_LAZY_FLAGS)
+    #define EMU_LAZY_FLAGS 1
+#endif
 
 namespace Emu
 {
 
+    struct Recompiler;
+    struct Scheduler;
+
+    // Profiling policy for RunTable, the empty hooks are inlined away so the default loop is unchanged
+    struct NoProfiler
+    {
+        static constexpr bool HOOKS_INSTRUCTIONS = false;
+
+        void BeforeInstruction()
+        { }
+
+        void Instruction(Byte, uint32)
+        { }
+
+        void Interrupt(Word, uint32)
+        { }
+    };
+
+    // An unhandled opcode, PC is the opcode's address and Cycle the point on the TotalCycles
+    // timeline just after it
+    struct TrapRecord
+    {
+        uint64 Cycle;
+        Word PC;
+        Byte OpCode;
+    };
+
+    // Called from inside the run that trapped, so it should only record the trap. Formatting
+    // or printing is left to whoever reads the record later
+    using TrapHandler = void (*)(void * context, TrapRecord const & trap);
+
+
     struct CPUStatusFlags
     {
         Byte CarryFlag : 1;
@@ -42,85 +92,58 @@ namespace Emu
             CPUDebugFlags DebugFlags;
         };
 
-        void Reset(Memory & memory, Word programCounter = 0xFFFC)
-        {
-            PC = programCounter;
-            SP = 0xFF;
+#if EMU_LAZY_FLAGS
+        Byte FlagResult;    // Zero and Negative come from this value while FlagsPending is set
+        Byte FlagsPending;
+#endif
 
-            Status = 0;
-            DebugStatus = 0;
+        uint64 TotalCycles; // Cycles run since reset, runs go up to a target on this timeline
+        uint64 RunEnd;      // TotalCycles the current run's budget ends at, set by RunUntil
 
-            A = X = Y = 0;
+        // Where unhandled opcodes are reported, nothing beyond the debug flag when not set.
+        // Kept over resets
+        TrapHandler OnTrap = nullptr;
+        void * TrapContext = nullptr;
 
-            memory.Initialize();
-        }
-
-        inline Byte FetchByte(uint32 & cycles, Memory const & memory)
-        {
-            auto value = memory.ReadByte(PC);
-            ++PC;
-            --cycles;
-            return value;
-        }
+        // Budget a single run counts down, small enough that running past zero reads as negative
+        static constexpr uint32 MAX_BUDGET = static_cast<uint32>(std::numeric_limits<int32>::max());
 
-        inline Word FetchAddressAbsolute(uint32 & cycles, Memory const & memory)
-        {
-            return FetchWord(cycles, memory);
-        }
-
-        inline Word FetchAddressAbsoluteX(uint32 & cycles, Memory const & memory, bool useCycleAnyway = false)
-        {
-            auto address = FetchAddressAbsolute(cycles, memory);
-            cycles -= useCycleAnyway || ((address & 0xFF) + X) > 0xFF ? 1 : 0;
-            address += X;
-            return address;
-        }
-
-        inline Word FetchAddressAbsoluteY(uint32 & cycles, Memory const & memory, bool useCycleAnyway = false)
-        {
-            auto address = FetchAddressAbsolute(cycles, memory);
-            cycles -= useCycleAnyway || ((address & 0xFF) + Y) > 0xFF ? 1 : 0;
-            address += Y;
-            return address;
-        }
-
-        inline Word FetchAddressIndirectX(uint32 & cycles, Memory const & memory)
+        void Reset(Memory & memory, Word programCounter = 0xFFFC)
         {
-            auto zeroPageAddress = FetchAddressZeroPage(cycles, memory);
-            --cycles;
-            zeroPageAddress += X;
-            return ReadWord(cycles, zeroPageAddress, memory);
+            ResetRegisters(programCounter);
+            memory.Initialize();
         }
 
-        inline Word FetchAddressIndirectY(uint32 & cycles, Memory const & memory, bool useCycleAnyway = false)
+        // Reset with memory put back to a checkpoint rather than cleared, only the pages written
+        // since the checkpoint are copied
+        void Reset(Memory & memory, MemorySnapshot const & snapshot, Word programCounter = 0xFFFC)
         {
-            auto zeroPageAddress = FetchAddressZeroPage(cycles, memory);
-            auto address = ReadWord(cycles, zeroPageAddress, memory);
-            cycles -= useCycleAnyway || ((address & 0xFF) + Y) > 0xFF ? 1 : 0;
-            address += Y;
-            return address;
+            ResetRegisters(programCounter);
+            memory.ResetToSnapshot(snapshot);
         }
 
-        inline Word FetchAddressImmediate(uint32 & cycles, Memory const & memory)
+        void ResetRegisters(Word programCounter)
         {
-            return PC++;
-        }
+            PC = programCounter;
+            SP = 0xFF;
 
-        inline Word FetchAddressZeroPage(uint32 & cycles, Memory const & memory)
-        {
-            return FetchByte(cycles, memory);
-        }
+            Status = 0;
+            DebugStatus = 0;
+#if EMU_LAZY_FLAGS
+            FlagsPending = 0;
+#endif
 
-        inline Word FetchAddressZeroPageX(uint32 & cycles, Memory const & memory)
-        {
-            --cycles;
-            return (FetchAddressZeroPage(cycles, memory) + X) & 0x00FF;
+            A = X = Y = 0;
+            TotalCycles = 0u;
+            RunEnd = 0u;
         }
 
-        inline Word FetchAddressZeroPageY(uint32 & cycles, Memory const & memory)
+        EMU_FORCEINLINE Byte FetchByte(uint32 & cycles, Memory const & memory)
         {
+            auto value = memory.ReadByte(PC);
+            ++PC;
             --cycles;
-            return (FetchAddressZeroPage(cycles, memory) + Y) & 0x00FF;
+            return value;
         }
 
         inline Byte ReadByte(uint32 & cycles, Word const address, Memory const & memory) const
@@ -161,8 +184,63 @@ namespace Emu
 
         inline void LoadRegisterSetStatus(Byte reg)
         {
+#if EMU_LAZY_FLAGS
+            FlagResult = reg;
+            FlagsPending = 1;
+#else
             StatusFlags.ZeroFlag = reg == 0;
             StatusFlags.NegativeFlag = (reg & 1 << 7) > 0;
+#endif
+        }
+
+        // Writes pending Zero and Negative flags back into Status
+        inline void SyncStatus()
+        {
+#if EMU_LAZY_FLAGS
+            if (FlagsPending)
+            {
+                Status = (Status & 0b01111101) | (FlagResult == 0 ? 0b00000010 : 0) | (FlagResult & 0b10000000);
+                FlagsPending = 0;
+            }
+#endif
+        }
+
+        inline Byte ObservedStatus()
+        {
+            SyncStatus();
+            return Status;
+        }
+
+        // As ObservedStatus without writing pending flags back, for watching a running CPU
+        inline Byte CurrentStatus() const
+        {
+#if EMU_LAZY_FLAGS
+            if (FlagsPending)
+                return (Status & 0b01111101) | (FlagResult == 0 ? 0b00000010 : 0) | (FlagResult & 0b10000000);
+#endif
+            return Status;
+        }
+
+        // Replaces the whole status, pending flags would otherwise overwrite Zero and Negative
+        inline void SetStatus(Byte const status)
+        {
+            Status = status;
+#if EMU_LAZY_FLAGS
+            FlagsPending = 0;
+#endif
+        }
+
+        // Every path back to the host leaves Status up to date
+        inline uint32 Leave(uint32 cyclesUsed)
+        {
+            SyncStatus();
+            return cyclesUsed;
+        }
+
+        // Cycles left in a run's budget, negative once the last instruction ran past it
+        static inline bool HasCycles(uint32 const cycles)
+        {
+            return static_cast<int32>(cycles) > 0;
         }
 
         inline Word StackPointerAddress() const
@@ -280,6 +358,7 @@ namespace Emu
         static constexpr Byte INS_PLA       = 0x68;
         static constexpr Byte INS_PLP       = 0x28;
 
+        static constexpr Byte INS_RTI       = 0x40;
         static constexpr Byte INS_RTS       = 0x60;
 
         static constexpr Byte INS_STA_ZP    = 0x85;
@@ -302,155 +381,625 @@ namespace Emu
         static constexpr Byte INS_TSA       = 0x8A;
         static constexpr Byte INS_TXS       = 0x9A;
 
+        static constexpr OpCodeDescription OpCodeDescriptions[] = {
+            { INS_AND_IM,   Operation::AND, AddressingMode::Immediate   },
+            { INS_AND_ZP,   Operation::AND, AddressingMode::ZeroPage    },
+            { INS_AND_ZPX,  Operation::AND, AddressingMode::ZeroPageX   },
+            { INS_AND_ABS,  Operation::AND, AddressingMode::Absolute    },
+            { INS_AND_ABSX, Operation::AND, AddressingMode::AbsoluteX   },
+            { INS_AND_ABSY, Operation::AND, AddressingMode::AbsoluteY   },
+            { INS_AND_INDX, Operation::AND, AddressingMode::IndirectX   },
+            { INS_AND_INDY, Operation::AND, AddressingMode::IndirectY   },
+
+            { INS_BIT_ZP,   Operation::BIT, AddressingMode::ZeroPage    },
+            { INS_BIT_ABS,  Operation::BIT, AddressingMode::Absolute    },
+
+            { INS_EOR_IM,   Operation::EOR, AddressingMode::Immediate   },
+            { INS_EOR_ZP,   Operation::EOR, AddressingMode::ZeroPage    },
+            { INS_EOR_ZPX,  Operation::EOR, AddressingMode::ZeroPageX   },
+            { INS_EOR_ABS,  Operation::EOR, AddressingMode::Absolute    },
+            { INS_EOR_ABSX, Operation::EOR, AddressingMode::AbsoluteX   },
+            { INS_EOR_ABSY, Operation::EOR, AddressingMode::AbsoluteY   },
+            { INS_EOR_INDX, Operation::EOR, AddressingMode::IndirectX   },
+            { INS_EOR_INDY, Operation::EOR, AddressingMode::IndirectY   },
+
+            { INS_JMP_ABS,  Operation::JMP, AddressingMode::Absolute    },
+            { INS_JMP_IND,  Operation::JMP, AddressingMode::Indirect    },
+
+            { INS_JSR,      Operation::JSR, AddressingMode::Absolute    },
+
+            { INS_LDA_IM,   Operation::LDA, AddressingMode::Immediate   },
+            { INS_LDA_ZP,   Operation::LDA, AddressingMode::ZeroPage    },
+            { INS_LDA_ZPX,  Operation::LDA, AddressingMode::ZeroPageX   },
+            { INS_LDA_ABS,  Operation::LDA, AddressingMode::Absolute    },
+            { INS_LDA_ABSX, Operation::LDA, AddressingMode::AbsoluteX   },
+            { INS_LDA_ABSY, Operation::LDA, AddressingMode::AbsoluteY   },
+            { INS_LDA_INDX, Operation::LDA, AddressingMode::IndirectX   },
+            { INS_LDA_INDY, Operation::LDA, AddressingMode::IndirectY   },
+
+            { INS_LDX_IM,   Operation::LDX, AddressingMode::Immediate   },
+            { INS_LDX_ZP,   Operation::LDX, AddressingMode::ZeroPage    },
+            { INS_LDX_ZPY,  Operation::LDX, AddressingMode::ZeroPageY   },
+            { INS_LDX_ABS,  Operation::LDX, AddressingMode::Absolute    },
+            { INS_LDX_ABSY, Operation::LDX, AddressingMode::AbsoluteY   },
+
+            { INS_LDY_IM,   Operation::LDY, AddressingMode::Immediate   },
+            { INS_LDY_ZP,   Operation::LDY, AddressingMode::ZeroPage    },
+            { INS_LDY_ZPX,  Operation::LDY, AddressingMode::ZeroPageX   },
+            { INS_LDY_ABS,  Operation::LDY, AddressingMode::Absolute    },
+            { INS_LDY_ABSX, Operation::LDY, AddressingMode::AbsoluteX   },
+
+            { INS_ORA_IM,   Operation::ORA, AddressingMode::Immediate   },
+            { INS_ORA_ZP,   Operation::ORA, AddressingMode::ZeroPage    },
+            { INS_ORA_ZPX,  Operation::ORA, AddressingMode::ZeroPageX   },
+            { INS_ORA_ABS,  Operation::ORA, AddressingMode::Absolute    },
+            { INS_ORA_ABSX, Operation::ORA, AddressingMode::AbsoluteX   },
+            { INS_ORA_ABSY, Operation::ORA, AddressingMode::AbsoluteY   },
+            { INS_ORA_INDX, Operation::ORA, AddressingMode::IndirectX   },
+            { INS_ORA_INDY, Operation::ORA, AddressingMode::IndirectY   },
+
+            { INS_PHA,      Operation::PHA, AddressingMode::Implied     },
+            { INS_PHP,      Operation::PHP, AddressingMode::Implied     },
+            { INS_PLA,      Operation::PLA, AddressingMode::Implied     },
+            { INS_PLP,      Operation::PLP, AddressingMode::Implied     },
+
+            { INS_RTI,      Operation::RTI, AddressingMode::Implied     },
+            { INS_RTS,      Operation::RTS, AddressingMode::Implied     },
+
+            { INS_STA_ZP,   Operation::STA, AddressingMode::ZeroPage    },
+            { INS_STA_ZPX,  Operation::STA, AddressingMode::ZeroPageX   },
+            { INS_STA_ABS,  Operation::STA, AddressingMode::Absolute    },
+            { INS_STA_ABSX, Operation::STA, AddressingMode::AbsoluteX   },
+            { INS_STA_ABSY, Operation::STA, AddressingMode::AbsoluteY   },
+            { INS_STA_INDX, Operation::STA, AddressingMode::IndirectX   },
+            { INS_STA_INDY, Operation::STA, AddressingMode::IndirectY   },
+
+            { INS_STX_ZP,   Operation::STX, AddressingMode::ZeroPage    },
+            { INS_STX_ZPY,  Operation::STX, AddressingMode::ZeroPageY   },
+            { INS_STX_ABS,  Operation::STX, AddressingMode::Absolute    },
+
+            { INS_STY_ZP,   Operation::STY, AddressingMode::ZeroPage    },
+            { INS_STY_ZPX,  Operation::STY, AddressingMode::ZeroPageX   },
+            { INS_STY_ABS,  Operation::STY, AddressingMode::Absolute    },
+
+            { INS_TSA,      Operation::TSA, AddressingMode::Implied     },
+            { INS_TSX,      Operation::TSX, AddressingMode::Implied     },
+
+            { INS_TXS,      Operation::TXS, AddressingMode::Implied     },
+        };
+
+        static constexpr auto OpCodeTable = MakeOpCodeTable(OpCodeDescriptions);
+        static constexpr uint32 MAX_INSTRUCTION_CYCLES = MaxInstructionCycles(OpCodeTable);
+
+        // Takes and returns the remaining cycles so the count can stay in a register
+        using InstructionHandler = uint32 (*)(CPU & cpu, uint32 cycles, Memory & memory);
+
+        // Address from a decoded operand, only the page crossing penalty is charged as base
+        // cycles are taken up front from the opcode table
+        template <AddressingMode Mode, bool PageCrossPenalty>
+        inline Word ResolveAddress(uint32 & cycles, Memory const & memory, Word const operand) const
+        {
+            if constexpr (Mode == AddressingMode::ZeroPage || Mode == AddressingMode::Absolute)
+                return operand;
+            else if constexpr (Mode == AddressingMode::ZeroPageX)
+                return (operand + X) & 0x00FF;
+            else if constexpr (Mode == AddressingMode::ZeroPageY)
+                return (operand + Y) & 0x00FF;
+            else if constexpr (Mode == AddressingMode::AbsoluteX)
+            {
+                cycles -= PageCrossPenalty && ((operand & 0xFF) + X) > 0xFF ? 1 : 0;
+                return operand + X;
+            }
+            else if constexpr (Mode == AddressingMode::AbsoluteY)
+            {
+                cycles -= PageCrossPenalty && ((operand & 0xFF) + Y) > 0xFF ? 1 : 0;
+                return operand + Y;
+            }
+            else if constexpr (Mode == AddressingMode::Indirect)
+                return memory.ReadWord(operand);
+            else if constexpr (Mode == AddressingMode::IndirectX)
+                return memory.ReadWord(static_cast<Word>(operand + X));
+            else if constexpr (Mode == AddressingMode::IndirectY)
+            {
+                Word address = memory.ReadWord(operand);
+                cycles -= PageCrossPenalty && ((address & 0xFF) + Y) > 0xFF ? 1 : 0;
+                return address + Y;
+            }
+            else
+                static_assert(Mode != Mode, "Addressing mode has no operand address");
+        }
+
+        template <AddressingMode Mode, bool PageCrossPenalty>
+        inline Byte ResolveOperand(uint32 & cycles, Memory const & memory, Word const operand) const
+        {
+            if constexpr (Mode == AddressingMode::Immediate)
+                return static_cast<Byte>(operand);
+            else
+                return memory.ReadByte(ResolveAddress<Mode, PageCrossPenalty>(cycles, memory, operand));
+        }
+
+        // https://www.youtube.com/watch?v=tDlcpoNNQEo&ab_channel=Teddybearearth
+        template <Byte CPU::* Register>
+        inline void LoadRegister(Byte const value)
+        { LoadRegisterSetStatus(this->*Register = value); }
+
+        template <Byte CPU::* Register>
+        inline void StoreRegister(uint32 & cycles, Word const address, Memory & memory)
+        { WriteByte(cycles, address, this->*Register, memory); }
+
+        inline void And(Byte const value)
+        { LoadRegisterSetStatus(A &= value); }
+
+        inline void Bit(Byte const value)
+        {
+            // Overwrites Zero, Overflow and Negative so any pending flags are dropped
+            Status = (value & 0b11000000) | (Status & 0b00111101) | ((A & value) == 0 ? 0b00000010 : 0);
+#if EMU_LAZY_FLAGS
+            FlagsPending = 0;
+#endif
+        }
+
+        inline void Or(Byte const value)
+        { LoadRegisterSetStatus(A |= value); }
+
+        inline void Xor(Byte const value)
+        { LoadRegisterSetStatus(A ^= value); }
+
+        inline void JumpToSubroutine(uint32 & cycles, Word const routineAddress, Memory & memory)
+        {
+            PushWordToStack(cycles, PC - 1, memory);
+            PC = routineAddress;
+            --cycles;
+        }
+
+        static constexpr Word NMI_VECTOR = 0xFFFA;
+        static constexpr Word IRQ_VECTOR = 0xFFFE;
+        static constexpr uint32 INTERRUPT_CYCLES = 7u;
+
+        // Pushes PC and Status with Break clear, disables IRQs and continues at the handler the
+        // vector points to. RTI returns to the interrupted instruction. Returns the cycles taken
+        inline uint32 Interrupt(Word const vector, Memory & memory)
+        {
+            uint32 scratch = 0u;
+            PushWordToStack(scratch, PC, memory);
+            PushByteToStack(scratch, (ObservedStatus() & 0b11101111) | 0b00100000, memory);
+            StatusFlags.IRQDisableFlag = 1;
+            PC = memory.ReadWord(vector);
+            TotalCycles += INTERRUPT_CYCLES;
+            return INTERRUPT_CYCLES;
+        }
+
+        // Body shared by every back end, base cycles have already been taken and PC points past
+        // the instruction. Helpers with their own cycle accounting get a scratch counter
+        template <Operation Op, AddressingMode Mode>
+        EMU_FORCEINLINE static uint32 ExecuteOperation(CPU & cpu, uint32 cycles, Memory & memory, Word const operand)
+        {
+            constexpr bool Penalty = HasPageCrossPenalty(Op, Mode);
+            uint32 scratch = 0u;
+
+            if constexpr (Op == Operation::AND)         cpu.And(cpu.ResolveOperand<Mode, Penalty>(cycles, memory, operand));
+            else if constexpr (Op == Operation::BIT)    cpu.Bit(cpu.ResolveOperand<Mode, Penalty>(cycles, memory, operand));
+            else if constexpr (Op == Operation::EOR)    cpu.Xor(cpu.ResolveOperand<Mode, Penalty>(cycles, memory, operand));
+            else if constexpr (Op == Operation::JMP)    cpu.PC = cpu.ResolveAddress<Mode, Penalty>(cycles, memory, operand);
+            else if constexpr (Op == Operation::JSR)    cpu.JumpToSubroutine(scratch, operand, memory);
+            else if constexpr (Op == Operation::LDA)    cpu.LoadRegister<&CPU::A>(cpu.ResolveOperand<Mode, Penalty>(cycles, memory, operand));
+            else if constexpr (Op == Operation::LDX)    cpu.LoadRegister<&CPU::X>(cpu.ResolveOperand<Mode, Penalty>(cycles, memory, operand));
+            else if constexpr (Op == Operation::LDY)    cpu.LoadRegister<&CPU::Y>(cpu.ResolveOperand<Mode, Penalty>(cycles, memory, operand));
+            else if constexpr (Op == Operation::ORA)    cpu.Or(cpu.ResolveOperand<Mode, Penalty>(cycles, memory, operand));
+            else if constexpr (Op == Operation::PHA)    cpu.PushByteToStack(scratch, cpu.A, memory);
+            else if constexpr (Op == Operation::PHP)    cpu.PushByteToStack(scratch, cpu.ObservedStatus(), memory);
+            else if constexpr (Op == Operation::PLA)    cpu.LoadRegisterSetStatus(cpu.A = cpu.PopByteFromStack(scratch, memory));
+            else if constexpr (Op == Operation::PLP)    { cpu.Status = cpu.PopByteFromStack(scratch, memory); cpu.LoadRegisterSetStatus(cpu.A); }
+            else if constexpr (Op == Operation::RTI)    { cpu.SetStatus(cpu.PopByteFromStack(scratch, memory)); cpu.PC = cpu.PopWordFromStack(scratch, memory); }
+            else if constexpr (Op == Operation::RTS)    cpu.PC = cpu.PopWordFromStack(scratch, memory) + 1;
+            else if constexpr (Op == Operation::STA)    memory.WriteByte(cpu.ResolveAddress<Mode, Penalty>(cycles, memory, operand), cpu.A);
+            else if constexpr (Op == Operation::STX)    memory.WriteByte(cpu.ResolveAddress<Mode, Penalty>(cycles, memory, operand), cpu.X);
+            else if constexpr (Op == Operation::STY)    memory.WriteByte(cpu.ResolveAddress<Mode, Penalty>(cycles, memory, operand), cpu.Y);
+            else if constexpr (Op == Operation::TSA)    cpu.LoadRegisterSetStatus(cpu.A = cpu.SP);
+            else if constexpr (Op == Operation::TSX)    cpu.LoadRegisterSetStatus(cpu.X = cpu.SP);
+            else if constexpr (Op == Operation::TXS)    cpu.SP = cpu.X;
+            else
+                static_assert(Op != Op, "Operation not implemented");
+
+            return cycles;
+        }
+
+        // One specialization per opcode, the dispatch loop has already fetched the opcode byte
+        // and taken its cycle
+        template <Operation Op, AddressingMode Mode>
+        EMU_FORCEINLINE static uint32 ExecuteInstruction(CPU & cpu, uint32 cycles, Memory & memory)
+        {
+            constexpr Byte Length = InstructionLength(Mode);
+            constexpr Byte Cycles = BaseCycles(Op, Mode);
+
+            Word operand = 0;
+            if constexpr (Length == 2)
+                operand = memory.ReadByte(cpu.PC);
+            else if constexpr (Length == 3)
+                operand = memory.ReadWord(cpu.PC);
+
+            cpu.PC += Length - 1;
+            return ExecuteOperation<Op, Mode>(cpu, cycles - (Cycles - 1u), memory, operand);
+        }
+
+        // Replays a pre-decoded instruction
+        template <Operation Op, AddressingMode Mode>
+        static uint32 ExecuteMicroOp(CPU & cpu, uint32 cycles, Memory & memory, MicroOp const & op)
+        {
+            cpu.PC += op.Length;
+            return ExecuteOperation<Op, Mode>(cpu, cycles - op.Cycles, memory, op.Operand);
+        }
+
+        static uint32 UnhandledInstruction(CPU & cpu, uint32 cycles, Memory & memory)
+        {
+            // Cycles left in the budget can be negative once the opcode fetch ran past it
+            auto cycle = cpu.RunEnd - static_cast<int64>(static_cast<int32>(cycles));
+            cpu.Trap({ cycle, static_cast<Word>(cpu.PC - 1), memory.ReadByte(static_cast<Word>(cpu.PC - 1)) });
+            return cycles;
+        }
+
+        // Sets the debug flag and passes the trap on, kept out of line as it is never hot
+        EMU_NOINLINE void Trap(TrapRecord const & trap)
+        {
+            DebugFlags.UnhandledInstruction = 1;
+            if (OnTrap != nullptr)
+                OnTrap(TrapContext, trap);
+        }
+
+        template <size_t ... Indices>
+        static constexpr std::array<InstructionHandler, 256> MakeDispatchTable(std::index_sequence<Indices...>)
+        {
+            std::array<InstructionHandler, 256> table{};
+
+            for (auto & handler : table)
+                handler = &UnhandledInstruction;
+
+            ((table[OpCodeDescriptions[Indices].OpCode] = &ExecuteInstruction<
+                OpCodeDescriptions[Indices].Op,
+                OpCodeDescriptions[Indices].Mode>), ...);
+
+            return table;
+        }
+
+        static uint32 UnhandledMicroOp(CPU & cpu, uint32 cycles, Memory & memory, MicroOp const & op)
+        {
+            cpu.PC += op.Length;
+            return UnhandledInstruction(cpu, cycles - op.Cycles, memory);
+        }
+
+        struct DecodeEntry
+        {
+            MicroOpHandler Handler;
+            Byte Length;
+            Byte Cycles;
+            bool PageCrossPenalty;
+            bool EndsBlock;
+        };
+
+        template <size_t ... Indices>
+        static constexpr std::array<DecodeEntry, 256> MakeDecodeTable(std::index_sequence<Indices...>)
+        {
+            std::array<DecodeEntry, 256> table{};
+
+            auto endsBlock = [](OpCodeInfo const & info)
+            { return !info.Implemented || info.Op == Operation::JMP || info.Op == Operation::JSR || info.Op == Operation::RTI || info.Op == Operation::RTS; };
+
+            for (size_t i = 0; i < table.size(); ++i)
+            {
+                auto const & info = OpCodeTable[i];
+                table[i] = { &UnhandledMicroOp, info.Length, info.Cycles, info.PageCrossPenalty, endsBlock(info) };
+            }
+
+            ((table[OpCodeDescriptions[Indices].OpCode].Handler =
+                &ExecuteMicroOp<OpCodeDescriptions[Indices].Op, OpCodeDescriptions[Indices].Mode>), ...);
+
+            return table;
+        }
+
+        DecodedBlock & DecodeBlock(BlockCache & cache, Memory & memory)
+        {
+            static constexpr auto DecodeTable = MakeDecodeTable(
+                std::make_index_sequence<std::size(OpCodeDescriptions)>{});
+
+            auto & block = cache.Slot(PC);
+            block.Address = PC;
+            block.Count = 0;
+            block.MaxCycles = 0;
+            block.ExecutionCount = 0;
+            block.Native = nullptr;
+
+            Word address = PC;
+            Word lastByte = PC;
+
+            while (block.Count < DecodedBlock::MAX_OPS)
+            {
+                auto opCode = memory.ReadByte(address);
+                auto const & entry = DecodeTable[opCode];
+                auto & op = block.Ops[block.Count++];
+
+                op.Handler = entry.Handler;
+                op.OpCode = opCode;
+                op.Length = entry.Length;
+                op.Cycles = entry.Cycles;
+
+                block.MaxCycles += entry.Cycles + (entry.PageCrossPenalty ? 1 : 0);
+
+                if (entry.Length == 2)
+                    op.Operand = memory.ReadByte(static_cast<Word>(address + 1));
+                else if (entry.Length == 3)
+                    op.Operand = memory.ReadByte(static_cast<Word>(address + 1))
+                        | memory.ReadByte(static_cast<Word>(address + 2)) << 8;
+
+                lastByte = address + entry.Length - 1;
+                address += entry.Length;
+
+                if (entry.EndsBlock || lastByte < block.Address)
+                    break;
+            }
+
+            block.FirstPage = static_cast<Byte>(block.Address / Memory::PAGE_SIZE);
+            block.LastPage = static_cast<Byte>(lastByte / Memory::PAGE_SIZE);
+
+            memory.MarkCodePage(block.FirstPage);
+            memory.MarkCodePage(block.LastPage);
+
+            block.FirstPageGeneration = memory.CodePageGenerations[block.FirstPage];
+            block.LastPageGeneration = memory.CodePageGenerations[block.LastPage];
+
+            return block;
+        }
+
+        // Runs from the decoded block cache, blocks are rebuilt when a write lands on their pages
+        uint32 Execute(uint32 cycles, Memory & memory, BlockCache & cache)
+        {
+            return Budgeted(cycles, [&](uint32 budget) { return RunBlocks(budget, memory, cache); });
+        }
+
+        uint32 RunBlocks(uint32 budget, Memory & memory, BlockCache & cache)
+        {
+            uint32 cycles = budget;
+
+            while (HasCycles(cycles))
+            {
+                auto * found = cache.Find(PC, memory);
+                auto & block = found ? *found : DecodeBlock(cache, memory);
+
+                if (!ReplayBlock(block, cycles, memory))
+                    break;
+            }
+
+            return Leave(budget - cycles);
+        }
+
+        // Defined in Recompiler.hpp
+        uint32 Execute(uint32 cycles, Memory & memory, Recompiler & recompiler);
+        uint32 RunRecompiled(uint32 budget, Memory & memory, Recompiler & recompiler);
+
+        // Defined in Scheduler.hpp
+        uint32 Execute(uint32 cycles, Memory & memory, Scheduler & scheduler);
+
+        template <typename TProfiler>
+        uint32 ExecuteProfiled(uint32 cycles, Memory & memory, Scheduler & scheduler, TProfiler & profiler);
+
+        // Returns false when an unhandled instruction stopped execution
+        inline bool ReplayBlock(DecodedBlock const & block, uint32 & cycles, Memory & memory)
+        {
+            auto codeGeneration = memory.CodeGeneration;
+
+            auto const * op = block.Ops;
+            auto const * end = block.Ops + block.Count;
+
+            for (; op != end; ++op)
+            {
+                cycles = op->Handler(*this, cycles, memory, *op);
+
+                // Leave the block when out of cycles or when a write hit cached code
+                if (!HasCycles(cycles) || memory.CodeGeneration != codeGeneration)
+                    return true;
+            }
+
+            // Unhandled instructions always end their block
+            return end[-1].Handler != &UnhandledMicroOp;
+        }
+
+        // Runs for cycles, the last instruction can run past them which sets CycleOverflow.
+        // Returns the cycles used
         uint32 Execute(uint32 cycles, Memory & memory)
         {
-            // https://www.youtube.com/watch?v=tDlcpoNNQEo&ab_channel=Teddybearearth
-            auto LoadRegister = [&cycles, &memory, this](Byte & reg, Word const & address)
-            { LoadRegisterSetStatus(reg = ReadByte(cycles, address, memory)); };
+            return static_cast<uint32>(ExecuteUntil(TotalCycles + cycles, memory));
+        }
+
+        // Runs until TotalCycles reaches target, as Execute but for any length of run
+        uint64 ExecuteUntil(uint64 target, Memory & memory)
+        {
+            auto start = TotalCycles;
+            RunUntil(target, [&](uint32 budget) { return Run(budget, memory); });
+
+            if (TotalCycles > target)
+                DebugFlags.CycleOverflow = 1;
+
+            return TotalCycles - start;
+        }
+
+        // Never runs past target, stops at the last instruction boundary before it instead.
+        // Whatever is left over is picked up by the next run
+        uint64 ExecuteUntilPrecise(uint64 target, Memory & memory)
+        {
+            auto start = TotalCycles;
+            auto run = [&](uint32 budget) { return Run(budget, memory); };
+
+            // Any instruction started this far back ends by target
+            if (target > TotalCycles + MAX_INSTRUCTION_CYCLES && !RunUntil(target - (MAX_INSTRUCTION_CYCLES - 1u), run))
+                return TotalCycles - start;
+
+            while (TotalCycles < target && NextInstructionCycles(memory) <= target - TotalCycles)
+            {
+                auto implemented = OpCodeTable[memory.ReadByte(PC)].Implemented;
+
+                // A budget of one cycle runs one instruction
+                RunUntil(TotalCycles + 1u, run);
+
+                if (!implemented)
+                    break;
+            }
+
+            return TotalCycles - start;
+        }
+
+        // Cycles the instruction at PC will take including any page crossing, without running it
+        uint32 NextInstructionCycles(Memory const & memory) const
+        {
+            auto const & info = OpCodeTable[memory.ReadByte(PC)];
+            if (!info.PageCrossPenalty)
+                return info.Cycles;
+
+            Word operand = memory.ReadByte(static_cast<Word>(PC + 1));
+            Word low = 0;
+
+            if (info.Mode == AddressingMode::AbsoluteX)
+                low = operand + X;
+            else if (info.Mode == AddressingMode::AbsoluteY)
+                low = operand + Y;
+            else if (info.Mode == AddressingMode::IndirectY)
+                low = (memory.ReadWord(operand) & 0xFF) + Y;
+
+            return info.Cycles + (low > 0xFF ? 1u : 0u);
+        }
+
+        // Splits a run into budgets the countdown can hold and keeps TotalCycles. run(budget)
+        // returns the cycles it used, which is less than budget only when an unhandled instruction
+        // stopped it. False when that happened
+        template <typename TRun>
+        bool RunUntil(uint64 target, TRun && run)
+        {
+            while (TotalCycles < target)
+            {
+                auto budget = static_cast<uint32>(std::min<uint64>(target - TotalCycles, MAX_BUDGET));
+                RunEnd = TotalCycles + budget;
+                auto used = run(budget);
+                TotalCycles += used;
+
+                if (used < budget)
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Execute over a single back end
+        template <typename TRun>
+        uint32 Budgeted(uint32 cycles, TRun && run)
+        {
+            auto start = TotalCycles;
+            auto target = start + cycles;
+            RunUntil(target, run);
 
-            auto StoreRegister = [&cycles, &memory, this](Byte & reg, Word const & address)
-            { WriteByte(cycles, address, reg, memory); };
+            if (TotalCycles > target)
+                DebugFlags.CycleOverflow = 1;
 
-            auto And = [&cycles, &memory, this](Word const & address)
-            { LoadRegisterSetStatus(A &= ReadByte(cycles, address, memory)); };
+            return static_cast<uint32>(TotalCycles - start);
+        }
 
-            auto Bit = [&cycles, &memory, this](Word const & address)
-            { 
-                auto value = ReadByte(cycles, address, memory); 
-                StatusFlags.ZeroFlag = (A & value) == 0;
-                Status = (value & 0b11000000) | (Status & 0b00111111);
-                //StatusFlags.OverflowFlag = (value & 1 << 6) > 0;
-                //StatusFlags.NegativeFlag = (value & 1 << 7) > 0;
-            };
+        uint32 Run(uint32 budget, Memory & memory)
+        {
+#if EMU_THREADED_DISPATCH
+            return RunThreaded(budget, memory);
+#else
+            return RunTable(budget, memory);
+#endif
+        }
 
-            auto Or = [&cycles, &memory, this](Word const & address)
-            { LoadRegisterSetStatus(A |= ReadByte(cycles, address, memory)); };
+        uint32 ExecuteTable(uint32 cycles, Memory & memory)
+        {
+            return Budgeted(cycles, [&](uint32 budget) { return RunTable(budget, memory); });
+        }
+
+        uint32 RunTable(uint32 budget, Memory & memory)
+        {
+            NoProfiler profiler;
+            return RunTable(budget, memory, profiler);
+        }
+
+        // Table dispatch through the profiler on the same loop, tells it when an instruction is
+        // about to run and hands it every opcode with the cycles the instruction took
+        template <typename TProfiler>
+        uint32 ExecuteProfiled(uint32 cycles, Memory & memory, TProfiler & profiler)
+        {
+            return Budgeted(cycles, [&](uint32 budget) { return RunTable(budget, memory, profiler); });
+        }
 
-            auto Xor = [&cycles, &memory, this](Word const & address)
-            { LoadRegisterSetStatus(A ^= ReadByte(cycles, address, memory)); };
+        template <typename TProfiler>
+        uint32 RunTable(uint32 budget, Memory & memory, TProfiler & profiler)
+        {
+            static constexpr auto DispatchTable = MakeDispatchTable(
+                std::make_index_sequence<std::size(OpCodeDescriptions)>{});
 
-            uint32 startCycles = cycles;
+            uint32 cycles = budget;
 
-            while (cycles > 0)
+            while (HasCycles(cycles))
             {
-                if (cycles > startCycles)
-                {
-                    // Detect cycles overflow
-                    DebugFlags.CycleOverflow = 1;
-                    return startCycles - cycles;
-                }
-
-                auto instruction = FetchByte(cycles, memory);
-
-                switch (instruction)
-                {
-                case INS_AND_IM:    And(FetchAddressImmediate(cycles, memory));                             break;
-                case INS_AND_ZP:    And(FetchAddressZeroPage(cycles, memory));                              break;
-                case INS_AND_ZPX:   And(FetchAddressZeroPageX(cycles, memory));                             break;
-                case INS_AND_ABS:   And(FetchAddressAbsolute(cycles, memory));                              break;
-                case INS_AND_ABSX:  And(FetchAddressAbsoluteX(cycles, memory));                             break;
-                case INS_AND_ABSY:  And(FetchAddressAbsoluteY(cycles, memory));                             break;
-                case INS_AND_INDX:  And(FetchAddressIndirectX(cycles, memory));                             break;
-                case INS_AND_INDY:  And(FetchAddressIndirectY(cycles, memory));                             break;
-
-                case INS_BIT_ZP:    Bit(FetchAddressZeroPage(cycles, memory));                              break;
-                case INS_BIT_ABS:   Bit(FetchAddressAbsolute(cycles, memory));                              break;
-
-                case INS_EOR_IM:    Xor(FetchAddressImmediate(cycles, memory));                             break;
-                case INS_EOR_ZP:    Xor(FetchAddressZeroPage(cycles, memory));                              break;
-                case INS_EOR_ZPX:   Xor(FetchAddressZeroPageX(cycles, memory));                             break;
-                case INS_EOR_ABS:   Xor(FetchAddressAbsolute(cycles, memory));                              break;
-                case INS_EOR_ABSX:  Xor(FetchAddressAbsoluteX(cycles, memory));                             break;
-                case INS_EOR_ABSY:  Xor(FetchAddressAbsoluteY(cycles, memory));                             break;
-                case INS_EOR_INDX:  Xor(FetchAddressIndirectX(cycles, memory));                             break;
-                case INS_EOR_INDY:  Xor(FetchAddressIndirectY(cycles, memory));                             break;
-
-                case INS_JMP_ABS:   PC = FetchAddressAbsolute(cycles, memory);                              break;
-                case INS_JMP_IND:   PC = ReadWord(cycles, FetchAddressAbsolute(cycles, memory), memory);    break;
-
-                case INS_JSR:
-                {
-                    auto routineAddress = FetchAddressAbsolute(cycles, memory);
-                    PushWordToStack(cycles, PC - 1, memory);
-                    PC = routineAddress;
-                    --cycles;
-                } break;
-
-                case INS_LDA_IM:    LoadRegister(A, FetchAddressImmediate(cycles, memory));                 break;
-                case INS_LDA_ZP:    LoadRegister(A, FetchAddressZeroPage(cycles, memory));                  break;
-                case INS_LDA_ZPX:   LoadRegister(A, FetchAddressZeroPageX(cycles, memory));                 break;
-                case INS_LDA_ABS:   LoadRegister(A, FetchAddressAbsolute(cycles, memory));                  break;
-                case INS_LDA_ABSX:  LoadRegister(A, FetchAddressAbsoluteX(cycles, memory));                 break;
-                case INS_LDA_ABSY:  LoadRegister(A, FetchAddressAbsoluteY(cycles, memory));                 break;
-                case INS_LDA_INDX:  LoadRegister(A, FetchAddressIndirectX(cycles, memory));                 break;
-                case INS_LDA_INDY:  LoadRegister(A, FetchAddressIndirectY(cycles, memory));                 break;
-
-                case INS_LDX_IM:    LoadRegister(X, FetchAddressImmediate(cycles, memory));                 break;
-                case INS_LDX_ZP:    LoadRegister(X, FetchAddressZeroPage(cycles, memory));                  break;
-                case INS_LDX_ZPY:   LoadRegister(X, FetchAddressZeroPageY(cycles, memory));                 break;
-                case INS_LDX_ABS:   LoadRegister(X, FetchAddressAbsolute(cycles, memory));                  break;
-                case INS_LDX_ABSY:  LoadRegister(X, FetchAddressAbsoluteY(cycles, memory));                 break;
-
-                case INS_LDY_IM:    LoadRegister(Y, FetchAddressImmediate(cycles, memory));                 break;
-                case INS_LDY_ZP:    LoadRegister(Y, FetchAddressZeroPage(cycles, memory));                  break;
-                case INS_LDY_ZPX:   LoadRegister(Y, FetchAddressZeroPageX(cycles, memory));                 break;
-                case INS_LDY_ABS:   LoadRegister(Y, FetchAddressAbsolute(cycles, memory));                  break;
-                case INS_LDY_ABSX:  LoadRegister(Y, FetchAddressAbsoluteX(cycles, memory));                 break;
-
-                case INS_ORA_IM:    Or(FetchAddressImmediate(cycles, memory));                              break;
-                case INS_ORA_ZP:    Or(FetchAddressZeroPage(cycles, memory));                               break;
-                case INS_ORA_ZPX:   Or(FetchAddressZeroPageX(cycles, memory));                              break;
-                case INS_ORA_ABS:   Or(FetchAddressAbsolute(cycles, memory));                               break;
-                case INS_ORA_ABSX:  Or(FetchAddressAbsoluteX(cycles, memory));                              break;
-                case INS_ORA_ABSY:  Or(FetchAddressAbsoluteY(cycles, memory));                              break;
-                case INS_ORA_INDX:  Or(FetchAddressIndirectX(cycles, memory));                              break;
-                case INS_ORA_INDY:  Or(FetchAddressIndirectY(cycles, memory));                              break;
-
-                case INS_PHA:       PushByteToStack(--cycles, A, memory);                                   break;
-                case INS_PHP:       PushByteToStack(--cycles, Status, memory);                              break;
-                case INS_PLA:       A = PopByteFromStack(cycles, memory); LoadRegisterSetStatus(A);         break;
-                case INS_PLP:       Status = PopByteFromStack(cycles, memory); LoadRegisterSetStatus(A);    break;
-
-                case INS_RTS:       PC = PopWordFromStack(cycles, memory) + 1;                              break;
-
-                case INS_STA_ZP:    StoreRegister(A, FetchAddressZeroPage(cycles, memory));                 break;
-                case INS_STA_ZPX:   StoreRegister(A, FetchAddressZeroPageX(cycles, memory));                break;
-                case INS_STA_ABS:   StoreRegister(A, FetchAddressAbsolute(cycles, memory));                 break;
-                case INS_STA_ABSX:  StoreRegister(A, FetchAddressAbsoluteX(cycles, memory, true));          break;
-                case INS_STA_ABSY:  StoreRegister(A, FetchAddressAbsoluteY(cycles, memory, true));          break;
-                case INS_STA_INDX:  StoreRegister(A, FetchAddressIndirectX(cycles, memory));                break;
-                case INS_STA_INDY:  StoreRegister(A, FetchAddressIndirectY(cycles, memory, true));          break;
-
-                case INS_STX_ZP:    StoreRegister(X, FetchAddressZeroPage(cycles, memory));                 break;
-                case INS_STX_ZPY:   StoreRegister(X, FetchAddressZeroPageY(cycles, memory));                break;
-                case INS_STX_ABS:   StoreRegister(X, FetchAddressAbsolute(cycles, memory));                 break;
-
-                case INS_STY_ZP:    StoreRegister(Y, FetchAddressZeroPage(cycles, memory));                 break;
-                case INS_STY_ZPX:   StoreRegister(Y, FetchAddressZeroPageX(cycles, memory));                break;
-                case INS_STY_ABS:   StoreRegister(Y, FetchAddressAbsolute(cycles, memory));                 break;
-
-                case INS_TSA:       A = SP; --cycles; LoadRegisterSetStatus(A);                             break;
-                case INS_TSX:       X = SP; --cycles; LoadRegisterSetStatus(X);                             break;
-
-                case INS_TXS:       SP = X; --cycles;                                                       break;
-
-                default:
-                {
-                    DebugFlags.UnhandledInstruction = 1;
-                    fmt::print("Instruction not handled: {:x}\n", instruction);
-                    return startCycles - cycles;
-                }
-                }
+                profiler.BeforeInstruction();
+
+                auto start = cycles;
+                auto opCode = FetchByte(cycles, memory);
+                auto handler = DispatchTable[opCode];
+                cycles = handler(*this, cycles, memory);
+                profiler.Instruction(opCode, start - cycles);
+
+                if (handler == &UnhandledInstruction)
+                    break;
             }
 
-            return startCycles - cycles;
+            return Leave(budget - cycles);
         }
 
-        void DumpState()
+#if EMU_THREADED_DISPATCH
+        // Each handler ends with its own indirect jump to the next opcode's label rather than
+        // returning to a shared loop head, giving the branch predictor one site per opcode
+        uint32 ExecuteThreaded(uint32 cycles, Memory & memory)
         {
-            fmt::print("PC: {:x}\nSP: {:x}\nA:  {:x}\nX:  {:x}\nY:  {:x}", PC, SP, A, X, Y);
+            return Budgeted(cycles, [&](uint32 budget) { return RunThreaded(budget, memory); });
         }
 
+        uint32 RunThreaded(uint32 budget, Memory & memory)
+        {
+            static constexpr auto DispatchTable = MakeDispatchTable(
+                std::make_index_sequence<std::size(OpCodeDescriptions)>{});
+
+            #define EMU_THREADED_LABEL(OpCode) &&Op_##OpCode,
+            static void * const Labels[256] = { EMU_FOR_EACH_OPCODE(EMU_THREADED_LABEL) };
+            #undef EMU_THREADED_LABEL
+
+            uint32 cycles = budget;
+
+            #define EMU_THREADED_NEXT()                                         \
+                if (!HasCycles(cycles))                                         \
+                    return Leave(budget - cycles);                              \
+                goto * Labels[FetchByte(cycles, memory)];
+
+            // The table entry is a constant for each label so the handler is called directly and inlined
+            #define EMU_THREADED_HANDLER(OpCode)                                \
+                Op_##OpCode:                                                    \
+                    cycles = DispatchTable[OpCode](*this, cycles, memory);      \
+                    if constexpr (DispatchTable[OpCode] == &UnhandledInstruction) \
+                        return Leave(budget - cycles);                          \
+                    EMU_THREADED_NEXT()
+
+            EMU_THREADED_NEXT()
+            EMU_FOR_EACH_OPCODE(EMU_THREADED_HANDLER)
+
+            #undef EMU_THREADED_HANDLER
+            #undef EMU_THREADED_NEXT
+        }
+#endif
+
+        // Defined in Emu.cpp so formatting stays out of the headers the interpreter is built from
+        void DumpState();
+
+        // Registers followed by the profiler's table, defined in Profiler.hpp
+        template <typename TProfiler>
+        void DumpState(TProfiler const & profiler);
+
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Scheduler.hpp>
+#include <Emu/Symbols.hpp>
+
+
+namespace Emu
+{
+
+    // Guest routines by the path of calls they were reached through, with the cycles spent in
+    // each routine itself. Node 0 is the root, named after where the CPU was when profiling
+    // started. Written out as folded stacks for flamegraph tooling
+    struct CallTree
+    {
+        enum class FrameKind : Byte
+        {
+            Root,
+            Call,
+            Irq,
+            Nmi
+        };
+
+        struct Node
+        {
+            Word Routine;
+            FrameKind Kind;
+            uint32 Parent;
+            uint64 Cycles = 0u;         // Cycles in this routine itself, not its callees
+            uint64 Calls = 0u;          // Only counted by the exact profiler
+            uint32 LastChild = 0u;      // Checked before the hashed lookup, most sites call one routine
+        };
+
+        SymbolTable const * Symbols = nullptr;
+        std::vector<Node> Nodes;
+        std::unordered_map<uint64, uint32> Children;    // Parent, kind and routine to node
+
+        void Reset(Word root)
+        {
+            Nodes.clear();
+            Children.clear();
+            Nodes.push_back({ root, FrameKind::Root, 0u, 0u, 1u });
+        }
+
+        uint32 Child(uint32 parent, FrameKind kind, Word routine)
+        {
+            auto child = Nodes[parent].LastChild;
+            if (child != 0u && Nodes[child].Routine == routine && Nodes[child].Kind == kind)
+                return child;
+
+            auto key = static_cast<uint64>(parent) << 24 | static_cast<uint64>(kind) << 16 | routine;
+            auto [found, added] = Children.try_emplace(key, static_cast<uint32>(Nodes.size()));
+            if (added)
+                Nodes.push_back({ routine, kind, parent });
+
+            Nodes[parent].LastChild = found->second;
+            return found->second;
+        }
+
+        // "$C000" or its label, interrupt handlers are marked with the line that entered them
+        std::string Name(Node const & node) const
+        {
+            auto const * label = Symbols != nullptr ? Symbols->Find(node.Routine) : nullptr;
+            auto name = label != nullptr ? std::string(label) : fmt::format("${:04X}", node.Routine);
+
+            switch (node.Kind)
+            {
+            case FrameKind::Irq:    return "[IRQ] " + name;
+            case FrameKind::Nmi:    return "[NMI] " + name;
+            default:                return name;
+            }
+        }
+
+        // Root to node separated by semicolons
+        std::string Path(uint32 index) const
+        {
+            std::vector<uint32> path;
+            for (; index != 0u; index = Nodes[index].Parent)
+                path.push_back(index);
+
+            auto out = Name(Nodes[0]);
+            for (auto node = path.rbegin(); node != path.rend(); ++node)
+                out += ";" + Name(Nodes[*node]);
+
+            return out;
+        }
+
+        // Folded stacks, one "root;caller;callee cycles" line per call path that used any cycles,
+        // as read by flamegraph.pl and the tools that share its input format
+        std::string Folded() const
+        {
+            std::string out;
+            for (uint32 index = 0; index < Nodes.size(); ++index)
+            {
+                if (auto cycles = Nodes[index].Cycles; cycles != 0u)
+                    fmt::format_to(std::back_inserter(out), "{} {}\n", Path(index), cycles);
+            }
+            return out;
+        }
+
+        // Cycles for the routine wherever it was called from, callees included. Each node's own
+        // cycles are counted once however deeply the routine recurses above it
+        uint64 InclusiveCycles(Word routine) const
+        {
+            uint64 cycles = 0u;
+            for (uint32 index = 0; index < Nodes.size(); ++index)
+            {
+                if (IsWithin(index, routine))
+                    cycles += Nodes[index].Cycles;
+            }
+            return cycles;
+        }
+
+        bool IsWithin(uint32 index, Word routine) const
+        {
+            for (; index != 0u; index = Nodes[index].Parent)
+            {
+                if (Nodes[index].Routine == routine && Nodes[index].Kind == FrameKind::Call)
+                    return true;
+            }
+            return false;
+        }
+    };
+
+
+    // Samples the guest call stack from a scheduler event every Interval cycles on average, the
+    // default way to profile guest routines. Each sample charges the cycles since the one before
+    // to the routine the CPU is in, found by walking the hardware stack in page 1: a pair of
+    // bytes is a return address if the three bytes before the address it returns to are a JSR,
+    // whose operand names the routine called. Nothing runs per instruction, so with the
+    // scheduler's ExecuteProfiled the slices stay on the default back end and only interrupt
+    // entries are seen, to mark the frames they push.
+    //
+    // Data on the stack that happens to look like a return address after a JSR is taken for a
+    // call. Sample points are jittered so loops whose length divides the interval are not
+    // always caught at the same instruction. At the default interval it costs about 3% on mixed
+    // code and 5-6% on a loop where every other instruction is a JSR or RTS, against the same
+    // loop through the scheduler with nothing scheduled (BM_Scheduled_* in the benchmarks)
+    struct CallStackSampler
+    {
+        using FrameKind = CallTree::FrameKind;
+
+        static constexpr bool HOOKS_INSTRUCTIONS = false;
+        static constexpr uint32 DEFAULT_INTERVAL = 1000u;
+
+        // An interrupt entry still on the stack, Top is where it pushed the high byte of PC
+        struct InterruptFrame
+        {
+            Byte Top;
+            FrameKind Kind;
+            Word Routine;
+            Word Return;
+        };
+
+        struct Frame
+        {
+            FrameKind Kind;
+            Word Routine;
+        };
+
+        CPU const & Cpu;
+        Memory const & Ram;
+        Scheduler & Clock;
+        uint32 Interval;
+        CallTree Tree;
+
+        std::array<InterruptFrame, 8> Interrupts;
+        uint32 InterruptDepth = 0u;
+        uint64 EventId = 0u;
+        uint64 LastSample = 0u;
+        uint32 Seed = 12345u;
+
+        // Starts sampling at the scheduler's Now, the scheduler has to outlive the sampler
+        CallStackSampler(CPU const & cpu, Memory const & memory, Scheduler & scheduler, SymbolTable const * symbols = nullptr, uint32 interval = DEFAULT_INTERVAL)
+            : Cpu(cpu), Ram(memory), Clock(scheduler), Interval(std::max(interval, 2u))
+        {
+            Tree.Symbols = symbols;
+            Reset();
+        }
+
+        CallStackSampler(CallStackSampler const &) = delete;
+        CallStackSampler & operator=(CallStackSampler const &) = delete;
+
+        ~CallStackSampler()
+        {
+            Clock.Cancel(EventId);
+        }
+
+        void BeforeInstruction()
+        { }
+
+        void Instruction(Byte, uint32)
+        { }
+
+        // PC has already moved to the handler
+        void Interrupt(Word vector, uint32)
+        {
+            auto top = static_cast<Byte>(Cpu.SP + 3);
+            Prune(top);
+
+            if (InterruptDepth == Interrupts.size())
+                return;
+
+            auto kind = vector == CPU::NMI_VECTOR ? FrameKind::Nmi : FrameKind::Irq;
+            Interrupts[InterruptDepth++] = { top, kind, Cpu.PC, StackWord(top - 1u, Ram) };
+        }
+
+        void Reset()
+        {
+            Clock.Cancel(EventId);
+            Tree.Reset(Cpu.PC);
+            InterruptDepth = 0u;
+            LastSample = Clock.Now;
+            EventId = Clock.Schedule(Clock.Now + NextInterval(), &OnSample, this);
+        }
+
+        static void OnSample(void * context, Scheduler & scheduler, Memory &, uint64 deadline)
+        {
+            auto & sampler = *static_cast<CallStackSampler *>(context);
+            sampler.Sample(deadline - sampler.LastSample);
+            sampler.LastSample = deadline;
+            sampler.EventId = scheduler.Schedule(deadline + sampler.NextInterval(), &OnSample, context);
+        }
+
+        // Charges cycles to the call path the stack holds now
+        void Sample(uint64 cycles)
+        {
+            auto const & memory = Ram;
+            Prune(Cpu.SP);
+
+            std::array<Frame, 128> frames;
+            uint32 count = 0u;
+            uint32 interrupt = InterruptDepth;
+
+            // Innermost frame first, a return address needs both its bytes in the page
+            for (uint32 at = Cpu.SP + 1u; at < 0xFFu && count < frames.size(); )
+            {
+                while (interrupt != 0u && Interrupts[interrupt - 1u].Top < at + 2u)
+                    --interrupt;
+
+                if (interrupt != 0u && Interrupts[interrupt - 1u].Top == at + 2u)
+                {
+                    auto const & entry = Interrupts[--interrupt];
+                    if (StackWord(at + 1u, memory) == entry.Return)
+                    {
+                        frames[count++] = { entry.Kind, entry.Routine };
+                        at += 3u;
+                        continue;
+                    }
+                }
+
+                auto site = static_cast<Word>(StackWord(at, memory) - 2u);
+                if (memory.PeekByte(site) == CPU::INS_JSR)
+                {
+                    auto routine = static_cast<Word>(memory.PeekByte(site + 1u) | memory.PeekByte(static_cast<Word>(site + 2u)) << 8);
+                    frames[count++] = { FrameKind::Call, routine };
+                    at += 2u;
+                }
+                else
+                    ++at;
+            }
+
+            uint32 node = 0u;
+            while (count != 0u)
+            {
+                auto const & frame = frames[--count];
+                node = Tree.Child(node, frame.Kind, frame.Routine);
+            }
+
+            Tree.Nodes[node].Cycles += cycles;
+        }
+
+        // Drops interrupt frames the stack pointer has risen back over, their RTI has run
+        void Prune(Byte sp)
+        {
+            while (InterruptDepth != 0u && Interrupts[InterruptDepth - 1u].Top < sp + 3u)
+                --InterruptDepth;
+        }
+
+        uint32 NextInterval()
+        {
+            Seed = Seed * 1103515245u + 12345u;
+            return Interval / 2u + (Seed >> 16) % Interval;
+        }
+
+        static Word StackWord(uint32 at, Memory const & memory)
+        {
+            return static_cast<Word>(memory.PeekByte(0x0100u + at) | memory.PeekByte(0x0100u + ((at + 1u) & 0xFFu)) << 8);
+        }
+
+        std::string Folded() const
+        {
+            return Tree.Folded();
+        }
+
+        uint64 InclusiveCycles(Word routine) const
+        {
+            return Tree.InclusiveCycles(routine);
+        }
+    };
+
+
+    // Exact call stack tracking for CPU::ExecuteProfiled, opt in where sampling is too coarse.
+    // JSR and interrupt entry step into a child of the current node in the call tree, RTS and
+    // RTI step back out, and every instruction's cycles go to the node it ran in. Interrupt
+    // entry is charged to the handler. Instructions only add to a running count, it is settled
+    // on the current node when the call stack changes so the common case costs one add.
+    //
+    // Frames remember the stack pointer from before the call. Calls and returns first unwind
+    // every frame the stack pointer has risen back to, so guest code that drops a return address
+    // or returns through a pushed address does not leave the tree out of step with the stack.
+    // That bounds the depth by the size of the hardware stack.
+    //
+    // Against the same loop through NoProfiler (BM_Unprofiled_* in the benchmarks) it costs
+    // about 10-15% on mixed code and 20-25% on a loop where every other instruction is a JSR or
+    // RTS, which is why sampling is the default
+    struct CallStackProfiler
+    {
+        using FrameKind = CallTree::FrameKind;
+
+        struct Frame
+        {
+            uint32 Node;
+            Byte EntrySP;
+        };
+
+        CPU const & Cpu;
+        CallTree Tree;
+
+        std::array<Frame, 256> Stack;
+        uint32 Depth = 0u;
+        uint32 Current = 0u;
+        uint64 Elapsed = 0u;            // Cycles seen, those since Settled belong to Current
+        uint64 Settled = 0u;
+
+        explicit CallStackProfiler(CPU const & cpu, SymbolTable const * symbols = nullptr)
+            : Cpu(cpu)
+        {
+            Tree.Symbols = symbols;
+            Reset();
+        }
+
+        void BeforeInstruction()
+        { }
+
+        EMU_FORCEINLINE void Instruction(Byte opCode, uint32 cycles)
+        {
+            Elapsed += cycles;
+
+            if (opCode == CPU::INS_JSR)
+                Enter(FrameKind::Call, static_cast<Byte>(Cpu.SP + 2));
+            else if (opCode == CPU::INS_RTS || opCode == CPU::INS_RTI)
+                Return();
+        }
+
+        void Interrupt(Word vector, uint32 cycles)
+        {
+            Enter(vector == CPU::NMI_VECTOR ? FrameKind::Nmi : FrameKind::Irq, static_cast<Byte>(Cpu.SP + 3));
+            Tree.Nodes[Current].Cycles += cycles;
+            Elapsed += cycles;
+            Settled += cycles;
+        }
+
+        void Reset()
+        {
+            Tree.Reset(Cpu.PC);
+            Depth = 0u;
+            Current = 0u;
+            Elapsed = 0u;
+            Settled = 0u;
+        }
+
+        // PC has already moved to the routine
+        void Enter(FrameKind kind, Byte entrySP)
+        {
+            Settle();
+            Unwind(entrySP);
+
+            auto child = Tree.Child(Current, kind, Cpu.PC);
+
+            if (Depth < Stack.size())
+                Stack[Depth++] = { Current, entrySP };
+
+            Current = child;
+            ++Tree.Nodes[Current].Calls;
+        }
+
+        void Return()
+        {
+            Settle();
+            Unwind(Cpu.SP);
+        }
+
+        // Leaves every frame whose return address the stack pointer has moved past
+        void Unwind(Byte sp)
+        {
+            while (Depth != 0u && Stack[Depth - 1].EntrySP <= sp)
+                Current = Stack[--Depth].Node;
+        }
+
+        void Settle()
+        {
+            Tree.Nodes[Current].Cycles += Elapsed - Settled;
+            Settled = Elapsed;
+        }
+
+        std::string Folded()
+        {
+            Settle();
+            return Tree.Folded();
+        }
+
+        uint64 InclusiveCycles(Word routine)
+        {
+            Settle();
+            return Tree.InclusiveCycles(routine);
+        }
+    };
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+
+#include <fmt/format.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+#include <Emu/OpCodes.hpp>
+
+
+namespace Emu
+{
+
+    // Reads the same opcode table the interpreter is built from
+    struct Disassembler
+    {
+        // Operand as it would be written in assembly, e.g. "$4480,X"
+        static std::string FormatOperand(AddressingMode mode, Word operand)
+        {
+            switch (mode)
+            {
+            case AddressingMode::Immediate:     return fmt::format("#${:02X}", operand);
+            case AddressingMode::ZeroPage:      return fmt::format("${:02X}", operand);
+            case AddressingMode::ZeroPageX:     return fmt::format("${:02X},X", operand);
+            case AddressingMode::ZeroPageY:     return fmt::format("${:02X},Y", operand);
+            case AddressingMode::Absolute:      return fmt::format("${:04X}", operand);
+            case AddressingMode::AbsoluteX:     return fmt::format("${:04X},X", operand);
+            case AddressingMode::AbsoluteY:     return fmt::format("${:04X},Y", operand);
+            case AddressingMode::Indirect:      return fmt::format("(${:04X})", operand);
+            case AddressingMode::IndirectX:     return fmt::format("(${:02X},X)", operand);
+            case AddressingMode::IndirectY:     return fmt::format("(${:02X}),Y", operand);
+            default:                            return { };
+            }
+        }
+
+        // Instruction at address, e.g. "LDA $4480,X", unknown opcodes come out as data bytes
+        static std::string Disassemble(Memory const & memory, Word address)
+        {
+            auto opCode = memory.ReadByte(address);
+            auto const & info = CPU::OpCodeTable[opCode];
+
+            if (!info.Implemented)
+                return fmt::format(".byte ${:02X}", opCode);
+
+            Word operand = 0;
+            if (info.Length == 2)
+                operand = memory.ReadByte(static_cast<Word>(address + 1));
+            else if (info.Length == 3)
+                operand = memory.ReadByte(static_cast<Word>(address + 1))
+                    | memory.ReadByte(static_cast<Word>(address + 2)) << 8;
+
+            if (info.Mode == AddressingMode::Implied)
+                return Mnemonic(info.Op);
+
+            return fmt::format("{} {}", Mnemonic(info.Op), FormatOperand(info.Mode, operand));
+        }
+
+        // Listing line with the address and raw bytes, e.g. "0200  BD 80 44  LDA $4480,X"
+        static std::string Line(Memory const & memory, Word address, Word * next = nullptr)
+        {
+            auto length = CPU::OpCodeTable[memory.ReadByte(address)].Length;
+
+            std::string bytes;
+            for (Byte i = 0; i < 3; ++i)
+            {
+                if (i < length)
+                    bytes += fmt::format("{:02X} ", memory.ReadByte(static_cast<Word>(address + i)));
+                else
+                    bytes += "   ";
+            }
+
+            if (next != nullptr)
+                *next = static_cast<Word>(address + length);
+
+            return fmt::format("{:04X}  {} {}", address, bytes, Disassemble(memory, address));
+        }
+
+        static void Print(Memory const & memory, Word address, uint32 count)
+        {
+            for (uint32 i = 0; i < count; ++i)
+                fmt::print("{}\n", Line(memory, address, &address));
+        }
+    };
+
+}
\ No newline at end of file
@@ -1 +1,14 @@
-#include <Emu/CPU.hpp>
\ No newline at end of file
+#include <Emu/CPU.hpp>
+
+#include <fmt/format.h>
+
+
+namespace Emu
+{
+
+    void CPU::DumpState()
+    {
+        fmt::print("PC: {:x}\nSP: {:x}\nA:  {:x}\nX:  {:x}\nY:  {:x}", PC, SP, A, X, Y);
+    }
+
+}
\ No newline at end of file
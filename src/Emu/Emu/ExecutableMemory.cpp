@@ -0,0 +1,48 @@
+#include <Emu/ExecutableMemory.hpp>
+
+#if EMU_RECOMPILER
+    #if defined(_WIN32)
+        #define WIN32_LEAN_AND_MEAN
+        #define NOMINMAX
+        #include <windows.h>
+    #else
+        #include <sys/mman.h>
+    #endif
+#endif
+
+
+namespace Emu
+{
+
+    ExecutableMemory::ExecutableMemory(size_t capacity)
+    {
+#if EMU_RECOMPILER && defined(_WIN32)
+        auto * data = VirtualAlloc(nullptr, capacity, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+        if (data != nullptr)
+        {
+            Data = static_cast<Byte *>(data);
+            Capacity = capacity;
+        }
+#elif EMU_RECOMPILER
+        auto * data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data != MAP_FAILED)
+        {
+            Data = static_cast<Byte *>(data);
+            Capacity = capacity;
+        }
+#endif
+    }
+
+    ExecutableMemory::~ExecutableMemory()
+    {
+        if (Data == nullptr)
+            return;
+
+#if EMU_RECOMPILER && defined(_WIN32)
+        VirtualFree(Data, 0, MEM_RELEASE);
+#elif EMU_RECOMPILER
+        munmap(Data, Capacity);
+#endif
+    }
+
+}
\ No newline at end of file
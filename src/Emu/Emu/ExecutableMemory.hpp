@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Emu/includes.hpp>
+
+
+// Recompiling to native code needs an x86-64 host
+#if !defined(EMU_RECOMPILER)
+    #if defined(__x86_64__) || defined(_M_X64)
+        #define EMU_RECOMPILER 1
+    #else
+        #define EMU_RECOMPILER 0
+    #endif
+#endif
+
+
+namespace Emu
+{
+
+    // Read, write and execute region for generated code, handed out with a bump allocator
+    struct ExecutableMemory
+    {
+        Byte * Data = nullptr;      // nullptr when the host refused the mapping
+        size_t Capacity = 0;
+        size_t Used = 0;
+
+        explicit ExecutableMemory(size_t capacity);
+        ~ExecutableMemory();
+
+        ExecutableMemory(ExecutableMemory const &) = delete;
+        ExecutableMemory & operator=(ExecutableMemory const &) = delete;
+
+        // Returns nullptr when full
+        Byte * Allocate(size_t size)
+        {
+            if (Data == nullptr || Used + size > Capacity)
+                return nullptr;
+
+            auto * result = Data + Used;
+            Used += (size + 15) & ~size_t(15);
+            return result;
+        }
+
+        void Reset()
+        {
+            Used = 0;
+        }
+    };
+
+}
\ No newline at end of file
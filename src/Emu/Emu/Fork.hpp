@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+
+
+namespace Emu
+{
+
+    // A machine branched off a ForkPoint, its memory reads the fork point's pages until it
+    // writes to them. Keeps the fork point's memory alive
+    struct ForkedMachine
+    {
+        CPU Cpu;
+        std::unique_ptr<Memory> Ram;
+        std::shared_ptr<Memory const> Parent;
+    };
+
+
+    // Frozen copy of a warmed up machine that any number of children are forked from. Taking
+    // the fork point copies the memory once, each fork then only pays for its page table and
+    // the pages it writes
+    struct ForkPoint
+    {
+        CPU Cpu;
+        std::shared_ptr<Memory const> Ram;
+
+        ForkPoint(CPU const & cpu, Memory const & memory)
+            : Cpu(cpu)
+        {
+            // Forking a fork, copy what is still shared so this does not depend on its parent
+            auto frozen = std::make_shared<Memory>(memory);
+            frozen->Unshare();
+            Ram = std::move(frozen);
+        }
+
+        ForkedMachine Fork() const
+        {
+            ForkedMachine machine { Cpu, std::make_unique<Memory>(), Ram };
+            machine.Ram->ShareFrom(*Ram);
+            return machine;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <vector>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+#include <Emu/SaveState.hpp>
+#include <Emu/Scheduler.hpp>
+
+
+namespace Emu
+{
+
+    // Device input callback, e.g. a key going down, for a channel connected on InputDevices.
+    // Runs between instructions with the CPU at the cycle the input was given
+    using InputHandler = void (*)(void * context, Memory & memory, Scheduler & scheduler, uint32 value);
+
+
+    // The devices that take input from outside the machine, by channel. Recording and replay
+    // both deliver input through here so a device sees the same calls either way
+    struct InputDevices
+    {
+        struct Device
+        {
+            InputHandler Handler = nullptr;
+            void * Context = nullptr;
+        };
+
+        std::vector<Device> Channels;
+
+        void Connect(uint32 channel, InputHandler handler, void * context)
+        {
+            if (channel >= Channels.size())
+                Channels.resize(channel + 1u);
+
+            Channels[channel] = { handler, context };
+        }
+
+        // Input on a channel with nothing connected is dropped
+        void Deliver(uint32 channel, uint32 value, Memory & memory, Scheduler & scheduler) const
+        {
+            if (channel < Channels.size() && Channels[channel].Handler != nullptr)
+                Channels[channel].Handler(Channels[channel].Context, memory, scheduler, value);
+        }
+    };
+
+
+    enum class InputKind : Byte
+    {
+        Write,
+        RaiseIrq,
+        ClearIrq,
+        RaiseNmi,
+        Device,
+    };
+
+    // Something done to the machine from outside, at the TotalCycles it was done at
+    struct InputEvent
+    {
+        uint64 Cycle;
+        InputKind Kind;
+        Word Address;       // Write
+        uint32 Channel;     // Device
+        uint32 Value;       // Byte written, IRQ lines or device input
+
+        bool operator==(InputEvent const & other) const
+        {
+            return Cycle == other.Cycle && Kind == other.Kind && Address == other.Address
+                && Channel == other.Channel && Value == other.Value;
+        }
+    };
+
+
+    // Everything injected into a run from outside, enough to run it again exactly: a save state
+    // of the CPU and memory at the start, the scheduler's interrupt lines at the start, and the
+    // events in order. Devices driven by the scheduler are part of the machine rather than the
+    // log, they have to be set up the same way on a fresh scheduler for both runs.
+    //
+    // File: a header, the save state, then the events. Each event is the cycles since the one
+    // before as a varint, the first counting from 0, then the kind and its operands, a little
+    // endian address and a byte for a write and varints for the rest
+    struct InputLog
+    {
+        static constexpr char MAGIC[8] = { 'E', 'M', 'U', 'I', 'N', 'P', 'U', 'T' };
+        static constexpr uint32 VERSION = 1u;
+
+        struct Header
+        {
+            char Magic[8];
+            uint32 Version;
+            uint32 IrqLines;
+            uint32 NmiPending;
+            uint32 StateSize;
+        };
+
+        static_assert(sizeof(Header) == 24, "The header is part of the file format");
+
+        RomImage StartState;            // Restored RAM pages map onto it, keep the log alive while they do
+        uint32 IrqLines = 0u;
+        bool NmiPending = false;
+        std::vector<InputEvent> Events;
+
+        // Applies an event to the machine, for recording and replay alike
+        static void Apply(InputEvent const & event, Memory & memory, Scheduler & scheduler, InputDevices const & devices)
+        {
+            switch (event.Kind)
+            {
+            case InputKind::Write:      memory.WriteByte(event.Address, static_cast<Byte>(event.Value)); break;
+            case InputKind::RaiseIrq:   scheduler.RaiseIrq(event.Value); break;
+            case InputKind::ClearIrq:   scheduler.ClearIrq(event.Value); break;
+            case InputKind::RaiseNmi:   scheduler.RaiseNmi(); break;
+            case InputKind::Device:     devices.Deliver(event.Channel, event.Value, memory, scheduler); break;
+            }
+        }
+
+        std::vector<Byte> Encode() const
+        {
+            Header header { };
+            memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+            header.Version = VERSION;
+            header.IrqLines = IrqLines;
+            header.NmiPending = NmiPending ? 1u : 0u;
+            header.StateSize = static_cast<uint32>(StartState.Size);
+
+            std::vector<Byte> bytes(sizeof(Header));
+            memcpy(bytes.data(), &header, sizeof(Header));
+            bytes.insert(bytes.end(), StartState.Data(), StartState.Data() + StartState.Size);
+
+            uint64 previous = 0u;
+
+            for (auto const & event : Events)
+            {
+                PutVarint(bytes, event.Cycle - previous);
+                bytes.push_back(static_cast<Byte>(event.Kind));
+                previous = event.Cycle;
+
+                switch (event.Kind)
+                {
+                case InputKind::Write:
+                    bytes.push_back(static_cast<Byte>(event.Address));
+                    bytes.push_back(static_cast<Byte>(event.Address >> 8));
+                    bytes.push_back(static_cast<Byte>(event.Value));
+                    break;
+                case InputKind::RaiseIrq:
+                case InputKind::ClearIrq:
+                    PutVarint(bytes, event.Value);
+                    break;
+                case InputKind::RaiseNmi:
+                    break;
+                case InputKind::Device:
+                    PutVarint(bytes, event.Channel);
+                    PutVarint(bytes, event.Value);
+                    break;
+                }
+            }
+
+            return bytes;
+        }
+
+        bool SaveFile(char const * path) const
+        {
+            auto bytes = Encode();
+
+            auto * file = fopen(path, "wb");
+            if (file == nullptr)
+                return false;
+
+            auto written = fwrite(bytes.data(), 1, bytes.size(), file);
+            return fclose(file) == 0 && written == bytes.size();
+        }
+
+        // Reads a log, e.g. from MapFile. The start state is kept as part of the image rather
+        // than copied. Nothing is changed and false is returned if the image is not a log this
+        // version reads, or its state or any event does not decode
+        bool Decode(RomImage const & image)
+        {
+            Header header;
+            if (image.Size < sizeof(Header))
+                return false;
+
+            memcpy(&header, image.Data(), sizeof(Header));
+            if (memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0 || header.Version != VERSION
+                || header.StateSize > image.Size - sizeof(Header))
+                return false;
+
+            RomImage state(std::shared_ptr<Byte const[]>(image.Bytes, image.Data() + sizeof(Header)), header.StateSize);
+            if (!SaveState::IsValid(state))
+                return false;
+
+            std::vector<InputEvent> events;
+            size_t at = sizeof(Header) + header.StateSize;
+            auto const * bytes = image.Data();
+
+            uint64 cycle = 0u;
+
+            while (at < image.Size)
+            {
+                uint64 delta, value = 0u, channel = 0u;
+                if (!GetVarint(bytes, image.Size, at, delta) || at == image.Size)
+                    return false;
+
+                InputEvent event { cycle += delta, static_cast<InputKind>(bytes[at++]), 0u, 0u, 0u };
+
+                switch (event.Kind)
+                {
+                case InputKind::Write:
+                    if (image.Size - at < 3)
+                        return false;
+                    event.Address = static_cast<Word>(bytes[at] | bytes[at + 1] << 8);
+                    value = bytes[at + 2];
+                    at += 3;
+                    break;
+                case InputKind::RaiseIrq:
+                case InputKind::ClearIrq:
+                    if (!GetVarint(bytes, image.Size, at, value))
+                        return false;
+                    break;
+                case InputKind::RaiseNmi:
+                    break;
+                case InputKind::Device:
+                    if (!GetVarint(bytes, image.Size, at, channel) || !GetVarint(bytes, image.Size, at, value))
+                        return false;
+                    break;
+                default:
+                    return false;
+                }
+
+                event.Channel = static_cast<uint32>(channel);
+                event.Value = static_cast<uint32>(value);
+                events.push_back(event);
+            }
+
+            StartState = std::move(state);
+            IrqLines = header.IrqLines;
+            NmiPending = header.NmiPending != 0;
+            Events = std::move(events);
+            return true;
+        }
+
+        bool Open(char const * path)
+        {
+            return Decode(MapFile(path));
+        }
+
+        // Puts the machine back to the start of the log and runs it through every event, then on
+        // to endCycle if that is later, without anything from outside. The scheduler should be
+        // fresh apart from the machine's own devices. Events go in between the scheduler's runs
+        // just as they did while recording. False if the state does not restore, the run passes
+        // the cycle of an event or stops on an unhandled instruction, i.e. it is not the machine
+        // the log was recorded on
+        bool Replay(CPU & cpu, Memory & memory, Scheduler & scheduler, InputDevices const & devices, uint64 endCycle = 0u) const
+        {
+            if (!SaveState::Restore(StartState, cpu, memory))
+                return false;
+
+            scheduler.IrqLines = IrqLines;
+            scheduler.NmiPending = NmiPending;
+
+            for (auto const & event : Events)
+            {
+                if (!RunTo(event.Cycle, cpu, memory, scheduler))
+                    return false;
+
+                Apply(event, memory, scheduler, devices);
+            }
+
+            return endCycle <= cpu.TotalCycles || RunTo(endCycle, cpu, memory, scheduler);
+        }
+
+        // Runs until TotalCycles reaches cycle, false if an instruction ends past it or the CPU
+        // stops on an unhandled instruction
+        static bool RunTo(uint64 cycle, CPU & cpu, Memory & memory, Scheduler & scheduler)
+        {
+            while (cpu.TotalCycles < cycle)
+            {
+                cpu.Execute(static_cast<uint32>(std::min<uint64>(cycle - cpu.TotalCycles, CPU::MAX_BUDGET)), memory, scheduler);
+                if (cpu.DebugFlags.UnhandledInstruction)
+                    return false;
+            }
+
+            return cpu.TotalCycles == cycle;
+        }
+
+        static void PutVarint(std::vector<Byte> & out, uint64 value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<Byte>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<Byte>(value));
+        }
+
+        static bool GetVarint(Byte const * bytes, size_t size, size_t & at, uint64 & value)
+        {
+            value = 0u;
+            for (uint32 shift = 0; shift < 64 && at < size; shift += 7)
+            {
+                auto byte = bytes[at++];
+                value |= static_cast<uint64>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    return true;
+            }
+            return false;
+        }
+    };
+
+
+    // Stands between the host and the machine while a run is recorded. The host makes every
+    // change from outside through it, between calls to CPU::Execute with the scheduler, and
+    // each is logged at the CPU's TotalCycles and applied the same way replay will apply it.
+    // The log does not hold the scheduler's clock or events, so recording has to start on a
+    // fresh scheduler: Now at 0 and nothing pending but the machine's own devices, set up the
+    // same way the replay scheduler will be
+    struct InputRecorder
+    {
+        CPU & Cpu;
+        Memory & Ram;
+        Scheduler & Schedule;
+        InputDevices const & Devices;
+        InputLog Log;
+
+        // Captures the start state, the machine should not change from outside before this
+        InputRecorder(CPU & cpu, Memory & memory, Scheduler & scheduler, InputDevices const & devices, bool compress = true)
+            : Cpu(cpu), Ram(memory), Schedule(scheduler), Devices(devices)
+        {
+            Log.StartState = RomImage(SaveState::Save(cpu, memory, compress));
+            Log.IrqLines = scheduler.IrqLines;
+            Log.NmiPending = scheduler.NmiPending;
+        }
+
+        void WriteByte(Word address, Byte value)
+        {
+            Record({ Cpu.TotalCycles, InputKind::Write, address, 0u, value });
+        }
+
+        void RaiseIrq(uint32 lines = 1u)
+        {
+            Record({ Cpu.TotalCycles, InputKind::RaiseIrq, 0u, 0u, lines });
+        }
+
+        void ClearIrq(uint32 lines = 1u)
+        {
+            Record({ Cpu.TotalCycles, InputKind::ClearIrq, 0u, 0u, lines });
+        }
+
+        void RaiseNmi()
+        {
+            Record({ Cpu.TotalCycles, InputKind::RaiseNmi, 0u, 0u, 0u });
+        }
+
+        void Input(uint32 channel, uint32 value)
+        {
+            Record({ Cpu.TotalCycles, InputKind::Device, 0u, channel, value });
+        }
+
+        void Record(InputEvent const & event)
+        {
+            Log.Events.push_back(event);
+            InputLog::Apply(event, Ram, Schedule, Devices);
+        }
+    };
+
+}
@@ -0,0 +1,70 @@
+#include <Emu/Loader.hpp>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+namespace Emu
+{
+
+    RomImage MapFile(char const * path)
+    {
+#if defined(_WIN32)
+        auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return { };
+
+        LARGE_INTEGER size;
+        auto mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0
+            ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+            : nullptr;
+        CloseHandle(file);
+
+        if (mapping == nullptr)
+            return { };
+
+        auto * data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+
+        if (data == nullptr)
+            return { };
+
+        auto bytes = std::shared_ptr<Byte const[]>(static_cast<Byte const *>(data), [](Byte const * view)
+        {
+            UnmapViewOfFile(view);
+        });
+
+        return RomImage(std::move(bytes), static_cast<size_t>(size.QuadPart));
+#else
+        auto file = open(path, O_RDONLY);
+        if (file < 0)
+            return { };
+
+        struct stat info;
+        void * data = MAP_FAILED;
+        if (fstat(file, &info) == 0 && info.st_size > 0)
+            data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+
+        if (data == MAP_FAILED)
+            return { };
+
+        auto size = static_cast<size_t>(info.st_size);
+        auto bytes = std::shared_ptr<Byte const[]>(static_cast<Byte const *>(data), [size](Byte const * view)
+        {
+            munmap(const_cast<Byte *>(view), size);
+        });
+
+        return RomImage(std::move(bytes), size);
+#endif
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+
+#include <Emu/Mapper.hpp>
+#include <Emu/Memory.hpp>
+
+
+namespace Emu
+{
+
+    // Maps a file read only, copies of the image share the one mapping. Empty when the file
+    // cannot be opened or is empty
+    RomImage MapFile(char const * path);
+
+
+    // Puts program images into the address space without copying them. Raw and .prg images are
+    // mapped copy-on-write so they behave as RAM, the image has to outlive the memory it is loaded
+    // into. Cartridges are mapped as ROM behind a mapper that keeps its own reference
+    struct Loader
+    {
+        // Raw binary at address, bytes past the top of memory are dropped
+        static bool LoadRaw(Memory & memory, RomImage const & image, Word address)
+        {
+            if (image.Size == 0)
+                return false;
+
+            LoadBytes(memory, image.Data(), image.Size, address);
+            return true;
+        }
+
+        // .prg file, a little endian load address followed by the program
+        static bool LoadPrg(Memory & memory, RomImage const & image, Word * loadAddress = nullptr)
+        {
+            if (image.Size < 2)
+                return false;
+
+            auto address = static_cast<Word>(image.Data()[0] | image.Data()[1] << 8);
+            LoadBytes(memory, image.Data() + 2, image.Size - 2, address);
+
+            if (loadAddress != nullptr)
+                *loadAddress = address;
+
+            return true;
+        }
+
+        // iNES cartridge, PRG ROM goes at 0x8000 and CHR ROM is left out as there is no PPU.
+        // Supports NROM (mapper 0) and UxROM (mapper 2), nullptr for anything else
+        static std::unique_ptr<BankedMapper> LoadNes(Memory & memory, RomImage const & image)
+        {
+            static constexpr size_t HEADER_SIZE = 16;
+            static constexpr size_t TRAINER_SIZE = 512;
+            static constexpr uint32 PRG_BANK_SIZE = 16 * 1024;
+            static constexpr uint32 PRG_BANK_PAGES = PRG_BANK_SIZE / Memory::PAGE_SIZE;
+
+            auto const * header = image.Data();
+            if (image.Size < HEADER_SIZE || memcmp(header, "NES\x1A", 4) != 0)
+                return nullptr;
+
+            uint32 prgBanks = header[4];
+            uint32 mapperNumber = (header[6] >> 4) | (header[7] & 0xF0);
+            auto prgOffset = HEADER_SIZE + ((header[6] & 0x04) ? TRAINER_SIZE : 0);
+
+            if (prgBanks == 0 || image.Size < prgOffset + prgBanks * PRG_BANK_SIZE)
+                return nullptr;
+
+            // PRG ROM as its own image sharing the file's storage
+            RomImage prg(std::shared_ptr<Byte const[]>(image.Bytes, image.Data() + prgOffset), prgBanks * PRG_BANK_SIZE);
+
+            std::unique_ptr<BankedMapper> mapper;
+            switch (mapperNumber)
+            {
+            case 0:
+                // 16KB carts are mirrored into both halves
+                mapper = std::make_unique<BankedMapper>(prg, std::vector<BankedMapper::Window> {
+                    { 0x80, PRG_BANK_PAGES, 0 },
+                    { 0xC0, PRG_BANK_PAGES, 1 } });
+                break;
+
+            case 2:
+                // Switchable bank at 0x8000, last bank fixed at 0xC000, a write anywhere switches
+                mapper = std::make_unique<BankedMapper>(prg, std::vector<BankedMapper::Window> {
+                    { 0x80, PRG_BANK_PAGES, 0 },
+                    { 0xC0, PRG_BANK_PAGES, prgBanks - 1 } });
+                mapper->RegisterWindow = 0;
+                break;
+
+            default:
+                return nullptr;
+            }
+
+            if (!mapper->Attach(memory))
+                return nullptr;
+
+            return mapper;
+        }
+
+        // Whole pages are mapped and the partial pages at either end are copied, so the rest of
+        // those pages keeps what was there
+        static void LoadBytes(Memory & memory, Byte const * bytes, size_t size, Word address)
+        {
+            uint32 begin = address;
+            uint32 end = begin + static_cast<uint32>(std::min<size_t>(size, Memory::MAX_MEMORY - begin));
+
+            uint32 firstPage = (begin + Memory::PAGE_SIZE - 1) / Memory::PAGE_SIZE;
+            uint32 endPage = end / Memory::PAGE_SIZE;
+
+            if (firstPage >= endPage)
+            {
+                Copy(memory, bytes, begin, end);
+                return;
+            }
+
+            Copy(memory, bytes, begin, firstPage * Memory::PAGE_SIZE);
+            memory.MapCopyOnWrite(firstPage, endPage - firstPage, bytes + (firstPage * Memory::PAGE_SIZE - begin));
+            Copy(memory, bytes + (endPage * Memory::PAGE_SIZE - begin), endPage * Memory::PAGE_SIZE, end);
+        }
+
+        static void Copy(Memory & memory, Byte const * bytes, uint32 begin, uint32 end)
+        {
+            for (uint32 address = begin; address < end; ++address)
+                memory.WriteByte(address, bytes[address - begin]);
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,738 @@
+#pragma once
+
+#include <vector>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+#include <Emu/OpCodes.hpp>
+
+
+namespace Emu
+{
+
+    // Runs many copies of one program together, e.g. a sweep over every input value. Registers
+    // are kept as one array per register across lanes and each instruction is decoded once and
+    // applied to every lane, the lane loops are written to be vectorized by the compiler.
+    //
+    // Lanes read the shared memory until they write to a page, that page then becomes a lane page
+    // holding a column of bytes per address so a uniform access is a single vector load or store.
+    // A lane that takes a different path, e.g. through RTS or JMP (indirect), moves to its own
+    // CPU and Memory and finishes on the interpreter.
+    //
+    // Writes to pages that are not RAM in the shared memory are dropped, device handlers are not
+    // called from lanes.
+    template <uint32 Lanes = 256>
+    struct Lockstep
+    {
+        static_assert(Lanes % 32 == 0, "Lanes are processed in whole AVX2 registers");
+
+        struct LanePage
+        {
+            alignas(32) Byte Bytes[Memory::PAGE_SIZE][Lanes];
+        };
+
+        Memory const & Shared;
+
+        // Inputs before Run and results after it
+        std::array<CPU, Lanes> Cpus;
+        std::array<uint32, Lanes> CyclesUsed = { };
+
+        std::vector<std::unique_ptr<LanePage>> Pages;
+        uint16 PageSlots[Memory::PAGE_COUNT] = { };        // Index + 1 into Pages, 0 reads Shared
+        std::array<std::unique_ptr<Memory>, Lanes> Diverged;    // Lanes running on their own
+
+        // Working state while lanes run together
+        alignas(32) Byte A[Lanes];
+        alignas(32) Byte X[Lanes];
+        alignas(32) Byte Y[Lanes];
+        alignas(32) Byte SP[Lanes];
+        alignas(32) Byte Status[Lanes];
+        alignas(32) Byte Active[Lanes];         // 0xFF for lanes still running together
+        alignas(32) Byte Values[Lanes];
+        alignas(32) Byte Crossed[Lanes];
+        alignas(32) Word Addresses[Lanes];
+        alignas(32) Word Targets[Lanes];
+        alignas(32) uint32 Extra[Lanes];        // Page crossing cycles on top of GroupCycles
+
+        Word PC = 0;
+        uint32 Budget = 0;
+        uint32 GroupCycles = 0;                 // Cycles every running lane has used
+        uint32 MaxExtra = 0;                    // Upper bound on Extra, saves checking every lane
+        uint32 ActiveCount = 0;
+        uint32 Leader = 0;                      // First running lane
+
+        explicit Lockstep(Memory const & shared, Word programCounter = 0xFFFC)
+            : Shared(shared)
+        {
+            for (auto & cpu : Cpus)
+                cpu.ResetRegisters(programCounter);
+        }
+
+        Byte ReadByte(uint32 lane, Word address) const
+        {
+            if (Diverged[lane] != nullptr)
+                return Diverged[lane]->ReadByte(address);
+
+            return LaneRead(lane, address);
+        }
+
+        // Sets a lane's own copy of a byte, e.g. a per lane input
+        void WriteByte(uint32 lane, Word address, Byte value)
+        {
+            if (Diverged[lane] != nullptr)
+                Diverged[lane]->WriteByte(address, value);
+            else
+                LaneWrite(lane, address, value);
+        }
+
+        uint32 DivergedCount() const
+        {
+            uint32 count = 0;
+            for (auto const & memory : Diverged)
+                count += memory != nullptr ? 1 : 0;
+            return count;
+        }
+
+        // Runs every lane for cycles the way CPU::Execute would, CyclesUsed gets the cycles each
+        // lane used
+        void Run(uint32 cycles)
+        {
+            Budget = cycles;
+            GroupCycles = 0;
+            MaxExtra = 0;
+            ActiveCount = 0;
+
+            bool first = true;
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+            {
+                Active[lane] = 0;
+                CyclesUsed[lane] = 0;
+
+                if (Diverged[lane] != nullptr)
+                    continue;
+
+                if (first)
+                {
+                    PC = Cpus[lane].PC;
+                    first = false;
+                }
+
+                if (Cpus[lane].PC != PC)
+                {
+                    Diverge(lane, Cpus[lane].PC, false);
+                    continue;
+                }
+
+                auto cpu = Cpus[lane];
+                cpu.SyncStatus();
+
+                A[lane] = cpu.A;
+                X[lane] = cpu.X;
+                Y[lane] = cpu.Y;
+                SP[lane] = cpu.SP;
+                Status[lane] = cpu.Status;
+                Extra[lane] = 0;
+                Active[lane] = 0xFF;
+                ++ActiveCount;
+            }
+
+            FindLeader();
+
+            while (ActiveCount > 0 && Budget > 0)
+                Step();
+
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+            {
+                if (Diverged[lane] != nullptr && CyclesUsed[lane] < Budget)
+                    CyclesUsed[lane] += Cpus[lane].Execute(Budget - CyclesUsed[lane], *Diverged[lane]);
+            }
+        }
+
+        void Step()
+        {
+            auto instruction = PC;
+            auto opCode = Fetch(instruction, instruction);
+            auto const & info = CPU::OpCodeTable[opCode];
+
+            if (!info.Implemented)
+            {
+                GroupCycles += 1;
+
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                {
+                    if (Active[lane])
+                    {
+                        Finish(lane, static_cast<Word>(instruction + 1));
+                        Cpus[lane].Trap({ Cpus[lane].TotalCycles, instruction, opCode });
+                    }
+                }
+                return;
+            }
+
+            Word operand = 0;
+            if (info.Length >= 2)
+                operand = Fetch(static_cast<Word>(instruction + 1), instruction);
+            if (info.Length == 3)
+                operand |= Fetch(static_cast<Word>(instruction + 2), instruction) << 8;
+
+            if (ActiveCount == 0)
+                return;
+
+            Word next = instruction + info.Length;
+            GroupCycles += info.Cycles;
+
+            bool branched = false;
+            switch (info.Op)
+            {
+            case Operation::LDA:    Load(info, operand); Copy(A, Values); SetZeroNegative(A); break;
+            case Operation::LDX:    Load(info, operand); Copy(X, Values); SetZeroNegative(X); break;
+            case Operation::LDY:    Load(info, operand); Copy(Y, Values); SetZeroNegative(Y); break;
+
+            case Operation::AND:
+                Load(info, operand);
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    A[lane] &= Values[lane];
+                SetZeroNegative(A);
+                break;
+
+            case Operation::EOR:
+                Load(info, operand);
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    A[lane] ^= Values[lane];
+                SetZeroNegative(A);
+                break;
+
+            case Operation::ORA:
+                Load(info, operand);
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    A[lane] |= Values[lane];
+                SetZeroNegative(A);
+                break;
+
+            case Operation::BIT:
+                Load(info, operand);
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                {
+                    auto value = Values[lane];
+                    Status[lane] = (value & 0b11000000) | (Status[lane] & 0b00111101) | ((A[lane] & value) == 0 ? 0b00000010 : 0);
+                }
+                break;
+
+            case Operation::STA:    Store(info, operand, A); break;
+            case Operation::STX:    Store(info, operand, X); break;
+            case Operation::STY:    Store(info, operand, Y); break;
+
+            case Operation::JMP:
+                if (info.Mode == AddressingMode::Indirect)
+                {
+                    Fill(Addresses, operand);
+                    ReadWords(Targets);
+                    branched = true;
+                }
+                else
+                {
+                    next = operand;
+                }
+                break;
+
+            case Operation::JSR:
+            {
+                auto returnAddress = static_cast<Word>(next - 1);
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    Addresses[lane] = static_cast<Word>((0x0100 | SP[lane]) - 1);
+                Fill(Values, static_cast<Byte>(returnAddress & 0xFF));
+                Scatter(Values);
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    Addresses[lane] = static_cast<Word>(Addresses[lane] + 1);
+                Fill(Values, static_cast<Byte>(returnAddress >> 8));
+                Scatter(Values);
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    SP[lane] -= 2;
+                next = operand;
+                break;
+            }
+
+            case Operation::RTI:
+                Pop();
+                Copy(Status, Values);
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    Addresses[lane] = static_cast<Word>((0x0100 | SP[lane]) + 1);
+                ReadWords(Targets);
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    SP[lane] += 2;
+                branched = true;
+                break;
+
+            case Operation::RTS:
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    Addresses[lane] = static_cast<Word>((0x0100 | SP[lane]) + 1);
+                ReadWords(Targets);
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                {
+                    Targets[lane] = static_cast<Word>(Targets[lane] + 1);
+                    SP[lane] += 2;
+                }
+                branched = true;
+                break;
+
+            case Operation::PHA:    Push(A); break;
+            case Operation::PHP:    Push(Status); break;
+
+            case Operation::PLA:
+                Pop();
+                Copy(A, Values);
+                SetZeroNegative(A);
+                break;
+
+            case Operation::PLP:
+                // Matches the interpreter, Zero and Negative end up following A
+                Pop();
+                Copy(Status, Values);
+                SetZeroNegative(A);
+                break;
+
+            case Operation::TSA:    Copy(A, SP); SetZeroNegative(A); break;
+            case Operation::TSX:    Copy(X, SP); SetZeroNegative(X); break;
+            case Operation::TXS:    Copy(SP, X); break;
+            }
+
+            if (branched)
+                Branch();
+            else
+                Advance(next);
+        }
+
+        // Every running lane moves on to next, lanes out of cycles stop there
+        void Advance(Word next)
+        {
+            PC = next;
+
+            if (GroupCycles + MaxExtra < Budget)
+                return;
+
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+            {
+                if (Active[lane] && GroupCycles + Extra[lane] >= Budget)
+                    Finish(lane, next);
+            }
+        }
+
+        // Lanes moving to Targets, those out of cycles stop and of the rest the ones not going
+        // where the leader goes leave
+        void Branch()
+        {
+            if (GroupCycles + MaxExtra >= Budget)
+            {
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                {
+                    if (Active[lane] && GroupCycles + Extra[lane] >= Budget)
+                        Finish(lane, Targets[lane]);
+                }
+            }
+
+            if (ActiveCount == 0)
+                return;
+
+            PC = Targets[Leader];
+
+            Word differs = 0;
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+                differs |= Active[lane] ? Targets[lane] ^ PC : 0;
+
+            if (differs == 0)
+                return;
+
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+            {
+                if (Active[lane] && Targets[lane] != PC)
+                    Diverge(lane, Targets[lane], true);
+            }
+        }
+
+        // Instruction byte, lanes whose copy of a lane page holds different code leave
+        Byte Fetch(Word address, Word instruction)
+        {
+            auto slot = PageSlots[address / Memory::PAGE_SIZE];
+            if (slot == 0)
+                return Shared.ReadByte(address);
+
+            auto const * column = Pages[slot - 1]->Bytes[address % Memory::PAGE_SIZE];
+            Byte value;
+            if (Same(column, value))
+                return value;
+
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+            {
+                if (Active[lane] && column[lane] != value)
+                    Diverge(lane, instruction, true);
+            }
+
+            return value;
+        }
+
+        // Operand of a read into Values
+        void Load(OpCodeInfo const & info, Word operand)
+        {
+            if (info.Mode == AddressingMode::Immediate)
+                Fill(Values, static_cast<Byte>(operand));
+            else if (info.Mode == AddressingMode::ZeroPage || info.Mode == AddressingMode::Absolute)
+                ReadColumn(operand);
+            else
+            {
+                Word address;
+                if (Resolve(info, operand, address))
+                    ReadColumn(address);
+                else
+                    Gather();
+            }
+        }
+
+        void Store(OpCodeInfo const & info, Word operand, Byte const * values)
+        {
+            if (info.Mode == AddressingMode::ZeroPage || info.Mode == AddressingMode::Absolute)
+                WriteColumn(operand, values);
+            else
+            {
+                Word address;
+                if (Resolve(info, operand, address))
+                    WriteColumn(address, values);
+                else
+                    Scatter(values);
+            }
+        }
+
+        void Push(Byte const * values)
+        {
+            Byte sp;
+            if (Same(SP, sp))
+                WriteColumn(0x0100 | sp, values);
+            else
+            {
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    Addresses[lane] = 0x0100 | SP[lane];
+                Scatter(values);
+            }
+
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+                --SP[lane];
+        }
+
+        void Pop()
+        {
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+                ++SP[lane];
+
+            Byte sp;
+            if (Same(SP, sp))
+                ReadColumn(0x0100 | sp);
+            else
+            {
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    Addresses[lane] = 0x0100 | SP[lane];
+                Gather();
+            }
+        }
+
+        // Address for an indexed or indirect mode and charges page crossings. Returns true when
+        // every lane uses address, otherwise the lanes' addresses are in Addresses
+        bool Resolve(OpCodeInfo const & info, Word operand, Word & address)
+        {
+            switch (info.Mode)
+            {
+            case AddressingMode::ZeroPageX:
+                return ZeroPageIndex(operand, X, address);
+
+            case AddressingMode::ZeroPageY:
+                return ZeroPageIndex(operand, Y, address);
+
+            case AddressingMode::AbsoluteX:
+                return Index(operand, X, info.PageCrossPenalty, address);
+
+            case AddressingMode::AbsoluteY:
+                return Index(operand, Y, info.PageCrossPenalty, address);
+
+            case AddressingMode::IndirectX:
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                    Addresses[lane] = static_cast<Word>(operand + X[lane]);
+                ReadWords(Addresses);
+                break;
+
+            case AddressingMode::IndirectY:
+            {
+                Fill(Addresses, operand);
+                ReadWords(Addresses);
+
+                bool crossed = false;
+                for (uint32 lane = 0; lane < Lanes; ++lane)
+                {
+                    Crossed[lane] = ((Addresses[lane] & 0xFF) + Y[lane]) > 0xFF ? 1 : 0;
+                    Addresses[lane] = static_cast<Word>(Addresses[lane] + Y[lane]);
+                    crossed |= Crossed[lane] & Active[lane];
+                }
+
+                if (info.PageCrossPenalty && crossed)
+                    ChargeCrossed();
+                break;
+            }
+
+            default:
+                address = operand;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool ZeroPageIndex(Word operand, Byte const * index, Word & address)
+        {
+            Byte same;
+            if (Same(index, same))
+            {
+                address = (operand + same) & 0x00FF;
+                return true;
+            }
+
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+                Addresses[lane] = (operand + index[lane]) & 0x00FF;
+            return false;
+        }
+
+        bool Index(Word operand, Byte const * index, bool penalty, Word & address)
+        {
+            Byte same;
+            if (Same(index, same))
+            {
+                address = static_cast<Word>(operand + same);
+                if (penalty && (operand & 0xFF) + same > 0xFF)
+                    GroupCycles += 1;
+                return true;
+            }
+
+            bool crossed = false;
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+            {
+                Crossed[lane] = ((operand & 0xFF) + index[lane]) > 0xFF ? 1 : 0;
+                Addresses[lane] = static_cast<Word>(operand + index[lane]);
+                crossed |= Crossed[lane] & Active[lane];
+            }
+
+            if (penalty && crossed)
+                ChargeCrossed();
+            return false;
+        }
+
+        void ChargeCrossed()
+        {
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+                Extra[lane] += Crossed[lane];
+            ++MaxExtra;
+        }
+
+        // Little endian words at Addresses and Addresses + 1 into words, which may be Addresses
+        void ReadWords(Word * words)
+        {
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+            {
+                if (Active[lane])
+                {
+                    auto address = Addresses[lane];
+                    words[lane] = LaneRead(lane, address) | LaneRead(lane, static_cast<Word>(address + 1)) << 8;
+                }
+            }
+        }
+
+        // Values from Addresses, one column read when every running lane uses the same address
+        void Gather()
+        {
+            Word address;
+            if (Uniform(address))
+            {
+                ReadColumn(address);
+                return;
+            }
+
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+            {
+                if (Active[lane])
+                    Values[lane] = LaneRead(lane, Addresses[lane]);
+            }
+        }
+
+        void Scatter(Byte const * values)
+        {
+            Word address;
+            if (Uniform(address))
+            {
+                WriteColumn(address, values);
+                return;
+            }
+
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+            {
+                if (Active[lane])
+                    LaneWrite(lane, Addresses[lane], values[lane]);
+            }
+        }
+
+        bool Uniform(Word & address) const
+        {
+            address = Addresses[Leader];
+
+            Word differs = 0;
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+                differs |= Active[lane] ? Addresses[lane] ^ address : 0;
+
+            return differs == 0;
+        }
+
+        // True when every running lane holds the same value, which goes in value
+        bool Same(Byte const * values, Byte & value) const
+        {
+            value = values[Leader];
+
+            Byte differs = 0;
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+                differs |= (values[lane] ^ value) & Active[lane];
+
+            return differs == 0;
+        }
+
+        void ReadColumn(Word address)
+        {
+            auto slot = PageSlots[address / Memory::PAGE_SIZE];
+            if (slot == 0)
+                Fill(Values, Shared.ReadByte(address));
+            else
+                Copy(Values, Pages[slot - 1]->Bytes[address % Memory::PAGE_SIZE]);
+        }
+
+        void WriteColumn(Word address, Byte const * values)
+        {
+            auto * page = PageFor(address / Memory::PAGE_SIZE);
+            if (page == nullptr)
+                return;
+
+            auto * column = page->Bytes[address % Memory::PAGE_SIZE];
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+                column[lane] = Active[lane] ? values[lane] : column[lane];
+        }
+
+        Byte LaneRead(uint32 lane, Word address) const
+        {
+            auto slot = PageSlots[address / Memory::PAGE_SIZE];
+            if (slot == 0)
+                return Shared.ReadByte(address);
+
+            return Pages[slot - 1]->Bytes[address % Memory::PAGE_SIZE][lane];
+        }
+
+        void LaneWrite(uint32 lane, Word address, Byte value)
+        {
+            if (auto * page = PageFor(address / Memory::PAGE_SIZE))
+                page->Bytes[address % Memory::PAGE_SIZE][lane] = value;
+        }
+
+        // Lane page for page, made from the shared page on first use. nullptr for pages that are
+        // not RAM
+        LanePage * PageFor(uint32 page)
+        {
+            if (PageSlots[page] != 0)
+                return Pages[PageSlots[page] - 1].get();
+
+            if (Shared.WritePages[page] == nullptr && !Shared.IsShared(page))
+                return nullptr;
+
+            auto & lanePage = Pages.emplace_back(std::make_unique<LanePage>());
+            for (uint32 offset = 0; offset < Memory::PAGE_SIZE; ++offset)
+                memset(lanePage->Bytes[offset], Shared.ReadByte(page * Memory::PAGE_SIZE + offset), Lanes);
+
+            PageSlots[page] = static_cast<uint16>(Pages.size());
+            return lanePage.get();
+        }
+
+        void SetZeroNegative(Byte const * values)
+        {
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+                Status[lane] = (Status[lane] & 0b01111101) | (values[lane] == 0 ? 0b00000010 : 0) | (values[lane] & 0b10000000);
+        }
+
+        template <typename T>
+        static void Fill(T * values, T value)
+        {
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+                values[lane] = value;
+        }
+
+        static void Copy(Byte * to, Byte const * from)
+        {
+            memcpy(to, from, Lanes);
+        }
+
+        // Registers back into the lane's CPU
+        void Save(uint32 lane, Word pc)
+        {
+            auto & cpu = Cpus[lane];
+            cpu.PC = pc;
+            cpu.A = A[lane];
+            cpu.X = X[lane];
+            cpu.Y = Y[lane];
+            cpu.SP = SP[lane];
+            cpu.Status = Status[lane];
+#if EMU_LAZY_FLAGS
+            cpu.FlagsPending = 0;
+#endif
+        }
+
+        void Finish(uint32 lane, Word pc)
+        {
+            Save(lane, pc);
+            CyclesUsed[lane] = GroupCycles + Extra[lane];
+            Cpus[lane].TotalCycles += CyclesUsed[lane];
+            if (CyclesUsed[lane] > Budget)
+                Cpus[lane].DebugFlags.CycleOverflow = 1;
+
+            Leave(lane);
+        }
+
+        // Moves a lane onto its own CPU and a full copy of its memory
+        void Diverge(uint32 lane, Word pc, bool running)
+        {
+            auto memory = std::make_unique<Memory>(Shared);
+            for (uint32 page = 0; page < Memory::PAGE_COUNT; ++page)
+            {
+                if (PageSlots[page] == 0)
+                    continue;
+
+                auto const & lanePage = *Pages[PageSlots[page] - 1];
+                for (uint32 offset = 0; offset < Memory::PAGE_SIZE; ++offset)
+                    memory->WriteByte(page * Memory::PAGE_SIZE + offset, lanePage.Bytes[offset][lane]);
+            }
+
+            Diverged[lane] = std::move(memory);
+
+            if (!running)
+                return;
+
+            Save(lane, pc);
+            CyclesUsed[lane] = GroupCycles + Extra[lane];
+            Cpus[lane].TotalCycles += CyclesUsed[lane];
+            Leave(lane);
+        }
+
+        void Leave(uint32 lane)
+        {
+            Active[lane] = 0;
+            --ActiveCount;
+
+            if (lane == Leader)
+                FindLeader();
+        }
+
+        void FindLeader()
+        {
+            for (Leader = 0; Leader < Lanes - 1 && !Active[Leader]; ++Leader)
+            { }
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <Emu/Memory.hpp>
+
+
+namespace Emu
+{
+
+    // Read only image loaded once, copies share the same bytes
+    struct RomImage
+    {
+        std::shared_ptr<Byte const[]> Bytes;
+        size_t Size = 0;
+
+        RomImage() = default;
+
+        explicit RomImage(std::vector<Byte> const & bytes)
+            : Size(bytes.size())
+        {
+            auto * storage = new Byte[bytes.size()];
+            std::copy(bytes.begin(), bytes.end(), storage);
+            Bytes = std::shared_ptr<Byte const[]>(storage);
+        }
+
+        // Takes over bytes owned elsewhere, e.g. a file mapping, the deleter releases them
+        RomImage(std::shared_ptr<Byte const[]> bytes, size_t size)
+            : Bytes(std::move(bytes)), Size(size)
+        { }
+
+        Byte const * Data() const
+        {
+            return Bytes.get();
+        }
+    };
+
+
+    // Shows banks of an image through windows in the address space. A window is a run of pages
+    // and selecting a bank only repoints its page table entries, nothing is copied. Mapped pages
+    // point back at the mapper so it has to stay put once attached
+    struct BankedMapper
+    {
+        struct Window
+        {
+            uint32 FirstPage;
+            uint32 PageCount;
+            uint32 Bank = 0;
+        };
+
+        RomImage Image;
+        std::vector<Window> Windows;
+
+        // UxROM style register, a write anywhere in a window selects the bank for this window
+        static constexpr size_t NO_REGISTER = ~size_t(0);
+        size_t RegisterWindow = NO_REGISTER;
+
+        BankedMapper(RomImage image, std::vector<Window> windows)
+            : Image(std::move(image)), Windows(std::move(windows))
+        { }
+
+        uint32 BankSize(size_t window) const
+        {
+            return Windows[window].PageCount * Memory::PAGE_SIZE;
+        }
+
+        // Whole banks only, 0 for an image smaller than one bank of the window
+        uint32 BankCount(size_t window) const
+        {
+            auto size = BankSize(window);
+            return size != 0u ? static_cast<uint32>(Image.Size / size) : 0u;
+        }
+
+        // Every window has at least one bank of the image to show and fits in the address space
+        bool IsValid() const
+        {
+            for (size_t window = 0; window < Windows.size(); ++window)
+            {
+                if (BankCount(window) == 0u || Windows[window].FirstPage + Windows[window].PageCount > Memory::PAGE_COUNT)
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Maps every window at its current bank. False, leaving memory alone, if the mapper is
+        // not valid
+        bool Attach(Memory & memory)
+        {
+            if (!IsValid())
+                return false;
+
+            for (size_t window = 0; window < Windows.size(); ++window)
+                Select(memory, window, Windows[window].Bank);
+
+            return true;
+        }
+
+        // Banks wrap around the image like the upper address lines being left unconnected.
+        // False, leaving memory alone, if the image has no bank for the window
+        bool Select(Memory & memory, size_t window, uint32 bank)
+        {
+            auto count = BankCount(window);
+            if (count == 0u)
+                return false;
+
+            auto & target = Windows[window];
+            target.Bank = bank % count;
+
+            auto * write = RegisterWindow != NO_REGISTER ? &WriteRegister : nullptr;
+            memory.MapRom(target.FirstPage, target.PageCount, Image.Data() + target.Bank * BankSize(window), write, this);
+            return true;
+        }
+
+        static void WriteRegister(void * context, Memory & memory, Word address, Byte value)
+        {
+            auto & mapper = *static_cast<BankedMapper *>(context);
+            mapper.Select(memory, mapper.RegisterWindow, value);
+        }
+    };
+
+}
\ No newline at end of file
@@ -6,37 +6,393 @@
 namespace Emu
 {
 
+    struct Memory;
+
+    // Device callbacks for a page mapped to I/O, context is whatever was passed to MapHandlers.
+    // Writes get the memory so a device such as a mapper can repoint pages
+    using ReadHandler = Byte (*)(void * context, Word address);
+    using WriteHandler = void (*)(void * context, Memory & memory, Word address, Byte value);
+
+    struct PageHandlers
+    {
+        ReadHandler Read = nullptr;
+        WriteHandler Write = nullptr;     // nullptr drops writes
+        void * Context = nullptr;
+    };
+
+    // Copy of RAM taken by Memory::Checkpoint
+    struct MemorySnapshot
+    {
+        Byte Data[1024 * 64];
+    };
+
     struct Memory
     {
         static constexpr uint32 MAX_MEMORY = 1024 * 64;
+        static constexpr uint32 PAGE_SIZE = 256;
+        static constexpr uint32 PAGE_COUNT = MAX_MEMORY / PAGE_SIZE;
+
         Byte Data[MAX_MEMORY];
 
+        // Pages a write has to look at, zero keeps the write on the fast path. A write to a code
+        // page bumps its generation so cached blocks go stale, the first write to a clean page
+        // adds it to DirtyPages
+        static constexpr Byte PAGE_CODE = 0x01;
+        static constexpr Byte PAGE_CLEAN = 0x02;
+
+        Byte WatchedPages[PAGE_COUNT] = { };
+        uint32 CodePageGenerations[PAGE_COUNT] = { };
+        uint32 CodeGeneration = 0u;     // Bumped along with any page generation
+
+        // Pages written since the baseline was taken, resets only copy these back. Writes that go
+        // around WriteByte, e.g. straight into Data, are not seen
+        Byte const * Baseline = nullptr;
+        Byte DirtyPages[PAGE_COUNT];
+        uint32 DirtyCount = 0u;
+
+        // Page table, a page either points at host memory or goes through its handlers. A page
+        // with a read pointer but no write pointer is ROM
+        Byte * ReadPages[PAGE_COUNT];
+        Byte * WritePages[PAGE_COUNT];
+        PageHandlers Handlers[PAGE_COUNT];
+        uint32 RemappedPages = 0u;      // Pages not backed by Data, zero means the bus is flat RAM
+
+        Memory()
+        {
+            for (uint32 page = 0; page < PAGE_COUNT; ++page)
+                ReadPages[page] = WritePages[page] = Data + page * PAGE_SIZE;
+        }
+
+        Memory(Memory const & other)
+        {
+            *this = other;
+        }
+
+        // Pages pointing into the other Data are rebased onto this one, everything else is shared
+        Memory & operator=(Memory const & other)
+        {
+            if (this == &other)
+                return *this;
+
+            auto rebase = [this, &other](Byte * page) -> Byte *
+            {
+                if (page >= other.Data && page < other.Data + MAX_MEMORY)
+                    return Data + (page - other.Data);
+                return page;
+            };
+
+            memcpy(Data, other.Data, MAX_MEMORY);
+            memcpy(WatchedPages, other.WatchedPages, sizeof(WatchedPages));
+            memcpy(CodePageGenerations, other.CodePageGenerations, sizeof(CodePageGenerations));
+            CodeGeneration = other.CodeGeneration;
+
+            Baseline = other.Baseline;
+            memcpy(DirtyPages, other.DirtyPages, other.DirtyCount);
+            DirtyCount = other.DirtyCount;
+
+            for (uint32 page = 0; page < PAGE_COUNT; ++page)
+            {
+                ReadPages[page] = rebase(other.ReadPages[page]);
+                WritePages[page] = rebase(other.WritePages[page]);
+                Handlers[page] = other.Handlers[page];
+            }
+
+            RemappedPages = other.RemappedPages;
+            return *this;
+        }
+
+        // Clears RAM, mappings are left in place. After the first call only the pages written
+        // since are cleared
         void Initialize()
         {
-            memset(&Data, 0, MAX_MEMORY);
+            ResetTo(Zeroes);
+        }
+
+        // Copies RAM into the snapshot and starts tracking writes against it, the snapshot has to
+        // outlive the tracking. Shared pages are copied from the parent
+        void Checkpoint(MemorySnapshot & snapshot)
+        {
+            for (uint32 page = 0; page < PAGE_COUNT; ++page)
+            {
+                auto const * source = IsShared(page) ? ReadPages[page] : Data + page * PAGE_SIZE;
+                memcpy(snapshot.Data + page * PAGE_SIZE, source, PAGE_SIZE);
+            }
+
+            Track(snapshot.Data);
+        }
+
+        // Puts RAM back to the snapshot, returns the number of pages copied. That is every page
+        // unless the snapshot was the last checkpoint
+        uint32 ResetToSnapshot(MemorySnapshot const & snapshot)
+        {
+            return ResetTo(snapshot.Data);
+        }
+
+        inline void MarkCodePage(uint32 page)
+        {
+            WatchedPages[page] |= PAGE_CODE;
+        }
+
+        inline void InvalidatePage(uint32 page)
+        {
+            if (WatchedPages[page] & PAGE_CODE)
+            {
+                WatchedPages[page] &= ~PAGE_CODE;
+                ++CodePageGenerations[page];
+                ++CodeGeneration;
+            }
+        }
+
+        inline void WatchedWrite(uint32 page)
+        {
+            if (WatchedPages[page] & PAGE_CLEAN)
+            {
+                WatchedPages[page] &= ~PAGE_CLEAN;
+                DirtyPages[DirtyCount++] = static_cast<Byte>(page);
+            }
+
+            InvalidatePage(page);
+        }
+
+        inline void InvalidateCode(uint32 address)
+        {
+            InvalidatePage((address / PAGE_SIZE) % PAGE_COUNT);
+        }
+
+        bool IsFlat() const
+        {
+            return RemappedPages == 0u;
         }
 
-        Byte ReadByte(uint32 address) const
+        // Maps pageCount pages of host memory from firstPage, read only when writable is false
+        void MapMemory(uint32 firstPage, uint32 pageCount, Byte * host, bool writable = true)
         {
-            return Data[address];
+            for (uint32 i = 0; i < pageCount; ++i)
+            {
+                auto page = firstPage + i;
+                SetPage(page, host + i * PAGE_SIZE, writable ? host + i * PAGE_SIZE : nullptr, { });
+            }
         }
 
-        void WriteByte(uint32 address, Byte value)
+        // Read only host memory, writes go to the optional handler, e.g. a mapper's bank register
+        void MapRom(uint32 firstPage, uint32 pageCount, Byte const * host, WriteHandler write = nullptr, void * context = nullptr)
         {
-            Data[address] = value;
+            // Never written through, WritePages stays nullptr
+            auto * pages = const_cast<Byte *>(host);
+
+            for (uint32 i = 0; i < pageCount; ++i)
+                SetPage(firstPage + i, pages + i * PAGE_SIZE, nullptr, { nullptr, write, context });
         }
 
-        Word ReadWord(uint32 address) const
+        // RAM that reads host in place until written, a page is copied into Data on its first write.
+        // Host has to outlive the mapping and not change under it. Pages mapped with dropOnReset
+        // stand in for RAM contents, e.g. a restored save state, and a reset points them back
+        // at Data along with the pages written since the baseline
+        void MapCopyOnWrite(uint32 firstPage, uint32 pageCount, Byte const * host, bool dropOnReset = false)
         {
-            Word word = Data[address];
-            word |= (((Word)Data[address + 1]) << 8);
+            auto * pages = const_cast<Byte *>(host);
+            auto * context = dropOnReset ? &DropOnReset : nullptr;
+
+            for (uint32 i = 0; i < pageCount; ++i)
+                SetPage(firstPage + i, pages + i * PAGE_SIZE, nullptr, { nullptr, &CopyOnWrite, context });
+        }
+
+        void MapHandlers(uint32 firstPage, uint32 pageCount, ReadHandler read, WriteHandler write, void * context)
+        {
+            for (uint32 i = 0; i < pageCount; ++i)
+                SetPage(firstPage + i, nullptr, nullptr, { read, write, context });
+        }
+
+        // Points pages back at Data
+        void Unmap(uint32 firstPage, uint32 pageCount)
+        {
+            MapMemory(firstPage, pageCount, Data + firstPage * PAGE_SIZE);
+        }
+
+        // Reads parent's RAM pages in place, a page is copied into Data on its first write. The
+        // parent must outlive this memory and not change while shared, other mappings are copied
+        // as they are. Data is not touched until a page goes private
+        void ShareFrom(Memory const & parent)
+        {
+            for (uint32 page = 0; page < PAGE_COUNT; ++page)
+            {
+                auto * read = parent.ReadPages[page];
+                auto const & handlers = parent.Handlers[page];
+
+                if (read == parent.Data + page * PAGE_SIZE && parent.WritePages[page] == read)
+                    MapCopyOnWrite(page, 1, read);
+                else if (handlers.Write == &CopyOnWrite)
+                    SetPage(page, read, nullptr, handlers);
+                else
+                    SetPage(page, read, parent.WritePages[page], handlers);
+            }
+        }
+
+        bool IsShared(uint32 page) const
+        {
+            return Handlers[page].Write == &CopyOnWrite;
+        }
+
+        // Copies every shared page so nothing points at the parent any more. The copies count as
+        // writes, a reset puts them back to the baseline
+        void Unshare()
+        {
+            for (uint32 page = 0; page < PAGE_COUNT; ++page)
+            {
+                if (IsShared(page))
+                {
+                    MakePrivate(page);
+                    WatchedWrite(page);
+                }
+            }
+        }
+
+        EMU_FORCEINLINE Byte ReadByte(uint32 address) const
+        {
+            auto page = address / PAGE_SIZE;
+
+            if (auto const * host = ReadPages[page])
+                return host[address % PAGE_SIZE];
+
+            return ReadHandlers(page, address);
+        }
+
+        // Reads without going through device handlers, which may have side effects. Device pages
+        // read as 0
+        Byte PeekByte(uint32 address) const
+        {
+            auto const * host = ReadPages[(address / PAGE_SIZE) % PAGE_COUNT];
+            return host != nullptr ? host[address % PAGE_SIZE] : 0x00;
+        }
+
+        EMU_FORCEINLINE void WriteByte(uint32 address, Byte value)
+        {
+            auto page = address / PAGE_SIZE;
+
+            if (auto * host = WritePages[page])
+                host[address % PAGE_SIZE] = value;
+            else
+                WriteHandlers(page, address, value);
+
+            if (WatchedPages[page])
+                WatchedWrite(page);
+        }
+
+        EMU_FORCEINLINE Word ReadWord(uint32 address) const
+        {
+            auto const * host = ReadPages[address / PAGE_SIZE];
+            auto offset = address % PAGE_SIZE;
+
+            if (host != nullptr && offset != PAGE_SIZE - 1)
+                return host[offset] | host[offset + 1] << 8;
+
+            Word word = ReadByte(address);
+            word |= (((Word)ReadByte(static_cast<Word>(address + 1))) << 8);
             return word;
         }
 
-        void WriteWord(uint32 address, Word value)
+        EMU_FORCEINLINE void WriteWord(uint32 address, Word value)
+        {
+            WriteByte(address, value & 0xFF);
+            WriteByte(static_cast<Word>(address + 1), value >> 8);
+        }
+
+        void SetPage(uint32 page, Byte * read, Byte * write, PageHandlers handlers)
+        {
+            auto * own = Data + page * PAGE_SIZE;
+            auto wasRemapped = ReadPages[page] != own || WritePages[page] != own;
+            auto isRemapped = read != own || write != own;
+
+            ReadPages[page] = read;
+            WritePages[page] = write;
+            Handlers[page] = handlers;
+
+            if (isRemapped && !wasRemapped)
+                ++RemappedPages;
+            else if (!isRemapped && wasRemapped)
+                --RemappedPages;
+
+            // Whatever was decoded from this page is gone
+            InvalidatePage(page);
+        }
+
+        uint32 ResetTo(Byte const * baseline)
+        {
+            if (baseline != Baseline)
+            {
+                if (baseline == Zeroes)
+                    memset(Data, 0, MAX_MEMORY);
+                else
+                    memcpy(Data, baseline, MAX_MEMORY);
+
+                for (uint32 page = 0; page < PAGE_COUNT; ++page)
+                {
+                    if (IsDroppedOnReset(page))
+                        Unmap(page, 1);
+                    InvalidatePage(page);
+                }
+
+                Track(baseline);
+                return PAGE_COUNT;
+            }
+
+            auto restored = DirtyCount;
+            for (uint32 i = 0; i < DirtyCount; ++i)
+            {
+                auto page = DirtyPages[i];
+                if (IsDroppedOnReset(page))
+                    Unmap(page, 1);
+                memcpy(Data + page * PAGE_SIZE, baseline + page * PAGE_SIZE, PAGE_SIZE);
+                InvalidatePage(page);
+                WatchedPages[page] |= PAGE_CLEAN;
+            }
+
+            DirtyCount = 0u;
+            return restored;
+        }
+
+        void Track(Byte const * baseline)
+        {
+            Baseline = baseline;
+            DirtyCount = 0u;
+
+            for (auto & watched : WatchedPages)
+                watched |= PAGE_CLEAN;
+        }
+
+        void MakePrivate(uint32 page)
+        {
+            auto * own = Data + page * PAGE_SIZE;
+            memcpy(own, ReadPages[page], PAGE_SIZE);
+            SetPage(page, own, own, { });
+        }
+
+        bool IsDroppedOnReset(uint32 page) const
+        {
+            return IsShared(page) && Handlers[page].Context == &DropOnReset;
+        }
+
+        static inline Byte const Zeroes[MAX_MEMORY] = { };
+        static inline Byte DropOnReset = 0;     // Only its address is used, to tag mappings
+
+        static void CopyOnWrite(void *, Memory & memory, Word address, Byte value)
+        {
+            memory.MakePrivate(address / PAGE_SIZE);
+            memory.Data[address] = value;
+        }
+
+        // Slow path for pages mapped to devices, reads from a page without a handler return 0
+        EMU_NOINLINE Byte ReadHandlers(uint32 page, uint32 address) const
+        {
+            auto const & handlers = Handlers[page];
+            return handlers.Read != nullptr ? handlers.Read(handlers.Context, static_cast<Word>(address)) : 0x00;
+        }
+
+        EMU_NOINLINE void WriteHandlers(uint32 page, uint32 address, Byte value)
         {
-            Data[address] = value & 0xFF;
-            Data[address + 1] = value >> 8;
+            auto const & handlers = Handlers[page];
+            if (handlers.Write != nullptr)
+                handlers.Write(handlers.Context, *this, static_cast<Word>(address), value);
         }
     };
 
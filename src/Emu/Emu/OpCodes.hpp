@@ -0,0 +1,239 @@
+#pragma once
+
+#include <Emu/includes.hpp>
+
+
+// Expands X(OpCode) once for every opcode 0x00 - 0xFF
+#define EMU_FOR_EACH_OPCODE_ROW(X, High) \
+    X(0x##High##0) X(0x##High##1) X(0x##High##2) X(0x##High##3) \
+    X(0x##High##4) X(0x##High##5) X(0x##High##6) X(0x##High##7) \
+    X(0x##High##8) X(0x##High##9) X(0x##High##A) X(0x##High##B) \
+    X(0x##High##C) X(0x##High##D) X(0x##High##E) X(0x##High##F)
+
+#define EMU_FOR_EACH_OPCODE(X) \
+    EMU_FOR_EACH_OPCODE_ROW(X, 0) EMU_FOR_EACH_OPCODE_ROW(X, 1) \
+    EMU_FOR_EACH_OPCODE_ROW(X, 2) EMU_FOR_EACH_OPCODE_ROW(X, 3) \
+    EMU_FOR_EACH_OPCODE_ROW(X, 4) EMU_FOR_EACH_OPCODE_ROW(X, 5) \
+    EMU_FOR_EACH_OPCODE_ROW(X, 6) EMU_FOR_EACH_OPCODE_ROW(X, 7) \
+    EMU_FOR_EACH_OPCODE_ROW(X, 8) EMU_FOR_EACH_OPCODE_ROW(X, 9) \
+    EMU_FOR_EACH_OPCODE_ROW(X, A) EMU_FOR_EACH_OPCODE_ROW(X, B) \
+    EMU_FOR_EACH_OPCODE_ROW(X, C) EMU_FOR_EACH_OPCODE_ROW(X, D) \
+    EMU_FOR_EACH_OPCODE_ROW(X, E) EMU_FOR_EACH_OPCODE_ROW(X, F)
+
+
+namespace Emu
+{
+
+    enum class AddressingMode : Byte
+    {
+        Implied,
+        Immediate,
+        ZeroPage,
+        ZeroPageX,
+        ZeroPageY,
+        Absolute,
+        AbsoluteX,
+        AbsoluteY,
+        Indirect,
+        IndirectX,
+        IndirectY
+    };
+
+    enum class Operation : Byte
+    {
+        AND,
+        BIT,
+        EOR,
+        JMP,
+        JSR,
+        LDA,
+        LDX,
+        LDY,
+        ORA,
+        PHA,
+        PHP,
+        PLA,
+        PLP,
+        RTI,
+        RTS,
+        STA,
+        STX,
+        STY,
+        TSA,
+        TSX,
+        TXS
+    };
+
+    struct OpCodeDescription
+    {
+        Byte OpCode;
+        Operation Op;
+        AddressingMode Mode;
+    };
+
+
+    // Bytes taken by an instruction including the opcode
+    constexpr Byte InstructionLength(AddressingMode mode)
+    {
+        switch (mode)
+        {
+        case AddressingMode::Implied:       return 1;
+        case AddressingMode::Absolute:
+        case AddressingMode::AbsoluteX:
+        case AddressingMode::AbsoluteY:
+        case AddressingMode::Indirect:      return 3;
+        default:                            return 2;
+        }
+    }
+
+    // Reads through an indexed address take an extra cycle when the index crosses a page
+    constexpr bool HasPageCrossPenalty(Operation op, AddressingMode mode)
+    {
+        if (op == Operation::STA || op == Operation::STX || op == Operation::STY)
+            return false;
+
+        return mode == AddressingMode::AbsoluteX
+            || mode == AddressingMode::AbsoluteY
+            || mode == AddressingMode::IndirectY;
+    }
+
+    // Cycles taken by an instruction when no page boundary is crossed
+    constexpr Byte BaseCycles(Operation op, AddressingMode mode)
+    {
+        switch (op)
+        {
+        case Operation::JMP:    return mode == AddressingMode::Indirect ? 5 : 3;
+        case Operation::JSR:
+        case Operation::RTI:
+        case Operation::RTS:    return 6;
+        case Operation::PHA:
+        case Operation::PHP:    return 3;
+        case Operation::PLA:
+        case Operation::PLP:    return 4;
+        case Operation::TSA:
+        case Operation::TSX:
+        case Operation::TXS:    return 2;
+
+        case Operation::STA:
+        case Operation::STX:
+        case Operation::STY:
+            // Stores always use the extra indexing cycle
+            if (mode == AddressingMode::AbsoluteX || mode == AddressingMode::AbsoluteY)
+                return 5;
+            if (mode == AddressingMode::IndirectY)
+                return 6;
+            break;
+
+        default:
+            break;
+        }
+
+        switch (mode)
+        {
+        case AddressingMode::ZeroPage:      return 3;
+        case AddressingMode::ZeroPageX:
+        case AddressingMode::ZeroPageY:
+        case AddressingMode::Absolute:
+        case AddressingMode::AbsoluteX:
+        case AddressingMode::AbsoluteY:     return 4;
+        case AddressingMode::IndirectX:     return 6;
+        case AddressingMode::IndirectY:     return 5;
+        default:                            return 2;
+        }
+    }
+
+    constexpr char const * Mnemonic(Operation op)
+    {
+        switch (op)
+        {
+        case Operation::AND:    return "AND";
+        case Operation::BIT:    return "BIT";
+        case Operation::EOR:    return "EOR";
+        case Operation::JMP:    return "JMP";
+        case Operation::JSR:    return "JSR";
+        case Operation::LDA:    return "LDA";
+        case Operation::LDX:    return "LDX";
+        case Operation::LDY:    return "LDY";
+        case Operation::ORA:    return "ORA";
+        case Operation::PHA:    return "PHA";
+        case Operation::PHP:    return "PHP";
+        case Operation::PLA:    return "PLA";
+        case Operation::PLP:    return "PLP";
+        case Operation::RTI:    return "RTI";
+        case Operation::RTS:    return "RTS";
+        case Operation::STA:    return "STA";
+        case Operation::STX:    return "STX";
+        case Operation::STY:    return "STY";
+        case Operation::TSA:    return "TSA";
+        case Operation::TSX:    return "TSX";
+        case Operation::TXS:    return "TXS";
+        default:                return "???";
+        }
+    }
+
+    constexpr char const * ModeName(AddressingMode mode)
+    {
+        switch (mode)
+        {
+        case AddressingMode::Implied:       return "Implied";
+        case AddressingMode::Immediate:     return "Immediate";
+        case AddressingMode::ZeroPage:      return "ZeroPage";
+        case AddressingMode::ZeroPageX:     return "ZeroPageX";
+        case AddressingMode::ZeroPageY:     return "ZeroPageY";
+        case AddressingMode::Absolute:      return "Absolute";
+        case AddressingMode::AbsoluteX:     return "AbsoluteX";
+        case AddressingMode::AbsoluteY:     return "AbsoluteY";
+        case AddressingMode::Indirect:      return "Indirect";
+        case AddressingMode::IndirectX:     return "IndirectX";
+        case AddressingMode::IndirectY:     return "IndirectY";
+        default:                            return "???";
+        }
+    }
+
+
+    // Everything the interpreter, decoder, recompiler and disassembler need to know about an opcode
+    struct OpCodeInfo
+    {
+        Operation Op;
+        AddressingMode Mode;
+        Byte Length;
+        Byte Cycles;                // Without the page crossing penalty
+        bool PageCrossPenalty;
+        bool Implemented;           // Unimplemented opcodes trap after one byte and one cycle
+    };
+
+    template <size_t Count>
+    constexpr std::array<OpCodeInfo, 256> MakeOpCodeTable(OpCodeDescription const (&descriptions)[Count])
+    {
+        std::array<OpCodeInfo, 256> table{};
+
+        for (auto & info : table)
+            info = { Operation::AND, AddressingMode::Implied, 1, 1, false, false };
+
+        for (auto const & description : descriptions)
+        {
+            table[description.OpCode] = {
+                description.Op,
+                description.Mode,
+                InstructionLength(description.Mode),
+                BaseCycles(description.Op, description.Mode),
+                HasPageCrossPenalty(description.Op, description.Mode),
+                true };
+        }
+
+        return table;
+    }
+
+    // Longest any instruction can take, page crossing included
+    constexpr uint32 MaxInstructionCycles(std::array<OpCodeInfo, 256> const & table)
+    {
+        uint32 cycles = 0u;
+        for (auto const & info : table)
+        {
+            uint32 longest = info.Cycles + (info.PageCrossPenalty ? 1u : 0u);
+            cycles = longest > cycles ? longest : cycles;
+        }
+        return cycles;
+    }
+
+}
\ No newline at end of file
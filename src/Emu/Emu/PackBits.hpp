@@ -0,0 +1,90 @@
+#pragma once
+
+#include <Emu/includes.hpp>
+
+
+namespace Emu
+{
+
+    // Run length coding for data that is mostly runs, e.g. zeroed RAM or a trace column. A
+    // control byte c below 128 is followed by c + 1 literal bytes, above 128 by one byte repeated
+    // 257 - c times, 128 is skipped. Runs shorter than three are left as literals
+    struct PackBits
+    {
+        // One control byte per 128 literals in the worst case
+        static constexpr size_t MaxSize(size_t count)
+        {
+            return count + (count + 127) / 128;
+        }
+
+        // Returns the packed size, out needs room for MaxSize(count)
+        static size_t Pack(Byte const * in, size_t count, Byte * out)
+        {
+            size_t at = 0, size = 0;
+
+            while (at < count)
+            {
+                size_t run = 1;
+                while (at + run < count && run < 128 && in[at + run] == in[at])
+                    ++run;
+
+                if (run >= 3)
+                {
+                    out[size++] = static_cast<Byte>(257 - run);
+                    out[size++] = in[at];
+                    at += run;
+                    continue;
+                }
+
+                // Literals up to the next run worth packing
+                auto start = at;
+                while (at < count && at - start < 128)
+                {
+                    if (at + 2 < count && in[at] == in[at + 1] && in[at] == in[at + 2])
+                        break;
+                    ++at;
+                }
+
+                out[size++] = static_cast<Byte>(at - start - 1);
+                memcpy(out + size, in + start, at - start);
+                size += at - start;
+            }
+
+            return size;
+        }
+
+        // False unless the input decodes to exactly count bytes
+        static bool Unpack(Byte const * in, size_t size, Byte * out, size_t count)
+        {
+            size_t read = 0, written = 0;
+
+            while (read < size)
+            {
+                auto control = in[read++];
+
+                if (control < 128)
+                {
+                    size_t length = control + 1u;
+                    if (length > size - read || length > count - written)
+                        return false;
+
+                    memcpy(out + written, in + read, length);
+                    read += length;
+                    written += length;
+                }
+                else if (control > 128)
+                {
+                    size_t length = 257u - control;
+                    if (read == size || length > count - written)
+                        return false;
+
+                    memset(out + written, in[read++], length);
+                    written += length;
+                }
+            }
+
+            return written == count;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+#include <fmt/format.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/OpCodes.hpp>
+
+
+namespace Emu
+{
+
+    struct ProfileCounts
+    {
+        uint64 Executions = 0u;
+        uint64 Cycles = 0u;
+        uint64 PageCrossings = 0u;      // Executions that paid the extra indexing cycle
+
+        void Add(ProfileCounts const & other)
+        {
+            Executions += other.Executions;
+            Cycles += other.Cycles;
+            PageCrossings += other.PageCrossings;
+        }
+    };
+
+
+    // Profiling policy for CPU::ExecuteProfiled. Only the per opcode counts are kept while running,
+    // totals per addressing mode are summed from them when asked for. An instruction taking more
+    // than its base cycles has crossed a page, there are no branches to take the extra cycle for
+    // anything else
+    struct OpCodeProfiler
+    {
+        std::array<ProfileCounts, 256> OpCodes{};
+
+        void BeforeInstruction()
+        { }
+
+        void Instruction(Byte opCode, uint32 cycles)
+        {
+            auto & counts = OpCodes[opCode];
+            ++counts.Executions;
+            counts.Cycles += cycles;
+            counts.PageCrossings += cycles > CPU::OpCodeTable[opCode].Cycles ? 1u : 0u;
+        }
+
+        // Interrupt entry is not an opcode, the handler's instructions are counted as they run
+        void Interrupt(Word, uint32)
+        { }
+
+        void Reset()
+        {
+            OpCodes = { };
+        }
+
+        ProfileCounts Total() const
+        {
+            ProfileCounts total;
+            for (auto const & counts : OpCodes)
+                total.Add(counts);
+            return total;
+        }
+
+        // Unhandled opcodes are not counted against any mode
+        ProfileCounts ByMode(AddressingMode mode) const
+        {
+            ProfileCounts total;
+            for (size_t opCode = 0; opCode < OpCodes.size(); ++opCode)
+            {
+                auto const & info = CPU::OpCodeTable[opCode];
+                if (info.Implemented && info.Mode == mode)
+                    total.Add(OpCodes[opCode]);
+            }
+            return total;
+        }
+
+        // One row per opcode that ran, in opcode order
+        std::string Csv() const
+        {
+            std::string out = "opcode,mnemonic,mode,executions,cycles,page_crossings\n";
+
+            for (size_t opCode = 0; opCode < OpCodes.size(); ++opCode)
+            {
+                auto const & counts = OpCodes[opCode];
+                if (counts.Executions == 0)
+                    continue;
+
+                fmt::format_to(std::back_inserter(out), "{:02X},{},{},{},{},{}\n",
+                    opCode, MnemonicFor(opCode), ModeFor(opCode),
+                    counts.Executions, counts.Cycles, counts.PageCrossings);
+            }
+
+            return out;
+        }
+
+        // {"opcodes":[...],"modes":[...],"total":{...}}, only what ran is listed
+        std::string Json() const
+        {
+            auto counts = [](ProfileCounts const & c)
+            {
+                return fmt::format("\"executions\":{},\"cycles\":{},\"page_crossings\":{}",
+                    c.Executions, c.Cycles, c.PageCrossings);
+            };
+
+            std::string out = "{\"opcodes\":[";
+            auto separator = "";
+
+            for (size_t opCode = 0; opCode < OpCodes.size(); ++opCode)
+            {
+                if (OpCodes[opCode].Executions == 0)
+                    continue;
+
+                fmt::format_to(std::back_inserter(out), "{}{{\"opcode\":{},\"mnemonic\":\"{}\",\"mode\":\"{}\",{}}}",
+                    separator, opCode, MnemonicFor(opCode), ModeFor(opCode), counts(OpCodes[opCode]));
+                separator = ",";
+            }
+
+            out += "],\"modes\":[";
+            separator = "";
+
+            for (auto mode : Modes)
+            {
+                auto total = ByMode(mode);
+                if (total.Executions == 0)
+                    continue;
+
+                fmt::format_to(std::back_inserter(out), "{}{{\"mode\":\"{}\",{}}}", separator, ModeName(mode), counts(total));
+                separator = ",";
+            }
+
+            fmt::format_to(std::back_inserter(out), "],\"total\":{{{}}}}}", counts(Total()));
+            return out;
+        }
+
+        // Opcodes by cycles spent, most first, then the totals per mode
+        std::string Table() const
+        {
+            auto total = Total();
+            auto share = [&total](uint64 cycles)
+            {
+                return total.Cycles == 0 ? 0.0 : 100.0 * static_cast<double>(cycles) / static_cast<double>(total.Cycles);
+            };
+
+            std::array<Byte, 256> order;
+            for (size_t i = 0; i < order.size(); ++i)
+                order[i] = static_cast<Byte>(i);
+
+            std::stable_sort(order.begin(), order.end(), [this](Byte left, Byte right)
+            {
+                return OpCodes[left].Cycles > OpCodes[right].Cycles;
+            });
+
+            std::string out = fmt::format("{:<6} {:<4} {:<10} {:>14} {:>14} {:>12} {:>7}\n",
+                "OpCode", "Op", "Mode", "Executions", "Cycles", "PageCross", "Cycles%");
+
+            for (auto opCode : order)
+            {
+                auto const & counts = OpCodes[opCode];
+                if (counts.Executions == 0)
+                    break;
+
+                fmt::format_to(std::back_inserter(out), "${:02X}    {:<4} {:<10} {:>14} {:>14} {:>12} {:>6.2f}%\n",
+                    opCode, MnemonicFor(opCode), ModeFor(opCode),
+                    counts.Executions, counts.Cycles, counts.PageCrossings, share(counts.Cycles));
+            }
+
+            fmt::format_to(std::back_inserter(out), "\n{:<10} {:>14} {:>14} {:>12} {:>7}\n",
+                "Mode", "Executions", "Cycles", "PageCross", "Cycles%");
+
+            for (auto mode : Modes)
+            {
+                auto counts = ByMode(mode);
+                if (counts.Executions == 0)
+                    continue;
+
+                fmt::format_to(std::back_inserter(out), "{:<10} {:>14} {:>14} {:>12} {:>6.2f}%\n",
+                    ModeName(mode), counts.Executions, counts.Cycles, counts.PageCrossings, share(counts.Cycles));
+            }
+
+            fmt::format_to(std::back_inserter(out), "{:<10} {:>14} {:>14} {:>12}",
+                "Total", total.Executions, total.Cycles, total.PageCrossings);
+            return out;
+        }
+
+        static constexpr AddressingMode Modes[] = {
+            AddressingMode::Implied, AddressingMode::Immediate,
+            AddressingMode::ZeroPage, AddressingMode::ZeroPageX, AddressingMode::ZeroPageY,
+            AddressingMode::Absolute, AddressingMode::AbsoluteX, AddressingMode::AbsoluteY,
+            AddressingMode::Indirect, AddressingMode::IndirectX, AddressingMode::IndirectY };
+
+        static char const * MnemonicFor(size_t opCode)
+        {
+            auto const & info = CPU::OpCodeTable[opCode];
+            return info.Implemented ? Mnemonic(info.Op) : "???";
+        }
+
+        static char const * ModeFor(size_t opCode)
+        {
+            auto const & info = CPU::OpCodeTable[opCode];
+            return info.Implemented ? ModeName(info.Mode) : "-";
+        }
+    };
+
+
+    template <typename TProfiler>
+    void CPU::DumpState(TProfiler const & profiler)
+    {
+        DumpState();
+        fmt::print("\n\n{}", profiler.Table());
+    }
+
+}
\ No newline at end of file
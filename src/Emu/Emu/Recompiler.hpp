@@ -0,0 +1,656 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include <Emu/BlockCache.hpp>
+#include <Emu/CPU.hpp>
+#include <Emu/ExecutableMemory.hpp>
+#include <Emu/Memory.hpp>
+
+
+namespace Emu
+{
+
+    // Minimal x86-64 encoder covering the forms the recompiler emits, all arithmetic is 32-bit
+    struct X64Emitter
+    {
+        enum Reg : Byte { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11 };
+
+        std::vector<Byte> Code;
+
+        void Emit(Byte value) { Code.push_back(value); }
+
+        void Emit16(Word value)
+        {
+            Emit(value & 0xFF);
+            Emit(value >> 8);
+        }
+
+        void Emit32(uint32 value)
+        {
+            for (int i = 0; i < 4; ++i)
+                Emit((value >> (i * 8)) & 0xFF);
+        }
+
+        // Byte access to SPL - DIL needs an empty REX prefix
+        static constexpr bool NeedsByteRex(Reg reg) { return reg >= RSP && reg <= RDI; }
+
+        void Rex(Byte reg, Byte index, Byte base, bool wide = false, bool force = false)
+        {
+            Byte rex = 0x40 | (wide ? 0x08 : 0) | ((reg & 8) >> 1) | ((index & 8) >> 2) | ((base & 8) >> 3);
+            if (rex != 0x40 || force)
+                Emit(rex);
+        }
+
+        void ModRM(Byte mod, Byte reg, Byte rm) { Emit((mod << 6) | ((reg & 7) << 3) | (rm & 7)); }
+
+        // [base + index + disp]
+        void Sib(Byte reg, Reg base, Reg index, int32 disp)
+        {
+            bool noDisp = disp == 0 && (base & 7) != RBP;
+            ModRM(noDisp ? 0 : 2, reg, 4);
+            Emit(((index & 7) << 3) | (base & 7));
+            if (!noDisp)
+                Emit32(static_cast<uint32>(disp));
+        }
+
+        // [base + disp8]
+        void Field(Byte reg, Reg base, Byte disp)
+        {
+            ModRM(1, reg, base);
+            Emit(disp);
+        }
+
+        void RegReg(Byte opCode, Reg rm, Reg reg)
+        {
+            Rex(reg, 0, rm);
+            Emit(opCode);
+            ModRM(3, reg, rm);
+        }
+
+        void Mov(Reg dst, Reg src)  { RegReg(0x89, dst, src); }
+        void Add(Reg dst, Reg src)  { RegReg(0x01, dst, src); }
+        void Or(Reg dst, Reg src)   { RegReg(0x09, dst, src); }
+        void And(Reg dst, Reg src)  { RegReg(0x21, dst, src); }
+        void Xor(Reg dst, Reg src)  { RegReg(0x31, dst, src); }
+        void Test(Reg dst, Reg src) { RegReg(0x85, dst, src); }
+
+        void RegImm(Byte extension, Reg rm, uint32 value)
+        {
+            Rex(0, 0, rm);
+            Emit(0x81);
+            ModRM(3, extension, rm);
+            Emit32(value);
+        }
+
+        void AddImm(Reg dst, uint32 value) { RegImm(0, dst, value); }
+        void OrImm(Reg dst, uint32 value)  { RegImm(1, dst, value); }
+        void AndImm(Reg dst, uint32 value) { RegImm(4, dst, value); }
+        void SubImm(Reg dst, uint32 value) { RegImm(5, dst, value); }
+
+        void MovImm(Reg dst, uint32 value)
+        {
+            Rex(0, 0, dst);
+            Emit(0xB8 + (dst & 7));
+            Emit32(value);
+        }
+
+        void Shift(Byte extension, Reg dst, Byte count)
+        {
+            Rex(0, 0, dst);
+            Emit(0xC1);
+            ModRM(3, extension, dst);
+            Emit(count);
+        }
+
+        void Shl(Reg dst, Byte count) { Shift(4, dst, count); }
+        void Shr(Reg dst, Byte count) { Shift(5, dst, count); }
+
+        void SetZ(Reg dst)
+        {
+            Rex(0, 0, dst, false, NeedsByteRex(dst));
+            Emit(0x0F);
+            Emit(0x94);
+            ModRM(3, 0, dst);
+        }
+
+        void MovzxByte(Reg dst, Reg src)
+        {
+            Rex(dst, 0, src, false, NeedsByteRex(src));
+            Emit(0x0F);
+            Emit(0xB6);
+            ModRM(3, dst, src);
+        }
+
+        void LoadByte(Reg dst, Reg base, Reg index, int32 disp = 0)
+        {
+            Rex(dst, index, base);
+            Emit(0x0F);
+            Emit(0xB6);
+            Sib(dst, base, index, disp);
+        }
+
+        void LoadWord(Reg dst, Reg base, Reg index, int32 disp = 0)
+        {
+            Rex(dst, index, base);
+            Emit(0x0F);
+            Emit(0xB7);
+            Sib(dst, base, index, disp);
+        }
+
+        void StoreByte(Reg src, Reg base, Reg index, int32 disp = 0)
+        {
+            Rex(src, index, base, false, NeedsByteRex(src));
+            Emit(0x88);
+            Sib(src, base, index, disp);
+        }
+
+        void StoreWordImm(Reg base, Reg index, Word value)
+        {
+            Emit(0x66);
+            Rex(0, index, base);
+            Emit(0xC7);
+            Sib(0, base, index, 0);
+            Emit16(value);
+        }
+
+        void CmpByteImm(Reg base, Reg index, int32 disp, Byte value)
+        {
+            Rex(7, index, base);
+            Emit(0x80);
+            Sib(7, base, index, disp);
+            Emit(value);
+        }
+
+        void LoadField(Reg dst, Reg base, Byte disp)
+        {
+            Rex(dst, 0, base);
+            Emit(0x0F);
+            Emit(0xB6);
+            Field(dst, base, disp);
+        }
+
+        void StoreField(Reg src, Reg base, Byte disp)
+        {
+            Rex(src, 0, base, false, NeedsByteRex(src));
+            Emit(0x88);
+            Field(src, base, disp);
+        }
+
+        void StoreFieldWord(Reg src, Reg base, Byte disp)
+        {
+            Emit(0x66);
+            Rex(src, 0, base);
+            Emit(0x89);
+            Field(src, base, disp);
+        }
+
+        void StoreFieldWordImm(Reg base, Byte disp, Word value)
+        {
+            Emit(0x66);
+            Rex(0, 0, base);
+            Emit(0xC7);
+            Field(0, base, disp);
+            Emit16(value);
+        }
+
+        void MovWide(Reg dst, Reg src)
+        {
+            Rex(src, 0, dst, true);
+            Emit(0x89);
+            ModRM(3, src, dst);
+        }
+
+        void Push(Reg reg)
+        {
+            Rex(0, 0, reg);
+            Emit(0x50 + (reg & 7));
+        }
+
+        void Pop(Reg reg)
+        {
+            Rex(0, 0, reg);
+            Emit(0x58 + (reg & 7));
+        }
+
+        void Ret() { Emit(0xC3); }
+
+        // Jumps return the offset of their rel32 for Bind
+        size_t Jne()
+        {
+            Emit(0x0F);
+            Emit(0x85);
+            Emit32(0);
+            return Code.size() - 4;
+        }
+
+        size_t Jmp()
+        {
+            Emit(0xE9);
+            Emit32(0);
+            return Code.size() - 4;
+        }
+
+        // Points the jump at the current position
+        void Bind(size_t patch)
+        {
+            auto rel = static_cast<uint32>(Code.size() - (patch + 4));
+            for (int i = 0; i < 4; ++i)
+                Code[patch + i] = (rel >> (i * 8)) & 0xFF;
+        }
+    };
+
+
+    // Turns hot decoded blocks into x86-64 code, A/X/Y/SP/Status live in host registers for the
+    // whole block and the cycle count is returned once at the end. Writes that would land on a
+    // page holding decoded code leave the block before the store so the interpreter can handle
+    // the invalidation.
+    struct Recompiler
+    {
+        static constexpr uint32 DEFAULT_HOT_THRESHOLD = 8u;
+        static constexpr size_t CODE_CAPACITY = 4 * 1024 * 1024;
+
+        BlockCache Cache;
+        ExecutableMemory Code { CODE_CAPACITY };
+        uint32 HotThreshold = DEFAULT_HOT_THRESHOLD;
+
+        using Reg = X64Emitter::Reg;
+
+        static constexpr Reg RegCPU         = X64Emitter::RDI;
+        static constexpr Reg RegMemory      = X64Emitter::RSI;
+        static constexpr Reg RegStatus      = X64Emitter::RDX;
+        static constexpr Reg RegPenalty     = X64Emitter::RBX;
+        static constexpr Reg RegA           = X64Emitter::R8;
+        static constexpr Reg RegX           = X64Emitter::R9;
+        static constexpr Reg RegY           = X64Emitter::R10;
+        static constexpr Reg RegSP          = X64Emitter::R11;
+        static constexpr Reg Scratch        = X64Emitter::RAX;
+        static constexpr Reg Address        = X64Emitter::RCX;
+
+        static constexpr Byte OffsetPC      = static_cast<Byte>(offsetof(CPU, PC));
+        static constexpr Byte OffsetSP      = static_cast<Byte>(offsetof(CPU, SP));
+        static constexpr Byte OffsetA       = static_cast<Byte>(offsetof(CPU, A));
+        static constexpr Byte OffsetX       = static_cast<Byte>(offsetof(CPU, X));
+        static constexpr Byte OffsetY       = static_cast<Byte>(offsetof(CPU, Y));
+        static constexpr Byte OffsetStatus  = static_cast<Byte>(offsetof(CPU, Status));
+        static constexpr int32 OffsetWatchedPages = static_cast<int32>(offsetof(Memory, WatchedPages));
+
+        struct SideExit
+        {
+            size_t Patch;
+            Word PC;
+            uint32 Cycles;
+        };
+
+        // Z and N from a register holding a byte value, clobbers Scratch
+        static void EmitSetZeroNegative(X64Emitter & e, Reg value)
+        {
+            e.AndImm(RegStatus, 0x7D);
+            e.Test(value, value);
+            e.SetZ(Scratch);
+            e.MovzxByte(Scratch, Scratch);
+            e.Shl(Scratch, 1);
+            e.Or(RegStatus, Scratch);
+            e.Mov(Scratch, value);
+            e.AndImm(Scratch, 0x80);
+            e.Or(RegStatus, Scratch);
+        }
+
+        // Adds one to the penalty count when low + index carries into the next page, clobbers Scratch
+        static void EmitPageCrossPenalty(X64Emitter & e, Reg low, Reg index)
+        {
+            e.Mov(Scratch, low);
+            e.AndImm(Scratch, 0xFF);
+            e.Add(Scratch, index);
+            e.Shr(Scratch, 8);
+            e.Add(RegPenalty, Scratch);
+        }
+
+        // Leaves the effective address in Address
+        static void EmitAddress(X64Emitter & e, AddressingMode mode, Word operand, bool penalty)
+        {
+            switch (mode)
+            {
+            case AddressingMode::ZeroPage:
+            case AddressingMode::Absolute:
+                e.MovImm(Address, operand);
+                break;
+
+            case AddressingMode::ZeroPageX:
+            case AddressingMode::ZeroPageY:
+                e.Mov(Address, mode == AddressingMode::ZeroPageX ? RegX : RegY);
+                e.AddImm(Address, operand);
+                e.AndImm(Address, 0xFF);
+                break;
+
+            case AddressingMode::AbsoluteX:
+            case AddressingMode::AbsoluteY:
+            {
+                auto index = mode == AddressingMode::AbsoluteX ? RegX : RegY;
+                e.MovImm(Address, operand);
+                if (penalty)
+                    EmitPageCrossPenalty(e, Address, index);
+                e.Add(Address, index);
+                e.AndImm(Address, 0xFFFF);
+            } break;
+
+            case AddressingMode::Indirect:
+                e.MovImm(Address, operand);
+                e.LoadWord(Address, RegMemory, Address);
+                break;
+
+            case AddressingMode::IndirectX:
+                e.Mov(Address, RegX);
+                e.AddImm(Address, operand);
+                e.LoadWord(Address, RegMemory, Address);
+                break;
+
+            case AddressingMode::IndirectY:
+                e.MovImm(Address, operand);
+                e.LoadWord(Address, RegMemory, Address);
+                if (penalty)
+                    EmitPageCrossPenalty(e, Address, RegY);
+                e.Add(Address, RegY);
+                e.AndImm(Address, 0xFFFF);
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        // Operand value in Scratch
+        static void EmitOperand(X64Emitter & e, AddressingMode mode, Word operand, bool penalty)
+        {
+            if (mode == AddressingMode::Immediate)
+            {
+                e.MovImm(Scratch, operand & 0xFF);
+                return;
+            }
+
+            EmitAddress(e, mode, operand, penalty);
+            e.LoadByte(Scratch, RegMemory, Address);
+        }
+
+        // Side exit when the page of Address + offset is watched, i.e. holds decoded code or has
+        // not been written since the last checkpoint, clobbers Scratch
+        static void EmitWatchedPageCheck(X64Emitter & e, std::vector<SideExit> & exits, Word pc, uint32 cycles, uint32 offset = 0)
+        {
+            e.Mov(Scratch, Address);
+            if (offset != 0)
+                e.AddImm(Scratch, offset);
+            e.Shr(Scratch, 8);
+            e.CmpByteImm(RegMemory, Scratch, OffsetWatchedPages, 0);
+            exits.push_back({ e.Jne(), pc, cycles });
+        }
+
+        static void EmitStackAddress(X64Emitter & e)
+        {
+            e.Mov(Address, RegSP);
+            e.OrImm(Address, 0x100);
+        }
+
+        // Returns false for blocks the recompiler cannot handle, those stay on the interpreter
+        bool Compile(DecodedBlock & block)
+        {
+#if EMU_RECOMPILER
+            if (Code.Data == nullptr)
+                return false;
+
+            X64Emitter e;
+            std::vector<SideExit> exits;
+            std::vector<size_t> epilogueJumps;
+
+            e.Push(X64Emitter::RBX);
+#if defined(_WIN32)
+            e.Push(X64Emitter::RSI);
+            e.Push(X64Emitter::RDI);
+            e.MovWide(RegCPU, X64Emitter::RCX);
+            e.MovWide(RegMemory, X64Emitter::RDX);
+#endif
+            e.Xor(RegPenalty, RegPenalty);
+            e.LoadField(RegA, RegCPU, OffsetA);
+            e.LoadField(RegX, RegCPU, OffsetX);
+            e.LoadField(RegY, RegCPU, OffsetY);
+            e.LoadField(RegSP, RegCPU, OffsetSP);
+            e.LoadField(RegStatus, RegCPU, OffsetStatus);
+
+            Word pc = block.Address;
+            uint32 cycles = 0u;
+            bool dynamicPC = false;
+
+            for (Byte i = 0; i < block.Count; ++i)
+            {
+                auto const & op = block.Ops[i];
+                auto const & info = CPU::OpCodeTable[op.OpCode];
+
+                // Native code reads Data directly so the interpreter keeps the wrap at the top of memory
+                if (!info.Implemented || (info.Mode == AddressingMode::Indirect && op.Operand == 0xFFFF))
+                    return false;
+
+                auto mode = info.Mode;
+                auto penalty = info.PageCrossPenalty;
+                Word next = pc + op.Length;
+
+                switch (info.Op)
+                {
+                case Operation::LDA:
+                case Operation::LDX:
+                case Operation::LDY:
+                {
+                    auto reg = info.Op == Operation::LDA ? RegA : info.Op == Operation::LDX ? RegX : RegY;
+                    EmitOperand(e, mode, op.Operand, penalty);
+                    e.Mov(reg, Scratch);
+                    EmitSetZeroNegative(e, reg);
+                } break;
+
+                case Operation::AND:
+                case Operation::ORA:
+                case Operation::EOR:
+                    EmitOperand(e, mode, op.Operand, penalty);
+                    if (info.Op == Operation::AND)
+                        e.And(RegA, Scratch);
+                    else if (info.Op == Operation::ORA)
+                        e.Or(RegA, Scratch);
+                    else
+                        e.Xor(RegA, Scratch);
+                    EmitSetZeroNegative(e, RegA);
+                    break;
+
+                case Operation::BIT:
+                    EmitOperand(e, mode, op.Operand, penalty);
+                    e.AndImm(RegStatus, 0x3D);
+                    e.Mov(Address, Scratch);
+                    e.AndImm(Address, 0xC0);
+                    e.Or(RegStatus, Address);
+                    e.Test(Scratch, RegA);
+                    e.SetZ(Address);
+                    e.MovzxByte(Address, Address);
+                    e.Shl(Address, 1);
+                    e.Or(RegStatus, Address);
+                    break;
+
+                case Operation::STA:
+                case Operation::STX:
+                case Operation::STY:
+                {
+                    auto reg = info.Op == Operation::STA ? RegA : info.Op == Operation::STX ? RegX : RegY;
+                    EmitAddress(e, mode, op.Operand, false);
+                    EmitWatchedPageCheck(e, exits, pc, cycles);
+                    e.StoreByte(reg, RegMemory, Address);
+                } break;
+
+                case Operation::PHA:
+                case Operation::PHP:
+                    EmitStackAddress(e);
+                    EmitWatchedPageCheck(e, exits, pc, cycles);
+                    e.StoreByte(info.Op == Operation::PHA ? RegA : RegStatus, RegMemory, Address);
+                    e.SubImm(RegSP, 1);
+                    e.AndImm(RegSP, 0xFF);
+                    break;
+
+                case Operation::PLA:
+                case Operation::PLP:
+                    e.AddImm(RegSP, 1);
+                    e.AndImm(RegSP, 0xFF);
+                    EmitStackAddress(e);
+                    e.LoadByte(info.Op == Operation::PLA ? RegA : RegStatus, RegMemory, Address);
+                    EmitSetZeroNegative(e, RegA);
+                    break;
+
+                case Operation::TSA:
+                    e.Mov(RegA, RegSP);
+                    EmitSetZeroNegative(e, RegA);
+                    break;
+
+                case Operation::TSX:
+                    e.Mov(RegX, RegSP);
+                    EmitSetZeroNegative(e, RegX);
+                    break;
+
+                case Operation::TXS:
+                    e.Mov(RegSP, RegX);
+                    break;
+
+                case Operation::JMP:
+                    if (mode == AddressingMode::Indirect)
+                    {
+                        EmitAddress(e, mode, op.Operand, false);
+                        e.StoreFieldWord(Address, RegCPU, OffsetPC);
+                        dynamicPC = true;
+                    }
+                    else
+                    {
+                        next = op.Operand;
+                    }
+                    break;
+
+                case Operation::JSR:
+                    EmitStackAddress(e);
+                    e.SubImm(Address, 1);
+                    EmitWatchedPageCheck(e, exits, pc, cycles);
+                    EmitWatchedPageCheck(e, exits, pc, cycles, 1);
+                    e.StoreWordImm(RegMemory, Address, static_cast<Word>(next - 1));
+                    e.SubImm(RegSP, 2);
+                    e.AndImm(RegSP, 0xFF);
+                    next = op.Operand;
+                    break;
+
+                case Operation::RTI:
+                    // Left to the interpreter along with the rest of the block
+                    return false;
+
+                case Operation::RTS:
+                    EmitStackAddress(e);
+                    e.AddImm(Address, 1);
+                    e.LoadWord(Scratch, RegMemory, Address);
+                    e.AddImm(Scratch, 1);
+                    e.StoreFieldWord(Scratch, RegCPU, OffsetPC);
+                    e.AddImm(RegSP, 2);
+                    e.AndImm(RegSP, 0xFF);
+                    dynamicPC = true;
+                    break;
+                }
+
+                cycles += op.Cycles;
+                pc = next;
+            }
+
+            if (!dynamicPC)
+                e.StoreFieldWordImm(RegCPU, OffsetPC, pc);
+            e.MovImm(Scratch, cycles);
+            epilogueJumps.push_back(e.Jmp());
+
+            for (auto const & exit : exits)
+            {
+                e.Bind(exit.Patch);
+                e.StoreFieldWordImm(RegCPU, OffsetPC, exit.PC);
+                e.MovImm(Scratch, exit.Cycles);
+                epilogueJumps.push_back(e.Jmp());
+            }
+
+            for (auto patch : epilogueJumps)
+                e.Bind(patch);
+
+            e.StoreField(RegA, RegCPU, OffsetA);
+            e.StoreField(RegX, RegCPU, OffsetX);
+            e.StoreField(RegY, RegCPU, OffsetY);
+            e.StoreField(RegSP, RegCPU, OffsetSP);
+            e.StoreField(RegStatus, RegCPU, OffsetStatus);
+            e.Add(Scratch, RegPenalty);
+#if defined(_WIN32)
+            e.Pop(X64Emitter::RDI);
+            e.Pop(X64Emitter::RSI);
+#endif
+            e.Pop(X64Emitter::RBX);
+            e.Ret();
+
+            auto * code = Code.Allocate(e.Code.size());
+            if (code == nullptr)
+            {
+                // Out of space, drop all compiled code and let the other blocks warm up again
+                Code.Reset();
+                Cache.DropNative();
+                code = Code.Allocate(e.Code.size());
+
+                if (code == nullptr)
+                    return false;
+            }
+
+            memcpy(code, e.Code.data(), e.Code.size());
+            block.Native = reinterpret_cast<NativeBlock>(code);
+            return true;
+#else
+            return false;
+#endif
+        }
+    };
+
+
+    static_assert(std::is_standard_layout_v<CPU>, "Recompiled code addresses CPU fields by offset");
+    static_assert(std::is_standard_layout_v<Memory>, "Recompiled code addresses Memory fields by offset");
+
+
+    // Hot blocks run as native code while enough cycles remain to finish them, everything
+    // else is replayed from the block cache
+    inline uint32 CPU::Execute(uint32 cycles, Memory & memory, Recompiler & recompiler)
+    {
+        return Budgeted(cycles, [&](uint32 budget) { return RunRecompiled(budget, memory, recompiler); });
+    }
+
+    inline uint32 CPU::RunRecompiled(uint32 budget, Memory & memory, Recompiler & recompiler)
+    {
+        uint32 cycles = budget;
+
+        while (HasCycles(cycles))
+        {
+            auto * found = recompiler.Cache.Find(PC, memory);
+            auto & block = found ? *found : DecodeBlock(recompiler.Cache, memory);
+
+            // Native code addresses Data directly so it only runs while nothing is mapped over it
+            if (block.Native != nullptr && cycles >= block.MaxCycles && memory.IsFlat())
+            {
+                // Native code keeps the flags in Status
+                SyncStatus();
+
+                // Nothing used means a side exit on the first instruction, replay it instead
+                auto used = block.Native(this, &memory);
+                cycles -= used;
+
+                if (used != 0u)
+                    continue;
+            }
+
+            if (++block.ExecutionCount == recompiler.HotThreshold)
+                recompiler.Compile(block);
+
+            if (!ReplayBlock(block, cycles, memory))
+                break;
+        }
+
+        return Leave(budget - cycles);
+    }
+
+}
\ No newline at end of file
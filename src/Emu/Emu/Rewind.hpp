@@ -0,0 +1,272 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+#include <Emu/SaveState.hpp>
+
+
+namespace Emu
+{
+
+    // Bounded history of a run for stepping back while debugging. Every KeyframeInterval cycles
+    // it takes a full save state, in between every DeltaInterval cycles only the registers and
+    // the pages that changed, each as the PackBits packed XOR against the page at the previous
+    // capture. Any cycle from the oldest keyframe on is reached by restoring that keyframe,
+    // applying the deltas up to the cycle and executing the rest. Whole keyframes with their
+    // deltas are dropped oldest first to stay under MemoryCap, at least the newest is kept.
+    // Only the CPU and memory are captured, runs have to be deterministic from them
+    struct RewindBuffer
+    {
+        struct Delta
+        {
+            SaveState::Registers Cpu;
+            std::vector<Byte> Pages;    // Page number, little endian packed size, packed XOR
+        };
+
+        struct Keyframe
+        {
+            uint64 Cycle;
+            RomImage State;
+            std::vector<Delta> Deltas;  // Oldest first
+        };
+
+        uint64 KeyframeInterval;
+        uint64 DeltaInterval;
+        size_t MemoryCap;
+
+        std::deque<Keyframe> Keyframes;
+        std::vector<Byte> Previous;     // RAM at the newest capture, what deltas are taken against
+        size_t MemoryUsed;
+
+        RewindBuffer(uint64 keyframeInterval = 1000000u, uint64 deltaInterval = 50000u, size_t memoryCap = 32 * 1024 * 1024)
+            : KeyframeInterval(keyframeInterval), DeltaInterval(deltaInterval), MemoryCap(memoryCap), Previous(Memory::MAX_MEMORY)
+        {
+            MemoryUsed = Previous.size();
+        }
+
+        bool IsEmpty() const
+        {
+            return Keyframes.empty();
+        }
+
+        // Earliest cycle Seek can reach
+        uint64 OldestCycle() const
+        {
+            return Keyframes.front().Cycle;
+        }
+
+        uint64 NewestCycle() const
+        {
+            auto const & newest = Keyframes.back();
+            return newest.Deltas.empty() ? newest.Cycle : newest.Deltas.back().Cpu.TotalCycles;
+        }
+
+        // Runs until TotalCycles reaches target capturing every DeltaInterval cycles on the way.
+        // A CPU that is not where the last capture left it is captured first, history past it is
+        // dropped. False when an unhandled instruction stopped the run
+        bool Run(CPU & cpu, Memory & memory, uint64 target)
+        {
+            if (IsEmpty() || cpu.TotalCycles != NewestCycle())
+                Capture(cpu, memory);
+
+            while (cpu.TotalCycles < target)
+            {
+                auto next = NewestCycle() + DeltaInterval;
+                auto stop = std::min(target, next);
+
+                cpu.ExecuteUntil(stop, memory);
+                if (cpu.TotalCycles < stop)
+                    return false;
+
+                if (cpu.TotalCycles >= next)
+                    Capture(cpu, memory);
+            }
+
+            return true;
+        }
+
+        // Adds the machine as it is now, a keyframe when one is due. Captures at or after its
+        // cycle are from a timeline that was rewound away from and are dropped first
+        void Capture(CPU const & cpu, Memory const & memory)
+        {
+            auto cycle = cpu.TotalCycles;
+            auto keyframe = Truncate(cycle) || IsEmpty() || cycle >= Keyframes.back().Cycle + KeyframeInterval;
+
+            if (!keyframe)
+            {
+                auto delta = TakeDelta(cpu, memory);
+                auto size = Size(delta);
+
+                // A lone keyframe cannot be dropped to make room, start the next one instead
+                if (Keyframes.size() > 1 || MemoryUsed + size <= MemoryCap)
+                {
+                    MemoryUsed += size;
+                    Keyframes.back().Deltas.push_back(std::move(delta));
+                }
+                else
+                {
+                    keyframe = true;
+                }
+            }
+
+            if (keyframe)
+            {
+                Keyframes.push_back({ cycle, RomImage(SaveState::Save(cpu, memory)), { } });
+                MemoryUsed += Size(Keyframes.back());
+
+                for (uint32 page = 0; page < Memory::PAGE_COUNT; ++page)
+                    memcpy(Previous.data() + page * Memory::PAGE_SIZE, SaveState::PageSource(memory, page), Memory::PAGE_SIZE);
+            }
+
+            while (MemoryUsed > MemoryCap && Keyframes.size() > 1)
+            {
+                MemoryUsed -= Size(Keyframes.front());
+                Keyframes.pop_front();
+            }
+        }
+
+        // Puts the machine at the first instruction boundary at or after cycle. False, leaving the
+        // machine alone, if cycle is before the oldest keyframe. Also false, with the machine
+        // wherever it got to, if the history does not decode or an unhandled instruction stops
+        // the run short of cycle. Pages are left private, nothing points into the history
+        // afterwards and every page Seek writes is marked dirty for resets
+        bool Seek(CPU & cpu, Memory & memory, uint64 cycle)
+        {
+            if (IsEmpty() || cycle < OldestCycle())
+                return false;
+
+            auto keyframe = std::prev(std::upper_bound(Keyframes.begin(), Keyframes.end(), cycle,
+                [](uint64 value, Keyframe const & frame) { return value < frame.Cycle; }));
+
+            if (!SaveState::Restore(keyframe->State, cpu, memory))
+                return false;
+            memory.Unshare();
+
+            for (auto const & delta : keyframe->Deltas)
+            {
+                if (delta.Cpu.TotalCycles > cycle)
+                    break;
+
+                if (!Apply(delta, memory))
+                    return false;
+                delta.Cpu.ApplyTo(cpu);
+            }
+
+            cpu.ExecuteUntil(cycle, memory);
+            if (cpu.TotalCycles < cycle)
+                return false;
+
+            // Landing past cycle is what was asked for, not an overflow
+            cpu.DebugFlags.CycleOverflow = 0;
+            return true;
+        }
+
+        void Clear()
+        {
+            Keyframes.clear();
+            MemoryUsed = Previous.size();
+        }
+
+        // Drops captures at or after cycle, true if there were any
+        bool Truncate(uint64 cycle)
+        {
+            auto truncated = false;
+
+            while (!IsEmpty())
+            {
+                auto & newest = Keyframes.back();
+                if (newest.Cycle >= cycle)
+                {
+                    MemoryUsed -= Size(newest);
+                    Keyframes.pop_back();
+                    truncated = true;
+                    continue;
+                }
+
+                while (!newest.Deltas.empty() && newest.Deltas.back().Cpu.TotalCycles >= cycle)
+                {
+                    MemoryUsed -= Size(newest.Deltas.back());
+                    newest.Deltas.pop_back();
+                    truncated = true;
+                }
+                break;
+            }
+
+            return truncated;
+        }
+
+        // Packs the pages that differ from Previous and brings Previous up to date
+        Delta TakeDelta(CPU const & cpu, Memory const & memory)
+        {
+            Delta delta { SaveState::Registers::From(cpu), { } };
+            Byte changes[Memory::PAGE_SIZE];
+            Byte packed[SaveState::MAX_PACKED_SIZE];
+
+            for (uint32 page = 0; page < Memory::PAGE_COUNT; ++page)
+            {
+                auto const * current = SaveState::PageSource(memory, page);
+                auto * previous = Previous.data() + page * Memory::PAGE_SIZE;
+
+                if (memcmp(current, previous, Memory::PAGE_SIZE) == 0)
+                    continue;
+
+                for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+                    changes[i] = current[i] ^ previous[i];
+                memcpy(previous, current, Memory::PAGE_SIZE);
+
+                auto size = SaveState::Pack(changes, packed);
+                delta.Pages.push_back(static_cast<Byte>(page));
+                delta.Pages.push_back(static_cast<Byte>(size));
+                delta.Pages.push_back(static_cast<Byte>(size >> 8));
+                delta.Pages.insert(delta.Pages.end(), packed, packed + size);
+            }
+
+            delta.Pages.shrink_to_fit();
+            return delta;
+        }
+
+        // Pages have to be private, Seek unshares them before the first delta. False if a page
+        // runs past the end of the delta or does not unpack, pages before it are already applied
+        static bool Apply(Delta const & delta, Memory & memory)
+        {
+            Byte changes[Memory::PAGE_SIZE];
+
+            for (size_t at = 0; at < delta.Pages.size(); )
+            {
+                if (delta.Pages.size() - at < 3)
+                    return false;
+
+                uint32 page = delta.Pages[at];
+                uint32 size = delta.Pages[at + 1] | delta.Pages[at + 2] << 8;
+                if (delta.Pages.size() - at - 3 < size || !SaveState::Unpack(delta.Pages.data() + at + 3, size, changes))
+                    return false;
+                at += 3 + size;
+
+                auto * own = memory.Data + page * Memory::PAGE_SIZE;
+                for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+                    own[i] ^= changes[i];
+
+                memory.WatchedWrite(page);
+            }
+
+            return true;
+        }
+
+        static size_t Size(Delta const & delta)
+        {
+            return sizeof(Delta) + delta.Pages.size();
+        }
+
+        static size_t Size(Keyframe const & keyframe)
+        {
+            auto size = sizeof(Keyframe) + keyframe.State.Size;
+            for (auto const & delta : keyframe.Deltas)
+                size += Size(delta);
+            return size;
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <vector>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Loader.hpp>
+#include <Emu/Memory.hpp>
+#include <Emu/PackBits.hpp>
+
+
+namespace Emu
+{
+
+    // Versioned binary machine state: a fixed header with the registers, the cycle count and a
+    // table saying where each page of RAM is in the file, then the page contents. Pages are
+    // stored one of three ways, left out when all zero, packed with PackBits when that is
+    // smaller, or as the raw 256 bytes. Restoring a mapped file points RAM pages straight at
+    // the raw pages in it, copy-on-write, so only packed pages are decoded. Fields are written
+    // as laid out in memory, i.e. little endian
+    struct SaveState
+    {
+        static constexpr char MAGIC[8] = { 'E', 'M', 'U', '6', '5', '0', '2', 'S' };
+        static constexpr uint32 VERSION = 1u;
+
+        enum class PageEncoding : Byte
+        {
+            Zero,
+            Raw,
+            Packed,
+        };
+
+        struct PageEntry
+        {
+            uint32 Offset;      // From the start of the file
+            uint16 Size;
+            PageEncoding Encoding;
+            Byte Reserved;
+        };
+
+        // CPU state as saved, Status with any pending flags written back
+        struct Registers
+        {
+            Word PC;
+            Byte SP, A, X, Y;
+            Byte Status;
+            Byte DebugStatus;
+            uint64 TotalCycles;
+
+            static Registers From(CPU const & cpu)
+            {
+                return { cpu.PC, cpu.SP, cpu.A, cpu.X, cpu.Y, cpu.CurrentStatus(), cpu.DebugStatus, cpu.TotalCycles };
+            }
+
+            void ApplyTo(CPU & cpu) const
+            {
+                cpu.PC = PC;
+                cpu.SP = SP;
+                cpu.A = A;
+                cpu.X = X;
+                cpu.Y = Y;
+                cpu.SetStatus(Status);
+                cpu.DebugStatus = DebugStatus;
+                cpu.TotalCycles = TotalCycles;
+            }
+        };
+
+        struct Header
+        {
+            char Magic[8];
+            uint32 Version;
+            uint32 HeaderSize;
+            Registers Cpu;
+            PageEntry Pages[Memory::PAGE_COUNT];
+        };
+
+        static_assert(sizeof(PageEntry) == 8, "Page entries are part of the file format");
+        static_assert(sizeof(Header) == 32 + 8 * Memory::PAGE_COUNT, "The header is part of the file format");
+
+        static constexpr uint32 MAX_PACKED_SIZE = static_cast<uint32>(PackBits::MaxSize(Memory::PAGE_SIZE));
+
+        static std::vector<Byte> Save(CPU const & cpu, Memory const & memory, bool compress = true)
+        {
+            std::vector<Byte> bytes(sizeof(Header));
+            bytes.reserve(sizeof(Header) + Memory::MAX_MEMORY);
+
+            Header header { };
+            memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+            header.Version = VERSION;
+            header.HeaderSize = sizeof(Header);
+            header.Cpu = Registers::From(cpu);
+
+            Byte packed[MAX_PACKED_SIZE];
+
+            for (uint32 page = 0; page < Memory::PAGE_COUNT; ++page)
+            {
+                auto const * source = PageSource(memory, page);
+                auto & entry = header.Pages[page];
+                entry.Offset = static_cast<uint32>(bytes.size());
+
+                if (compress && memcmp(source, Memory::Zeroes, Memory::PAGE_SIZE) == 0)
+                {
+                    entry.Encoding = PageEncoding::Zero;
+                    continue;
+                }
+
+                auto size = compress ? Pack(source, packed) : Memory::PAGE_SIZE;
+                if (size < Memory::PAGE_SIZE)
+                {
+                    entry.Encoding = PageEncoding::Packed;
+                    bytes.insert(bytes.end(), packed, packed + size);
+                }
+                else
+                {
+                    size = Memory::PAGE_SIZE;
+                    entry.Encoding = PageEncoding::Raw;
+                    bytes.insert(bytes.end(), source, source + size);
+                }
+
+                entry.Size = static_cast<uint16>(size);
+            }
+
+            memcpy(bytes.data(), &header, sizeof(Header));
+            return bytes;
+        }
+
+        static bool SaveFile(char const * path, CPU const & cpu, Memory const & memory, bool compress = true)
+        {
+            auto bytes = Save(cpu, memory, compress);
+
+            auto * file = fopen(path, "wb");
+            if (file == nullptr)
+                return false;
+
+            auto written = fwrite(bytes.data(), 1, bytes.size(), file);
+            return fclose(file) == 0 && written == bytes.size();
+        }
+
+        // Puts the machine back to a saved state, e.g. from MapFile. RAM pages are mapped onto
+        // the image, which has to outlive the mapping like a loaded program. Pages mapped to ROM
+        // or devices keep their mapping and have the saved bytes copied into Data under them.
+        // Every page restored counts as written, a reset drops the mappings and puts Data back
+        // whichever way the state was saved. Nothing is touched and false is returned if the
+        // image is not a state this version reads
+        static bool Restore(RomImage const & image, CPU & cpu, Memory & memory)
+        {
+            if (!IsValid(image))
+                return false;
+
+            Header header;
+            memcpy(&header, image.Data(), sizeof(Header));
+
+            for (uint32 page = 0; page < Memory::PAGE_COUNT; ++page)
+            {
+                auto const & entry = header.Pages[page];
+                auto const * stored = image.Data() + entry.Offset;
+                auto * own = memory.Data + page * Memory::PAGE_SIZE;
+                auto isRam = memory.IsShared(page) || (memory.ReadPages[page] == own && memory.WritePages[page] == own);
+
+                switch (entry.Encoding)
+                {
+                case PageEncoding::Zero:
+                    if (isRam)
+                        memory.MapCopyOnWrite(page, 1, Memory::Zeroes + page * Memory::PAGE_SIZE, true);
+                    else
+                        memset(own, 0, Memory::PAGE_SIZE);
+                    break;
+
+                case PageEncoding::Raw:
+                    if (isRam)
+                        memory.MapCopyOnWrite(page, 1, stored, true);
+                    else
+                        memcpy(own, stored, Memory::PAGE_SIZE);
+                    break;
+
+                case PageEncoding::Packed:
+                    Unpack(stored, entry.Size, own);
+                    if (isRam)
+                        memory.Unmap(page, 1);
+                    break;
+                }
+
+                memory.WatchedWrite(page);
+            }
+
+            header.Cpu.ApplyTo(cpu);
+            return true;
+        }
+
+        // Checks the header and every page before anything is restored from the image
+        static bool IsValid(RomImage const & image)
+        {
+            if (image.Size < sizeof(Header))
+                return false;
+
+            Header header;
+            memcpy(&header, image.Data(), sizeof(Header));
+
+            if (memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0 || header.Version != VERSION || header.HeaderSize != sizeof(Header))
+                return false;
+
+            Byte page[Memory::PAGE_SIZE];
+
+            for (auto const & entry : header.Pages)
+            {
+                if (entry.Offset > image.Size || entry.Size > image.Size - entry.Offset)
+                    return false;
+
+                switch (entry.Encoding)
+                {
+                case PageEncoding::Zero:
+                    break;
+
+                case PageEncoding::Raw:
+                    if (entry.Size != Memory::PAGE_SIZE)
+                        return false;
+                    break;
+
+                case PageEncoding::Packed:
+                    if (!Unpack(image.Data() + entry.Offset, entry.Size, page))
+                        return false;
+                    break;
+
+                default:
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // What is saved for a page, RAM as the CPU sees it or Data under a ROM or device page
+        static Byte const * PageSource(Memory const & memory, uint32 page)
+        {
+            return memory.IsShared(page) ? memory.ReadPages[page] : memory.Data + page * Memory::PAGE_SIZE;
+        }
+
+        // Pages are packed with PackBits
+        static uint32 Pack(Byte const * page, Byte * out)
+        {
+            return static_cast<uint32>(PackBits::Pack(page, Memory::PAGE_SIZE, out));
+        }
+
+        // False unless the input decodes to exactly one page
+        static bool Unpack(Byte const * in, uint32 size, Byte * page)
+        {
+            return PackBits::Unpack(in, size, page, Memory::PAGE_SIZE);
+        }
+    };
+
+}
\ No newline at end of file
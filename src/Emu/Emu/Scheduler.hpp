@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+
+
+namespace Emu
+{
+
+    struct Scheduler;
+
+    // Device callback, deadline is the cycle the event was due at. Events run between
+    // instructions so Now can be a few cycles past it, a periodic device reschedules from its
+    // deadline rather than from Now so it does not drift
+    using EventHandler = void (*)(void * context, Scheduler & scheduler, Memory & memory, uint64 deadline);
+
+
+    // Master cycle clock with the events due on it and the interrupt lines into the CPU. Events
+    // are kept in a min-heap on their deadline, events due on the same cycle run in the order
+    // they were scheduled
+    struct Scheduler
+    {
+        static constexpr uint64 NEVER = std::numeric_limits<uint64>::max();
+
+        struct Event
+        {
+            uint64 Deadline;
+            uint64 Id;
+            EventHandler Handler;
+            void * Context;
+        };
+
+        uint64 Now = 0u;                // CPU cycles since the scheduler was created
+        uint64 NextId = 1u;
+        std::vector<Event> Events;
+
+        uint32 IrqLines = 0u;           // One bit per source holding IRQ, taken while any is set
+        bool NmiPending = false;        // NMI is edge triggered, taken once per RaiseNmi
+
+        // Returns an id for Cancel
+        uint64 Schedule(uint64 deadline, EventHandler handler, void * context)
+        {
+            auto id = NextId++;
+            Events.push_back({ deadline, id, handler, context });
+            std::push_heap(Events.begin(), Events.end(), &Later);
+            return id;
+        }
+
+        uint64 ScheduleIn(uint64 delay, EventHandler handler, void * context)
+        {
+            return Schedule(Now + delay, handler, context);
+        }
+
+        // False when the event has already run or was never scheduled
+        bool Cancel(uint64 id)
+        {
+            auto found = std::find_if(Events.begin(), Events.end(), [id](Event const & event) { return event.Id == id; });
+            if (found == Events.end())
+                return false;
+
+            *found = Events.back();
+            Events.pop_back();
+            std::make_heap(Events.begin(), Events.end(), &Later);
+            return true;
+        }
+
+        uint64 NextDeadline() const
+        {
+            return Events.empty() ? NEVER : Events.front().Deadline;
+        }
+
+        // Runs every event due by Now, including ones scheduled by those events
+        void RunDue(Memory & memory)
+        {
+            while (!Events.empty() && Events.front().Deadline <= Now)
+            {
+                std::pop_heap(Events.begin(), Events.end(), &Later);
+                auto event = Events.back();
+                Events.pop_back();
+
+                event.Handler(event.Context, *this, memory, event.Deadline);
+            }
+        }
+
+        void RaiseIrq(uint32 lines = 1u)
+        {
+            IrqLines |= lines;
+        }
+
+        void ClearIrq(uint32 lines = 1u)
+        {
+            IrqLines &= ~lines;
+        }
+
+        void RaiseNmi()
+        {
+            NmiPending = true;
+        }
+
+        static bool Later(Event const & left, Event const & right)
+        {
+            return left.Deadline != right.Deadline ? left.Deadline > right.Deadline : left.Id > right.Id;
+        }
+    };
+
+
+    // Runs the interpreter up to the next deadline at a time so its loop only counts cycles down
+    // as it always has, events and interrupts are dealt with between the runs. With nothing
+    // scheduled this is one run of the whole budget. While an IRQ is held but masked the CPU
+    // steps one instruction at a time so the IRQ is taken as soon as RTI or PLP clears the mask
+    inline uint32 CPU::Execute(uint32 cycles, Memory & memory, Scheduler & scheduler)
+    {
+        NoProfiler profiler;
+        return ExecuteProfiled(cycles, memory, scheduler, profiler);
+    }
+
+    // Policies that only want interrupt entries, e.g. ones sampling from scheduler events, set
+    // HOOKS_INSTRUCTIONS to false
+    template <typename TProfiler, typename = void>
+    inline constexpr bool HooksInstructions = true;
+
+    template <typename TProfiler>
+    inline constexpr bool HooksInstructions<TProfiler, std::void_t<decltype(TProfiler::HOOKS_INSTRUCTIONS)>> = TProfiler::HOOKS_INSTRUCTIONS;
+
+    // Slices go through the profiled table loop and interrupt entries are reported to the
+    // profiler. Without instruction hooks the slices use the default back end
+    template <typename TProfiler>
+    uint32 CPU::ExecuteProfiled(uint32 cycles, Memory & memory, Scheduler & scheduler, TProfiler & profiler)
+    {
+        uint32 used = 0u;
+        scheduler.RunDue(memory);
+
+        while (used < cycles)
+        {
+            uint32 ran;
+
+            if (scheduler.NmiPending)
+            {
+                scheduler.NmiPending = false;
+                ran = Interrupt(NMI_VECTOR, memory);
+                profiler.Interrupt(NMI_VECTOR, ran);
+            }
+            else if (scheduler.IrqLines != 0 && !StatusFlags.IRQDisableFlag)
+            {
+                ran = Interrupt(IRQ_VECTOR, memory);
+                profiler.Interrupt(IRQ_VECTOR, ran);
+            }
+            else
+            {
+                auto slice = std::min<uint64>(cycles - used, scheduler.NextDeadline() - scheduler.Now);
+                if (scheduler.IrqLines != 0)
+                    slice = 1u;
+
+                // Running past the end of a slice is expected, only past the budget counts
+                if constexpr (!HooksInstructions<TProfiler>)
+                    ran = Execute(static_cast<uint32>(slice), memory);
+                else
+                    ran = ExecuteProfiled(static_cast<uint32>(slice), memory, profiler);
+
+                DebugFlags.CycleOverflow = 0;
+            }
+
+            used += ran;
+            scheduler.Now += ran;
+            scheduler.RunDue(memory);
+
+            if (DebugFlags.UnhandledInstruction)
+                break;
+        }
+
+        if (used > cycles)
+            DebugFlags.CycleOverflow = 1;
+
+        return used;
+    }
+
+}
\ No newline at end of file
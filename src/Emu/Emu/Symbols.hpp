@@ -0,0 +1,179 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <Emu/Loader.hpp>
+
+
+namespace Emu
+{
+
+    // Guest labels by address. Where several labels share an address the first one read is kept
+    struct SymbolTable
+    {
+        std::unordered_map<Word, std::string> Names;
+
+        bool Add(Word address, std::string_view name)
+        {
+            if (name.empty())
+                return false;
+
+            return Names.emplace(address, std::string(name)).second;
+        }
+
+        // nullptr when nothing is named at address
+        char const * Find(Word address) const
+        {
+            auto found = Names.find(address);
+            return found == Names.end() ? nullptr : found->second.c_str();
+        }
+
+        size_t Size() const
+        {
+            return Names.size();
+        }
+
+        // Label file of either format, told apart by its contents. False when the file cannot be
+        // read or no labels were found in it
+        bool Load(char const * path)
+        {
+            auto image = MapFile(path);
+            if (image.Size == 0)
+                return false;
+
+            std::string_view text(reinterpret_cast<char const *>(image.Data()), image.Size);
+            auto before = Size();
+
+            if (text.find("sym\t") != std::string_view::npos || text.find("sym ") != std::string_view::npos)
+                ParseCa65Debug(text);
+            else
+                ParseVice(text);
+
+            return Size() > before;
+        }
+
+        // VICE monitor labels as written by ld65 -Ln, e.g. "al 00C000 .reset". The address may
+        // carry a memory space prefix such as "C:"
+        void ParseVice(std::string_view text)
+        {
+            ForEachLine(text, [this](std::string_view line)
+            {
+                auto command = NextToken(line);
+                if (command != "al")
+                    return;
+
+                auto address = NextToken(line);
+                if (auto colon = address.find(':'); colon != std::string_view::npos)
+                    address.remove_prefix(colon + 1);
+
+                auto name = NextToken(line);
+                if (!name.empty() && name.front() == '.')
+                    name.remove_prefix(1);
+
+                uint32 value;
+                if (ParseNumber(address, 16, value))
+                    Add(static_cast<Word>(value), name);
+            });
+        }
+
+        // ca65/ld65 --dbgfile output, only "sym" lines of type lab with a value are used, e.g.
+        // sym id=4,name="reset",addrsize=absolute,scope=0,def=12,val=0xC000,seg=1,type=lab
+        void ParseCa65Debug(std::string_view text)
+        {
+            ForEachLine(text, [this](std::string_view line)
+            {
+                if (NextToken(line) != "sym")
+                    return;
+
+                std::string_view name, value, type;
+                while (!line.empty())
+                {
+                    auto comma = line.find(',');
+                    auto field = line.substr(0, comma);
+                    line.remove_prefix(comma == std::string_view::npos ? line.size() : comma + 1);
+
+                    auto equals = field.find('=');
+                    if (equals == std::string_view::npos)
+                        continue;
+
+                    auto key = Trim(field.substr(0, equals));
+                    auto data = Trim(field.substr(equals + 1));
+
+                    if (key == "name")          name = Unquote(data);
+                    else if (key == "val")      value = data;
+                    else if (key == "type")     type = data;
+                }
+
+                uint32 address;
+                if (type == "lab" && value.size() > 2 && value.substr(0, 2) == "0x"
+                    && ParseNumber(value.substr(2), 16, address))
+                    Add(static_cast<Word>(address), name);
+            });
+        }
+
+        template <typename TLine>
+        static void ForEachLine(std::string_view text, TLine && line)
+        {
+            while (!text.empty())
+            {
+                auto end = text.find('\n');
+                line(Trim(text.substr(0, end)));
+                text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            }
+        }
+
+        // Removes and returns the next whitespace separated token
+        static std::string_view NextToken(std::string_view & line)
+        {
+            line = Trim(line);
+            auto end = line.find_first_of(" \t");
+            auto token = line.substr(0, end);
+            line.remove_prefix(token.size());
+            return token;
+        }
+
+        static std::string_view Trim(std::string_view text)
+        {
+            auto begin = text.find_first_not_of(" \t\r");
+            if (begin == std::string_view::npos)
+                return { };
+
+            auto end = text.find_last_not_of(" \t\r");
+            return text.substr(begin, end - begin + 1);
+        }
+
+        static std::string_view Unquote(std::string_view text)
+        {
+            if (text.size() >= 2 && text.front() == '"' && text.back() == '"')
+                return text.substr(1, text.size() - 2);
+            return text;
+        }
+
+        // Whole of text as a number that fits in a Word
+        static bool ParseNumber(std::string_view text, uint32 base, uint32 & value)
+        {
+            if (text.empty() || text.size() > 8)
+                return false;
+
+            value = 0;
+            for (auto c : text)
+            {
+                uint32 digit;
+                if (c >= '0' && c <= '9')       digit = static_cast<uint32>(c - '0');
+                else if (c >= 'a' && c <= 'f')  digit = static_cast<uint32>(c - 'a' + 10);
+                else if (c >= 'A' && c <= 'F')  digit = static_cast<uint32>(c - 'A' + 10);
+                else                            return false;
+
+                if (digit >= base)
+                    return false;
+
+                value = value * base + digit;
+            }
+
+            return value <= 0xFFFF;
+        }
+    };
+
+}
\ No newline at end of file
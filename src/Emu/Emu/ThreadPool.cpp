@@ -0,0 +1,107 @@
+#include <Emu/ThreadPool.hpp>
+
+#include <algorithm>
+
+
+namespace Emu
+{
+
+    ThreadPool::ThreadPool(uint32 threadCount)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        Ranges = std::make_unique<WorkRange[]>(threadCount);
+
+        for (uint32 worker = 1; worker < threadCount; ++worker)
+            Threads.emplace_back([this, worker]() { WorkerLoop(worker); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Stopping = true;
+        }
+
+        Started.notify_all();
+
+        for (auto & thread : Threads)
+            thread.join();
+    }
+
+    void ThreadPool::Run(size_t count, Task task, void * context)
+    {
+        auto workers = WorkerCount();
+
+        // Even split, the first count % workers workers take one extra
+        size_t begin = 0;
+        for (uint32 worker = 0; worker < workers; ++worker)
+        {
+            size_t size = count / workers + (worker < count % workers ? 1 : 0);
+            Ranges[worker].Bounds.store(WorkRange::Pack(begin, begin + size), std::memory_order_relaxed);
+            begin += size;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            CurrentTask = task;
+            CurrentContext = context;
+            Busy = workers - 1;
+            ++Generation;
+        }
+
+        Started.notify_all();
+        Work(0);
+
+        std::unique_lock<std::mutex> lock(Mutex);
+        Finished.wait(lock, [this]() { return Busy == 0; });
+    }
+
+    void ThreadPool::Work(uint32 worker)
+    {
+        auto workers = WorkerCount();
+        size_t index = 0;
+
+        while (Ranges[worker].TakeFront(index))
+            CurrentTask(CurrentContext, index);
+
+        // Out of own work, steal from the others starting with the next worker along
+        for (uint32 offset = 1; offset < workers; ++offset)
+        {
+            auto & victim = Ranges[(worker + offset) % workers];
+            while (victim.TakeBack(index))
+                CurrentTask(CurrentContext, index);
+        }
+    }
+
+    void ThreadPool::WorkerLoop(uint32 worker)
+    {
+        uint64 seen = 0;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                Started.wait(lock, [this, seen]() { return Stopping || Generation != seen; });
+
+                if (Stopping)
+                    return;
+
+                seen = Generation;
+            }
+
+            Work(worker);
+
+            bool last;
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                last = --Busy == 0;
+            }
+
+            if (last)
+                Finished.notify_one();
+        }
+    }
+
+}
\ No newline at end of file
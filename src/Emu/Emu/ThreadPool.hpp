@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <Emu/includes.hpp>
+
+
+namespace Emu
+{
+
+    // Fixed set of workers running index ranges. Each worker starts on its own slice of the range
+    // and steals from the back of the others' once it runs out, the calling thread works as well
+    struct ThreadPool
+    {
+        // Context is whatever was passed to Run
+        using Task = void (*)(void * context, size_t index);
+
+        // Indices still to run for one worker, begin in the low half and end in the high half so
+        // the owner and thieves agree through one compare exchange
+        struct alignas(64) WorkRange
+        {
+            std::atomic<uint64> Bounds { 0 };
+
+            static uint64 Pack(uint64 begin, uint64 end)
+            {
+                return begin | end << 32;
+            }
+
+            bool TakeFront(size_t & index)
+            {
+                auto bounds = Bounds.load(std::memory_order_relaxed);
+                while (static_cast<uint32>(bounds) < static_cast<uint32>(bounds >> 32))
+                {
+                    if (Bounds.compare_exchange_weak(bounds, bounds + 1, std::memory_order_relaxed))
+                    {
+                        index = static_cast<uint32>(bounds);
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            bool TakeBack(size_t & index)
+            {
+                auto bounds = Bounds.load(std::memory_order_relaxed);
+                while (static_cast<uint32>(bounds) < static_cast<uint32>(bounds >> 32))
+                {
+                    auto end = (bounds >> 32) - 1;
+                    if (Bounds.compare_exchange_weak(bounds, Pack(static_cast<uint32>(bounds), end), std::memory_order_relaxed))
+                    {
+                        index = static_cast<size_t>(end);
+                        return true;
+                    }
+                }
+                return false;
+            }
+        };
+
+        std::vector<std::thread> Threads;
+        std::unique_ptr<WorkRange[]> Ranges;    // One per worker, the caller is worker 0
+
+        std::mutex Mutex;
+        std::condition_variable Started;
+        std::condition_variable Finished;
+        uint64 Generation = 0;          // Bumped for every Run, workers wait for it to move
+        uint32 Busy = 0;                // Workers still on the current Run
+        bool Stopping = false;
+
+        Task CurrentTask = nullptr;
+        void * CurrentContext = nullptr;
+
+        // Zero uses one worker per hardware thread
+        explicit ThreadPool(uint32 threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(ThreadPool const &) = delete;
+        ThreadPool & operator=(ThreadPool const &) = delete;
+
+        uint32 WorkerCount() const
+        {
+            return static_cast<uint32>(Threads.size()) + 1;
+        }
+
+        // Calls task for every index in [0, count) and returns once all are done. Which worker runs
+        // an index is not fixed, tasks must not depend on it
+        void Run(size_t count, Task task, void * context);
+
+        void Work(uint32 worker);
+        void WorkerLoop(uint32 worker);
+    };
+
+}
\ No newline at end of file
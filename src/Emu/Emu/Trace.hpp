@@ -0,0 +1,387 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Loader.hpp>
+#include <Emu/PackBits.hpp>
+
+
+namespace Emu
+{
+
+    // One executed instruction, the registers and cycle are from before it ran
+    struct TraceRecord
+    {
+        uint64 Cycle;
+        Word PC;
+        Byte OpCode;
+        Byte Operand1, Operand2;    // The bytes after the opcode, 0 where the instruction does not use them
+        Byte A, X, Y;
+        Byte Status;
+        Byte SP;
+
+        bool operator==(TraceRecord const & other) const
+        {
+            return Cycle == other.Cycle && PC == other.PC && OpCode == other.OpCode
+                && Operand1 == other.Operand1 && Operand2 == other.Operand2
+                && A == other.A && X == other.X && Y == other.Y && Status == other.Status && SP == other.SP;
+        }
+    };
+
+    // Operand bytes each opcode uses, a byte mask for each
+    inline constexpr auto TraceOperandMasks = []()
+    {
+        std::array<std::array<Byte, 256>, 2> masks { };
+        for (size_t opCode = 0; opCode < 256; ++opCode)
+        {
+            auto length = CPU::OpCodeTable[opCode].Length;
+            masks[0][opCode] = length >= 2 ? 0xFF : 0x00;
+            masks[1][opCode] = length >= 3 ? 0xFF : 0x00;
+        }
+        return masks;
+    }();
+
+    // Records a column per field
+    struct TraceBlock
+    {
+        static constexpr uint32 CAPACITY = 4096;
+
+        uint32 Count = 0u;
+        uint64 Cycle[CAPACITY];
+        Word PC[CAPACITY];
+        Byte OpCode[CAPACITY];
+        Byte Operand1[CAPACITY];
+        Byte Operand2[CAPACITY];
+        Byte A[CAPACITY];
+        Byte X[CAPACITY];
+        Byte Y[CAPACITY];
+        Byte Status[CAPACITY];
+        Byte SP[CAPACITY];
+
+        TraceRecord Record(uint32 index) const
+        {
+            return { Cycle[index], PC[index], OpCode[index], Operand1[index], Operand2[index],
+                A[index], X[index], Y[index], Status[index], SP[index] };
+        }
+
+        void Add(TraceRecord const & record)
+        {
+            auto index = Count++;
+            Cycle[index] = record.Cycle;
+            PC[index] = record.PC;
+            OpCode[index] = record.OpCode;
+            Operand1[index] = record.Operand1;
+            Operand2[index] = record.Operand2;
+            A[index] = record.A;
+            X[index] = record.X;
+            Y[index] = record.Y;
+            Status[index] = record.Status;
+            SP[index] = record.SP;
+        }
+    };
+
+
+    // Trace file: a header, then chunks of up to a block of records. A chunk stores the cycle of
+    // its first record and then one byte column per field, the cycle as the difference from the
+    // record before and PC as its low and high bytes. A gap of more than 255 cycles starts a new
+    // chunk. Packed files run every column through PackBits, each prefixed with its packed size;
+    // in unpacked files column n of a chunk is at n * Count past its header
+    struct TraceFile
+    {
+        static constexpr char MAGIC[8] = { 'E', 'M', 'U', 'T', 'R', 'A', 'C', 'E' };
+        static constexpr uint32 VERSION = 1u;
+        static constexpr uint32 FLAG_PACKED = 0x1;
+
+        enum Column : uint32
+        {
+            CycleDelta,
+            PCLow,
+            PCHigh,
+            OpCode,
+            Operand1,
+            Operand2,
+            A,
+            X,
+            Y,
+            Status,
+            SP,
+            COLUMN_COUNT
+        };
+
+        struct Header
+        {
+            char Magic[8];
+            uint32 Version;
+            uint32 Flags;
+        };
+
+        struct ChunkHeader
+        {
+            uint32 Count;
+            uint32 Size;        // Bytes of columns after this header
+            uint64 FirstCycle;
+        };
+
+        static_assert(sizeof(Header) == 16 && sizeof(ChunkHeader) == 16, "Headers are part of the file format");
+
+        RomImage Image;
+        bool Packed = false;
+
+        static void EncodeHeader(bool packed, std::vector<Byte> & out)
+        {
+            Header header { };
+            memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+            header.Version = VERSION;
+            header.Flags = packed ? FLAG_PACKED : 0u;
+            Append(out, &header, sizeof(header));
+        }
+
+        // Appends the block's records as one or more chunks
+        static void Encode(TraceBlock const & block, bool packed, std::vector<Byte> & out)
+        {
+            uint32 begin = 0;
+            while (begin < block.Count)
+            {
+                auto end = begin + 1;
+                while (end < block.Count && block.Cycle[end] >= block.Cycle[end - 1] && block.Cycle[end] - block.Cycle[end - 1] <= 0xFF)
+                    ++end;
+
+                EncodeChunk(block, begin, end, packed, out);
+                begin = end;
+            }
+        }
+
+        static void EncodeChunk(TraceBlock const & block, uint32 begin, uint32 end, bool packed, std::vector<Byte> & out)
+        {
+            auto count = end - begin;
+            Byte column[TraceBlock::CAPACITY];
+            Byte packedColumn[PackBits::MaxSize(TraceBlock::CAPACITY)];
+
+            auto headerAt = out.size();
+            ChunkHeader header { count, 0u, block.Cycle[begin] };
+            Append(out, &header, sizeof(header));
+
+            for (uint32 field = 0; field < COLUMN_COUNT; ++field)
+            {
+                GetColumn(block, field, begin, count, column);
+
+                if (packed)
+                {
+                    auto size = static_cast<uint32>(PackBits::Pack(column, count, packedColumn));
+                    Append(out, &size, sizeof(size));
+                    Append(out, packedColumn, size);
+                }
+                else
+                {
+                    Append(out, column, count);
+                }
+            }
+
+            header.Size = static_cast<uint32>(out.size() - headerAt - sizeof(header));
+            memcpy(out.data() + headerAt, &header, sizeof(header));
+        }
+
+        // Column field of records [begin, begin + count), with the switch outside the loops
+        static void GetColumn(TraceBlock const & block, uint32 field, uint32 begin, uint32 count, Byte * column)
+        {
+            switch (field)
+            {
+            case CycleDelta:
+                column[0] = 0;
+                for (uint32 i = 1; i < count; ++i)
+                    column[i] = static_cast<Byte>(block.Cycle[begin + i] - block.Cycle[begin + i - 1]);
+                break;
+            case PCLow:
+                for (uint32 i = 0; i < count; ++i)
+                    column[i] = static_cast<Byte>(block.PC[begin + i]);
+                break;
+            case PCHigh:
+                for (uint32 i = 0; i < count; ++i)
+                    column[i] = static_cast<Byte>(block.PC[begin + i] >> 8);
+                break;
+            default:
+                memcpy(column, ByteColumn(block, field) + begin, count);
+                break;
+            }
+        }
+
+        static void SetColumn(TraceBlock & block, uint32 field, uint32 count, Byte const * column, uint64 firstCycle)
+        {
+            switch (field)
+            {
+            case CycleDelta:
+                block.Cycle[0] = firstCycle;
+                for (uint32 i = 1; i < count; ++i)
+                    block.Cycle[i] = block.Cycle[i - 1] + column[i];
+                break;
+            case PCLow:
+                for (uint32 i = 0; i < count; ++i)
+                    block.PC[i] = column[i];
+                break;
+            case PCHigh:
+                for (uint32 i = 0; i < count; ++i)
+                    block.PC[i] |= static_cast<Word>(column[i] << 8);
+                break;
+            default:
+                memcpy(ByteColumn(block, field), column, count);
+                break;
+            }
+        }
+
+        // The block's array for a single byte field
+        static Byte * ByteColumn(TraceBlock & block, uint32 field)
+        {
+            switch (field)
+            {
+            case OpCode:        return block.OpCode;
+            case Operand1:      return block.Operand1;
+            case Operand2:      return block.Operand2;
+            case A:             return block.A;
+            case X:             return block.X;
+            case Y:             return block.Y;
+            case Status:        return block.Status;
+            default:            return block.SP;
+            }
+        }
+
+        static Byte const * ByteColumn(TraceBlock const & block, uint32 field)
+        {
+            return ByteColumn(const_cast<TraceBlock &>(block), field);
+        }
+
+        // Maps the file, false if it is not a trace this version reads
+        bool Open(char const * path)
+        {
+            return Open(MapFile(path));
+        }
+
+        bool Open(RomImage image)
+        {
+            Header header;
+            if (image.Size < sizeof(header))
+                return false;
+
+            memcpy(&header, image.Data(), sizeof(header));
+            if (memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0 || header.Version != VERSION)
+                return false;
+
+            Image = std::move(image);
+            Packed = (header.Flags & FLAG_PACKED) != 0;
+            return true;
+        }
+
+        // Offset of the first chunk, for ReadChunk
+        size_t Begin() const
+        {
+            return sizeof(Header);
+        }
+
+        bool AtEnd(size_t at) const
+        {
+            return at >= Image.Size;
+        }
+
+        // Decodes the chunk at offset at into block and moves at past it. False if the file is cut
+        // short there or the chunk does not decode
+        bool ReadChunk(size_t & at, TraceBlock & block) const
+        {
+            ChunkHeader header;
+            if (Image.Size - at < sizeof(header))
+                return false;
+
+            memcpy(&header, Image.Data() + at, sizeof(header));
+
+            auto columns = at + sizeof(header);
+            if (header.Count == 0 || header.Count > TraceBlock::CAPACITY || header.Size > Image.Size - columns)
+                return false;
+
+            if (!DecodeChunk(header, Image.Data() + columns, block))
+                return false;
+
+            at = columns + header.Size;
+            return true;
+        }
+
+        // Decodes each chunk in turn into block and calls visit(block). False if the file is
+        // cut short or a chunk does not decode, after visiting the chunks before it
+        template <typename TVisit>
+        bool ForEachChunk(TraceBlock & block, TVisit && visit) const
+        {
+            auto at = Begin();
+
+            while (!AtEnd(at))
+            {
+                if (!ReadChunk(at, block))
+                    return false;
+
+                visit(static_cast<TraceBlock const &>(block));
+            }
+
+            return true;
+        }
+
+        // Every record in the file, for traces small enough to hold
+        std::vector<TraceRecord> Records() const
+        {
+            std::vector<TraceRecord> records;
+            auto block = std::make_unique<TraceBlock>();
+
+            ForEachChunk(*block, [&records](TraceBlock const & chunk)
+            {
+                for (uint32 i = 0; i < chunk.Count; ++i)
+                    records.push_back(chunk.Record(i));
+            });
+
+            return records;
+        }
+
+        bool DecodeChunk(ChunkHeader const & header, Byte const * columns, TraceBlock & block) const
+        {
+            auto count = header.Count;
+            Byte column[TraceBlock::CAPACITY];
+            size_t at = 0;
+
+            block.Count = count;
+
+            for (uint32 field = 0; field < COLUMN_COUNT; ++field)
+            {
+                Byte const * values = columns + at;
+
+                if (Packed)
+                {
+                    uint32 size;
+                    if (header.Size - at < sizeof(size))
+                        return false;
+
+                    memcpy(&size, columns + at, sizeof(size));
+                    at += sizeof(size);
+
+                    if (size > header.Size - at || !PackBits::Unpack(columns + at, size, column, count))
+                        return false;
+
+                    values = column;
+                    at += size;
+                }
+                else
+                {
+                    if (count > header.Size - at)
+                        return false;
+                    at += count;
+                }
+
+                SetColumn(block, field, count, values, header.FirstCycle);
+            }
+
+            return true;
+        }
+
+        static void Append(std::vector<Byte> & out, void const * bytes, size_t size)
+        {
+            auto const * begin = static_cast<Byte const *>(bytes);
+            out.insert(out.end(), begin, begin + size);
+        }
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,504 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Trace.hpp>
+
+
+namespace Emu
+{
+
+    // A text log with a line per instruction in the layout nestest.log uses, e.g.
+    //
+    //     C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7
+    //
+    // Only the address, the instruction bytes, the registers and CYC are read, anything else on
+    // the line is skipped. Operand bytes the instruction does not have read as 0 and CYC is 0 on
+    // lines without one. Read through the same chunk interface as TraceFile
+    struct TextTrace
+    {
+        RomImage Image;
+
+        // Maps the file, false if it is empty or the first line is not a log line
+        bool Open(char const * path)
+        {
+            return Open(MapFile(path));
+        }
+
+        bool Open(RomImage image)
+        {
+            TraceRecord record;
+            if (image.Size == 0)
+                return false;
+
+            auto const * text = reinterpret_cast<char const *>(image.Data());
+            if (!ParseLine(text, LineEnd(text, 0, image.Size), record))
+                return false;
+
+            Image = std::move(image);
+            return true;
+        }
+
+        size_t Begin() const
+        {
+            return 0u;
+        }
+
+        // Blank lines at the end count as the end
+        bool AtEnd(size_t at) const
+        {
+            auto const * text = reinterpret_cast<char const *>(Image.Data());
+            while (at < Image.Size && (text[at] == '\n' || text[at] == '\r'))
+                ++at;
+            return at >= Image.Size;
+        }
+
+        // Parses up to a block of lines from offset at into block and moves at past them. False
+        // if a line is not a log line, the lines before it are still in block
+        bool ReadChunk(size_t & at, TraceBlock & block) const
+        {
+            auto const * text = reinterpret_cast<char const *>(Image.Data());
+            block.Count = 0u;
+
+            while (at < Image.Size && block.Count < TraceBlock::CAPACITY)
+            {
+                auto end = LineEnd(text, at, Image.Size);
+                if (end != at)
+                {
+                    TraceRecord record;
+                    if (!ParseLine(text + at, end - at, record))
+                        return false;
+                    block.Add(record);
+                }
+
+                at = end < Image.Size ? end + 1 : end;
+            }
+
+            return block.Count != 0 || AtEnd(at);
+        }
+
+        template <typename TVisit>
+        bool ForEachChunk(TraceBlock & block, TVisit && visit) const
+        {
+            auto at = Begin();
+
+            while (!AtEnd(at))
+            {
+                if (!ReadChunk(at, block))
+                    return false;
+
+                visit(static_cast<TraceBlock const &>(block));
+            }
+
+            return true;
+        }
+
+        // Offset of the line break ending the line at offset at, size for the last line
+        static size_t LineEnd(char const * text, size_t at, size_t size)
+        {
+            auto const * end = static_cast<char const *>(memchr(text + at, '\n', size - at));
+            return end != nullptr ? static_cast<size_t>(end - text) : size;
+        }
+
+        static bool ParseLine(char const * line, size_t size, TraceRecord & record)
+        {
+            if (size > 0 && line[size - 1] == '\r')
+                --size;
+
+            uint32 pc;
+            if (size < 4 || !ParseHex(line, 4, pc))
+                return false;
+
+            record = { };
+            record.PC = static_cast<Word>(pc);
+
+            // Up to three instruction bytes from column 6, each two digits and a space
+            Byte bytes[3] = { };
+            uint32 count = 0;
+            while (count < 3 && 6 + count * 3 + 2 <= size)
+            {
+                uint32 value;
+                auto const * at = line + 6 + count * 3;
+                if (!ParseHex(at, 2, value) || (6 + count * 3 + 2 < size && at[2] != ' '))
+                    break;
+                bytes[count++] = static_cast<Byte>(value);
+            }
+
+            if (count == 0)
+                return false;
+
+            record.OpCode = bytes[0];
+            record.Operand1 = bytes[1];
+            record.Operand2 = bytes[2];
+
+            uint32 a, x, y, p, sp;
+            if (!ParseField(line, size, " A:", a) || !ParseField(line, size, " X:", x) || !ParseField(line, size, " Y:", y)
+                || !ParseField(line, size, " P:", p) || !ParseField(line, size, " SP:", sp))
+                return false;
+
+            record.A = static_cast<Byte>(a);
+            record.X = static_cast<Byte>(x);
+            record.Y = static_cast<Byte>(y);
+            record.Status = static_cast<Byte>(p);
+            record.SP = static_cast<Byte>(sp);
+
+            auto const * cycle = Find(line, size, "CYC:");
+            if (cycle != nullptr)
+            {
+                for (auto const * end = line + size; cycle < end && *cycle >= '0' && *cycle <= '9'; ++cycle)
+                    record.Cycle = record.Cycle * 10 + static_cast<uint64>(*cycle - '0');
+            }
+
+            return true;
+        }
+
+        // Two hex digits after key
+        static bool ParseField(char const * line, size_t size, char const * key, uint32 & value)
+        {
+            auto const * at = Find(line, size, key);
+            return at != nullptr && line + size - at >= 2 && ParseHex(at, 2, value);
+        }
+
+        // Just past the first match of key, nullptr if there is none
+        static char const * Find(char const * line, size_t size, char const * key)
+        {
+            auto length = strlen(key);
+            for (size_t at = 0; at + length <= size; ++at)
+            {
+                if (memcmp(line + at, key, length) == 0)
+                    return line + at + length;
+            }
+            return nullptr;
+        }
+
+        static bool ParseHex(char const * text, uint32 digits, uint32 & value)
+        {
+            value = 0u;
+            for (uint32 i = 0; i < digits; ++i)
+            {
+                auto c = text[i];
+                uint32 digit;
+                if (c >= '0' && c <= '9')
+                    digit = static_cast<uint32>(c - '0');
+                else if (c >= 'A' && c <= 'F')
+                    digit = static_cast<uint32>(c - 'A' + 10);
+                else if (c >= 'a' && c <= 'f')
+                    digit = static_cast<uint32>(c - 'a' + 10);
+                else
+                    return false;
+                value = value << 4 | digit;
+            }
+            return true;
+        }
+    };
+
+
+    // Finds the first record where two traces disagree, either of which can be a TraceFile or a
+    // TextTrace. Both are decoded a chunk at a time and the overlapping records compared a group
+    // at a time, one field across the group per loop so the loops vectorize, the group is only
+    // searched record by record once it holds a difference.
+    //
+    // Cycles are compared from each trace's first record, so a trace that started at reset can
+    // be checked against a log that counts from some other point. Operand bytes are compared as
+    // far as the left record's instruction uses them, going by CPU::OpCodeTable
+    struct TraceDiff
+    {
+        enum Field : uint32
+        {
+            FIELD_CYCLE     = 1u << 0,
+            FIELD_PC        = 1u << 1,
+            FIELD_OPCODE    = 1u << 2,
+            FIELD_OPERANDS  = 1u << 3,
+            FIELD_A         = 1u << 4,
+            FIELD_X         = 1u << 5,
+            FIELD_Y         = 1u << 6,
+            FIELD_STATUS    = 1u << 7,
+            FIELD_SP        = 1u << 8,
+            FIELD_ALL       = (1u << 9) - 1u
+        };
+
+        struct Options
+        {
+            uint32 Fields = FIELD_ALL;
+            Byte StatusMask = 0xFF;     // e.g. 0b11001111 against logs that show bits 4 and 5 set
+            uint32 History = 8u;        // Records before the divergence to report, at most a block
+        };
+
+        struct Result
+        {
+            bool Diverged = false;
+            bool Complete = true;       // False if either trace could not be read to the end
+            uint64 Index = 0u;          // Of the divergent record, or the records compared
+            uint32 Fields = 0u;         // That differ, none when one trace ends before the other
+            uint64 LeftCount = 0u;      // Records read from each side, up to the divergence
+            uint64 RightCount = 0u;
+            TraceRecord Left { };
+            TraceRecord Right { };
+            std::vector<TraceRecord> History;  // From the left trace, oldest first
+
+            // A report of where and how the traces diverged
+            std::string Format() const;
+        };
+
+        static constexpr uint32 GROUP = 64;
+
+        template <typename TLeft, typename TRight>
+        static Result Compare(TLeft const & left, TRight const & right, Options const & options = { })
+        {
+            Result result;
+
+            // The previous left block is kept for history that reaches back past the current one
+            auto leftBlock = std::make_unique<TraceBlock>();
+            auto previousLeft = std::make_unique<TraceBlock>();
+            auto rightBlock = std::make_unique<TraceBlock>();
+
+            auto leftAt = left.Begin();
+            auto rightAt = right.Begin();
+            uint32 l = 0u, r = 0u;
+            bool started = false;
+            uint64 leftBase = 0u, rightBase = 0u;
+
+            for (;;)
+            {
+                if (l == leftBlock->Count && !left.AtEnd(leftAt))
+                {
+                    std::swap(leftBlock, previousLeft);
+                    result.Complete &= left.ReadChunk(leftAt, *leftBlock);
+                    l = 0u;
+                }
+
+                if (r == rightBlock->Count && !right.AtEnd(rightAt))
+                {
+                    result.Complete &= right.ReadChunk(rightAt, *rightBlock);
+                    r = 0u;
+                }
+
+                auto leftLeft = leftBlock->Count - l;
+                auto rightLeft = rightBlock->Count - r;
+
+                if (!result.Complete || leftLeft == 0 || rightLeft == 0)
+                {
+                    // One trace ending before the other is a divergence
+                    result.Diverged = result.Complete && (leftLeft != 0 || rightLeft != 0);
+                    if (result.Diverged)
+                    {
+                        if (leftLeft != 0)
+                            result.Left = leftBlock->Record(l);
+                        if (rightLeft != 0)
+                            result.Right = rightBlock->Record(r);
+                        result.LeftCount += leftLeft != 0 ? 1u : 0u;
+                        result.RightCount += rightLeft != 0 ? 1u : 0u;
+                        CollectHistory(*previousLeft, *leftBlock, l, options.History, result.History);
+                    }
+                    return result;
+                }
+
+                if (!started)
+                {
+                    leftBase = leftBlock->Cycle[l];
+                    rightBase = rightBlock->Cycle[r];
+                    started = true;
+                }
+
+                auto count = std::min(leftLeft, rightLeft);
+                auto match = FirstDifference(*leftBlock, l, leftBase, *rightBlock, r, rightBase, count, options);
+
+                result.Index += match;
+                result.LeftCount += match;
+                result.RightCount += match;
+
+                if (match != count)
+                {
+                    result.Diverged = true;
+                    result.Left = leftBlock->Record(l + match);
+                    result.Right = rightBlock->Record(r + match);
+                    result.Fields = DifferingFields(result.Left, leftBase, result.Right, rightBase, options);
+                    result.LeftCount += 1u;
+                    result.RightCount += 1u;
+                    CollectHistory(*previousLeft, *leftBlock, l + match, options.History, result.History);
+                    return result;
+                }
+
+                l += count;
+                r += count;
+            }
+        }
+
+        // Index of the first of count records from l and r where the selected fields differ,
+        // count if they all match
+        static uint32 FirstDifference(TraceBlock const & left, uint32 l, uint64 leftBase,
+            TraceBlock const & right, uint32 r, uint64 rightBase, uint32 count, Options const & options)
+        {
+            auto fields = options.Fields;
+            auto statusMask = options.StatusMask;
+
+            for (uint32 begin = 0; begin < count; begin += GROUP)
+            {
+                auto n = std::min(GROUP, count - begin);
+                auto li = l + begin, ri = r + begin;
+                alignas(32) Byte diff[GROUP] = { };
+
+                if (fields & FIELD_CYCLE)
+                {
+                    for (uint32 k = 0; k < n; ++k)
+                        diff[k] |= (left.Cycle[li + k] - leftBase) != (right.Cycle[ri + k] - rightBase) ? 1 : 0;
+                }
+
+                if (fields & FIELD_PC)
+                {
+                    for (uint32 k = 0; k < n; ++k)
+                        diff[k] |= left.PC[li + k] != right.PC[ri + k] ? 1 : 0;
+                }
+
+                if (fields & FIELD_OPCODE)
+                    OrDifferences(diff, left.OpCode + li, right.OpCode + ri, n, 0xFF);
+
+                if (fields & FIELD_OPERANDS)
+                {
+                    for (uint32 k = 0; k < n; ++k)
+                    {
+                        auto opCode = left.OpCode[li + k];
+                        diff[k] |= ((left.Operand1[li + k] ^ right.Operand1[ri + k]) & TraceOperandMasks[0][opCode])
+                            | ((left.Operand2[li + k] ^ right.Operand2[ri + k]) & TraceOperandMasks[1][opCode]);
+                    }
+                }
+
+                if (fields & FIELD_A)
+                    OrDifferences(diff, left.A + li, right.A + ri, n, 0xFF);
+                if (fields & FIELD_X)
+                    OrDifferences(diff, left.X + li, right.X + ri, n, 0xFF);
+                if (fields & FIELD_Y)
+                    OrDifferences(diff, left.Y + li, right.Y + ri, n, 0xFF);
+                if (fields & FIELD_STATUS)
+                    OrDifferences(diff, left.Status + li, right.Status + ri, n, statusMask);
+                if (fields & FIELD_SP)
+                    OrDifferences(diff, left.SP + li, right.SP + ri, n, 0xFF);
+
+                Byte any = 0;
+                for (uint32 k = 0; k < GROUP; ++k)
+                    any |= diff[k];
+
+                if (any == 0)
+                    continue;
+
+                for (uint32 k = 0; k < n; ++k)
+                {
+                    if (diff[k] != 0)
+                        return begin + k;
+                }
+            }
+
+            return count;
+        }
+
+        static void OrDifferences(Byte * diff, Byte const * left, Byte const * right, uint32 count, Byte mask)
+        {
+            for (uint32 k = 0; k < count; ++k)
+                diff[k] |= (left[k] ^ right[k]) & mask;
+        }
+
+        static uint32 DifferingFields(TraceRecord const & left, uint64 leftBase, TraceRecord const & right, uint64 rightBase, Options const & options)
+        {
+            uint32 fields = 0u;
+            auto operandMask1 = TraceOperandMasks[0][left.OpCode];
+            auto operandMask2 = TraceOperandMasks[1][left.OpCode];
+
+            if (left.Cycle - leftBase != right.Cycle - rightBase)
+                fields |= FIELD_CYCLE;
+            if (left.PC != right.PC)
+                fields |= FIELD_PC;
+            if (left.OpCode != right.OpCode)
+                fields |= FIELD_OPCODE;
+            if (((left.Operand1 ^ right.Operand1) & operandMask1) != 0 || ((left.Operand2 ^ right.Operand2) & operandMask2) != 0)
+                fields |= FIELD_OPERANDS;
+            if (left.A != right.A)
+                fields |= FIELD_A;
+            if (left.X != right.X)
+                fields |= FIELD_X;
+            if (left.Y != right.Y)
+                fields |= FIELD_Y;
+            if (((left.Status ^ right.Status) & options.StatusMask) != 0)
+                fields |= FIELD_STATUS;
+            if (left.SP != right.SP)
+                fields |= FIELD_SP;
+
+            return fields & options.Fields;
+        }
+
+        // Up to count records before index in current, reaching back into previous
+        static void CollectHistory(TraceBlock const & previous, TraceBlock const & current, uint32 index, uint32 count, std::vector<TraceRecord> & history)
+        {
+            count = std::min(count, TraceBlock::CAPACITY);
+
+            auto fromPrevious = count > index ? std::min(count - index, previous.Count) : 0u;
+            for (auto i = previous.Count - fromPrevious; i < previous.Count; ++i)
+                history.push_back(previous.Record(i));
+
+            for (auto i = index - std::min(count, index); i < index; ++i)
+                history.push_back(current.Record(i));
+        }
+
+        static std::string FormatRecord(TraceRecord const & record)
+        {
+            return fmt::format("{:04X}  {:02X} {:02X} {:02X}  {:<3}  A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X} CYC:{}",
+                record.PC, record.OpCode, record.Operand1, record.Operand2,
+                CPU::OpCodeTable[record.OpCode].Implemented ? Mnemonic(CPU::OpCodeTable[record.OpCode].Op) : "???",
+                record.A, record.X, record.Y, record.Status, record.SP, record.Cycle);
+        }
+
+        static std::string FieldNames(uint32 fields)
+        {
+            static constexpr char const * Names[] = { "cycle", "PC", "opcode", "operands", "A", "X", "Y", "P", "SP" };
+
+            std::string out;
+            for (uint32 i = 0; i < std::size(Names); ++i)
+            {
+                if (fields & (1u << i))
+                {
+                    if (!out.empty())
+                        out += ", ";
+                    out += Names[i];
+                }
+            }
+            return out;
+        }
+    };
+
+
+    inline std::string TraceDiff::Result::Format() const
+    {
+        std::string out;
+
+        if (!Diverged)
+        {
+            out = fmt::format("Traces match over {} records\n", Index);
+            if (!Complete)
+                out += "One of the traces could not be read to the end\n";
+            return out;
+        }
+
+        if (Fields == 0)
+        {
+            out = fmt::format("The {} trace ends after {} records\n", LeftCount > RightCount ? "right" : "left", Index);
+        }
+        else
+        {
+            out = fmt::format("First divergence at record {}, differing in {}\n", Index, FieldNames(Fields));
+        }
+
+        for (auto const & record : History)
+            fmt::format_to(std::back_inserter(out), "        {}\n", FormatRecord(record));
+
+        if (LeftCount > Index)
+            fmt::format_to(std::back_inserter(out), "left  > {}\n", FormatRecord(Left));
+        if (RightCount > Index)
+            fmt::format_to(std::back_inserter(out), "right > {}\n", FormatRecord(Right));
+
+        return out;
+    }
+
+}
@@ -0,0 +1,103 @@
+#include <Emu/TraceRecorder.hpp>
+
+#include <chrono>
+
+
+namespace Emu
+{
+
+    TraceRecorder::TraceRecorder(CPU const & cpu, Memory const & memory, char const * path, bool pack, uint32 ringBlocks)
+        : Cpu(cpu), Ram(memory), Pack(pack), RingSize(std::max(2u, ringBlocks)), Cycle(cpu.TotalCycles)
+    {
+        // Default initialised, the columns are only read up to Count so they are not cleared
+        Blocks.reset(new TraceBlock[RingSize]);
+        Current = &Blocks[0];
+
+        File = fopen(path, "wb");
+        if (File == nullptr)
+            return;
+
+        std::vector<Byte> header;
+        TraceFile::EncodeHeader(Pack, header);
+        if (fwrite(header.data(), 1, header.size(), File) != header.size())
+            Failed = true;
+
+        Writer = std::thread([this]() { WriterLoop(); });
+    }
+
+    TraceRecorder::~TraceRecorder()
+    {
+        Stop();
+    }
+
+    bool TraceRecorder::Stop()
+    {
+        if (File == nullptr)
+            return false;
+
+        if (Current->Count != 0)
+            Publish();
+
+        Stopping.store(true, std::memory_order_release);
+        Writer.join();
+
+        if (fclose(File) != 0)
+            Failed = true;
+        File = nullptr;
+
+        return !Failed;
+    }
+
+    void TraceRecorder::Publish()
+    {
+        Recorded += Current->Count;
+
+        // Without a file the block is just reused
+        if (File == nullptr)
+        {
+            Current->Count = 0u;
+            return;
+        }
+
+        auto head = Head.load(std::memory_order_relaxed) + 1;
+        Head.store(head, std::memory_order_release);
+
+        // The next block is free once the writer is less than a ring behind
+        while (head - Tail.load(std::memory_order_acquire) >= RingSize)
+            std::this_thread::yield();
+
+        Current = &Blocks[head % RingSize];
+        Current->Count = 0u;
+    }
+
+    void TraceRecorder::WriterLoop()
+    {
+        std::vector<Byte> encoded;
+        uint64 tail = 0u;
+
+        for (;;)
+        {
+            if (tail == Head.load(std::memory_order_acquire))
+            {
+                // Stop hands over the last block before setting Stopping, look once more
+                if (Stopping.load(std::memory_order_acquire))
+                {
+                    if (tail == Head.load(std::memory_order_acquire))
+                        return;
+                    continue;
+                }
+
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+
+            encoded.clear();
+            TraceFile::Encode(Blocks[tail % RingSize], Pack, encoded);
+            Tail.store(++tail, std::memory_order_release);
+
+            if (fwrite(encoded.data(), 1, encoded.size(), File) != encoded.size())
+                Failed = true;
+        }
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Trace.hpp>
+
+
+namespace Emu
+{
+
+    // Profiling policy for CPU::ExecuteProfiled writing every instruction to a trace file. The
+    // emulation thread fills blocks of a ring in place, column by column, and hands each full
+    // one to a writer thread that encodes and writes it, one producer and one consumer agreeing
+    // through two counters. When the writer falls a whole ring behind the emulation waits for it
+    // rather than dropping records. Cycles are counted from where the CPU is when recording
+    // starts, so runs have to go through the recorder for them to match TotalCycles.
+    //
+    // Steady state recording (BM_Trace_Run) takes the emulation thread about 1.5x as long as
+    // the same run untraced when nothing else wants its core. With the writer thread sharing a
+    // single core it is about 2.0-2.1x, raw or packed
+    struct TraceRecorder
+    {
+        CPU const & Cpu;
+        Memory const & Ram;
+        FILE * File = nullptr;
+        bool Pack;
+
+        std::unique_ptr<TraceBlock[]> Blocks;
+        uint64 RingSize;
+        alignas(64) std::atomic<uint64> Head { 0u };    // Blocks handed to the writer
+        alignas(64) std::atomic<uint64> Tail { 0u };    // Blocks the writer is done with
+        std::atomic<bool> Stopping { false };
+        std::atomic<bool> Failed { false };
+        std::thread Writer;
+
+        alignas(64) TraceBlock * Current;
+        uint64 Cycle;
+        uint64 Recorded = 0u;
+
+        // Starts the writer, nothing is recorded if the file cannot be created
+        TraceRecorder(CPU const & cpu, Memory const & memory, char const * path, bool pack = false, uint32 ringBlocks = 16);
+        ~TraceRecorder();
+
+        TraceRecorder(TraceRecorder const &) = delete;
+        TraceRecorder & operator=(TraceRecorder const &) = delete;
+
+        bool IsOpen() const
+        {
+            return File != nullptr;
+        }
+
+        EMU_FORCEINLINE void BeforeInstruction()
+        {
+            auto & block = *Current;
+            auto row = block.Count;
+            auto pc = Cpu.PC;
+
+            block.Cycle[row] = Cycle;
+            block.PC[row] = pc;
+            // The opcode and operands from one page lookup unless the instruction crosses a page
+            auto const * host = Ram.ReadPages[pc / Memory::PAGE_SIZE];
+            auto offset = pc % Memory::PAGE_SIZE;
+            if (host != nullptr && offset < Memory::PAGE_SIZE - 2)
+            {
+                auto opCode = host[offset];
+                block.Operand1[row] = host[offset + 1] & TraceOperandMasks[0][opCode];
+                block.Operand2[row] = host[offset + 2] & TraceOperandMasks[1][opCode];
+            }
+            else
+                PeekOperands(block, row, pc);
+
+            block.A[row] = Cpu.A;
+            block.X[row] = Cpu.X;
+            block.Y[row] = Cpu.Y;
+            block.Status[row] = Cpu.CurrentStatus();
+            block.SP[row] = Cpu.SP;
+        }
+
+        EMU_FORCEINLINE void Instruction(Byte opCode, uint32 cycles)
+        {
+            auto & block = *Current;
+            block.OpCode[block.Count] = opCode;
+            Cycle += cycles;
+
+            if (++block.Count == TraceBlock::CAPACITY)
+                Publish();
+        }
+
+        // Interrupt entry has no record of its own, the handler's first instruction shows it
+        void Interrupt(Word, uint32 cycles)
+        {
+            Cycle += cycles;
+        }
+
+        // Writes out what is left and closes the file, false if any write failed. Recording
+        // stops here, the destructor calls it as well
+        bool Stop();
+
+        // Operands that cross into the next page or sit on a device page, only the bytes the
+        // opcode uses are read
+        EMU_NOINLINE void PeekOperands(TraceBlock & block, uint32 row, Word pc) const
+        {
+            auto opCode = Ram.PeekByte(pc);
+            auto length = CPU::OpCodeTable[opCode].Length;
+            block.Operand1[row] = length >= 2 ? Ram.PeekByte(static_cast<Word>(pc + 1)) : 0x00;
+            block.Operand2[row] = length >= 3 ? Ram.PeekByte(static_cast<Word>(pc + 2)) : 0x00;
+        }
+
+        // Hands the current block to the writer and moves on to the next
+        EMU_NOINLINE void Publish();
+
+        void WriterLoop();
+    };
+
+}
\ No newline at end of file
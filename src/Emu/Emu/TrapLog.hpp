@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <Emu/CPU.hpp>
+
+
+namespace Emu
+{
+
+    // Trap sink keeping the most recent traps in a ring allocated up front, recording one is a
+    // store and an increment. Nothing is formatted until Format is asked for, so a fuzz run
+    // hitting unhandled opcodes constantly pays nothing for text it never reads. Read it
+    // between runs, not while the CPU it is attached to is running
+    struct TrapLog
+    {
+        std::vector<TrapRecord> Entries;
+        uint64 Mask;
+        uint64 Written = 0u;
+
+        // Capacity is rounded up to a power of two
+        explicit TrapLog(size_t capacity = 1024)
+        {
+            size_t size = 1;
+            while (size < capacity)
+                size <<= 1;
+
+            Entries.resize(size);
+            Mask = size - 1;
+        }
+
+        void Attach(CPU & cpu)
+        {
+            cpu.OnTrap = &Record;
+            cpu.TrapContext = this;
+        }
+
+        static void Record(void * context, TrapRecord const & trap)
+        {
+            auto & log = *static_cast<TrapLog *>(context);
+            log.Entries[log.Written & log.Mask] = trap;
+            ++log.Written;
+        }
+
+        // Traps seen, including any the ring no longer holds
+        uint64 Count() const
+        {
+            return Written;
+        }
+
+        uint64 Dropped() const
+        {
+            return Written > Entries.size() ? Written - Entries.size() : 0u;
+        }
+
+        // Retained traps, oldest first
+        std::vector<TrapRecord> Snapshot() const
+        {
+            std::vector<TrapRecord> traps;
+            traps.reserve(static_cast<size_t>(Written - Dropped()));
+
+            for (auto index = Dropped(); index < Written; ++index)
+                traps.push_back(Entries[index & Mask]);
+
+            return traps;
+        }
+
+        void Clear()
+        {
+            Written = 0u;
+        }
+
+        // "Instruction not handled: 02 at $0201, cycle 15"
+        static std::string Format(TrapRecord const & trap)
+        {
+            return fmt::format("Instruction not handled: {:02X} at ${:04X}, cycle {}", trap.OpCode, trap.PC, trap.Cycle);
+        }
+
+        // One line per retained trap, oldest first, after a line for any that were dropped
+        std::string Format() const
+        {
+            std::string out;
+            if (Dropped() != 0)
+                out += fmt::format("{} earlier traps dropped\n", Dropped());
+
+            for (auto const & trap : Snapshot())
+                out += Format(trap) + "\n";
+
+            return out;
+        }
+    };
+
+}
\ No newline at end of file
@@ -4,10 +4,21 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <array>
 #include <cstring>
 #include <limits>
-
-#include <fmt/format.h>
+#include <memory>
+#include <utility>
+
+
+// Keeps rarely taken paths out of the hot code and the memory fast paths inside it
+#if defined(_MSC_VER)
+    #define EMU_NOINLINE __declspec(noinline)
+    #define EMU_FORCEINLINE __forceinline
+#else
+    #define EMU_NOINLINE __attribute__((noinline))
+    #define EMU_FORCEINLINE inline __attribute__((always_inline))
+#endif
 
 
 namespace Emu
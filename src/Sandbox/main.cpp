@@ -1,15 +1,40 @@
 // https://www.youtube.com/watch?v=qJgsuQoy9bc&ab_channel=DavePoo
 
+#include <fmt/format.h>
+
 #include <Emu/CPU.hpp>
+#include <Emu/Loader.hpp>
 #include <Emu/Memory.hpp>
+#include <Emu/TrapLog.hpp>
 
 
-int main()
+int main(int argc, char ** argv)
 {
     Emu::Memory memory;
     Emu::CPU cpu;
+    Emu::TrapLog traps;
 
     cpu.Reset(memory);
+    traps.Attach(cpu);
+
+    // Sandbox <program.prg> runs the program from its load address instead of the built in one
+    if (argc > 1)
+    {
+        auto image = Emu::MapFile(argv[1]);
+        Emu::Word loadAddress = 0;
+
+        if (!Emu::Loader::LoadPrg(memory, image, &loadAddress))
+        {
+            fmt::print("Could not load {}\n", argv[1]);
+            return 1;
+        }
+
+        cpu.PC = loadAddress;
+        cpu.Execute(1000, memory);
+        fmt::print("{}", traps.Format());
+        cpu.DumpState();
+        return 0;
+    }
 
     memory.WriteByte(0xFFFC, Emu::CPU::INS_JSR);
     memory.WriteWord(0xFFFD, 0x4243);
@@ -18,6 +43,7 @@ int main()
 
     cpu.Execute(9, memory);
 
+    fmt::print("{}", traps.Format());
     cpu.DumpState();
 
     return 0;
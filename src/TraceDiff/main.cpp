@@ -0,0 +1,125 @@
+#include <string>
+
+#include <fmt/format.h>
+
+#include <Emu/TraceDiff.hpp>
+
+
+namespace
+{
+
+    // Binary traces are told apart from text logs by their header
+    template <typename TVisit>
+    bool OpenTrace(char const * path, TVisit && visit)
+    {
+        auto image = Emu::MapFile(path);
+
+        Emu::TraceFile binary;
+        if (binary.Open(image))
+        {
+            visit(binary);
+            return true;
+        }
+
+        Emu::TextTrace text;
+        if (text.Open(image))
+        {
+            visit(text);
+            return true;
+        }
+
+        fmt::print("Could not read {} as a trace\n", path);
+        return false;
+    }
+
+    bool ParseFields(std::string const & names, Emu::uint32 & fields)
+    {
+        static constexpr std::pair<char const *, Emu::uint32> Names[] = {
+            { "cycle", Emu::TraceDiff::FIELD_CYCLE },
+            { "pc", Emu::TraceDiff::FIELD_PC },
+            { "opcode", Emu::TraceDiff::FIELD_OPCODE },
+            { "operands", Emu::TraceDiff::FIELD_OPERANDS },
+            { "a", Emu::TraceDiff::FIELD_A },
+            { "x", Emu::TraceDiff::FIELD_X },
+            { "y", Emu::TraceDiff::FIELD_Y },
+            { "p", Emu::TraceDiff::FIELD_STATUS },
+            { "sp", Emu::TraceDiff::FIELD_SP } };
+
+        size_t begin = 0;
+        while (begin <= names.size())
+        {
+            auto end = std::min(names.find(',', begin), names.size());
+            auto name = names.substr(begin, end - begin);
+
+            auto found = false;
+            for (auto const & [known, field] : Names)
+            {
+                if (name == known)
+                {
+                    fields &= ~field;
+                    found = true;
+                }
+            }
+
+            if (!found)
+                return false;
+
+            begin = end + 1;
+        }
+
+        return true;
+    }
+
+}
+
+
+// TraceDiff <left> <right> [--history n] [--status-mask hex] [--ignore field,...]
+//
+// Compares two traces, each a binary trace from TraceRecorder or a nestest style text log, and
+// reports the first record where they differ. Fields are cycle, pc, opcode, operands, a, x, y,
+// p and sp. Exits with 0 when the traces match, 1 when they diverge and 2 on bad input
+int main(int argc, char ** argv)
+{
+    if (argc < 3 || argc % 2 == 0)
+    {
+        fmt::print("Usage: TraceDiff <left> <right> [--history n] [--status-mask hex] [--ignore field,...]\n");
+        return 2;
+    }
+
+    Emu::TraceDiff::Options options;
+
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+
+        if (option == "--history")
+            options.History = static_cast<Emu::uint32>(std::strtoul(argv[i + 1], nullptr, 10));
+        else if (option == "--status-mask")
+            options.StatusMask = static_cast<Emu::Byte>(std::strtoul(argv[i + 1], nullptr, 16));
+        else if (option != "--ignore" || !ParseFields(argv[i + 1], options.Fields))
+        {
+            fmt::print("Unknown option {} {}\n", option, argv[i + 1]);
+            return 2;
+        }
+    }
+
+    Emu::TraceDiff::Result result;
+    auto rightOpened = false;
+    auto leftOpened = OpenTrace(argv[1], [&](auto const & left)
+    {
+        rightOpened = OpenTrace(argv[2], [&](auto const & right)
+        {
+            result = Emu::TraceDiff::Compare(left, right, options);
+        });
+    });
+
+    if (!leftOpened || !rightOpened)
+        return 2;
+
+    fmt::print("{}", result.Format());
+
+    if (!result.Complete)
+        return 2;
+
+    return result.Diverged ? 1 : 0;
+}
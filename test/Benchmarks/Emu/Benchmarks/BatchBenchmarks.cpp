@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+
+#include <Emu/BatchRunner.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // Defined in DispatchBenchmarks.cpp
+    void LoadMixedLoop(CPU & cpu, Memory & memory);
+
+    // 1024 machines running the mixed loop for 100k cycles each, the argument is the worker count.
+    // Machines per second should scale with the workers up to the core count
+    static constexpr size_t BatchMachines = 1024;
+    static constexpr uint64 BatchCycles = 100000u;
+
+    void BM_Batch_MixedLoop(benchmark::State & state)
+    {
+        std::vector<CPU> cpus(BatchMachines);
+        std::vector<std::unique_ptr<Memory>> memories;
+        std::vector<BatchMachine> machines;
+        std::vector<BatchResult> results(BatchMachines);
+
+        for (size_t i = 0; i < BatchMachines; ++i)
+        {
+            memories.push_back(std::make_unique<Memory>());
+            LoadMixedLoop(cpus[i], *memories[i]);
+            machines.push_back({ &cpus[i], memories[i].get() });
+        }
+
+        ThreadPool pool(static_cast<uint32>(state.range(0)));
+        BatchRunner runner(pool);
+
+        for (auto _ : state)
+            runner.Run(machines.data(), results.data(), BatchMachines, BatchCycles);
+
+        state.SetItemsProcessed(state.iterations() * BatchMachines);
+        state.counters["cycles/s"] = benchmark::Counter(
+            static_cast<double>(state.iterations() * BatchMachines * BatchCycles), benchmark::Counter::kIsRate);
+    }
+
+    BENCHMARK(BM_Batch_MixedLoop)->RangeMultiplier(2)->Range(1, 16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <benchmark/benchmark.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // Defined in DispatchBenchmarks.cpp
+    void SetEmulationCounters(benchmark::State & state, double instructions, double cycles);
+
+    // Steps one pass of a loop that comes back to where the CPU is now, for the instructions and
+    // cycles in it
+    void MeasureLoop(CPU & cpu, Memory & memory, uint32 & instructions, uint32 & cycles)
+    {
+        auto start = cpu.PC;
+        instructions = 0u;
+        cycles = 0u;
+
+        do
+        {
+            cycles += cpu.Execute(1, memory);
+            ++instructions;
+        }
+        while (cpu.PC != start && !cpu.DebugFlags.UnhandledInstruction);
+    }
+
+    // Whole loops of about this many cycles per Execute so the call itself is noise
+    static constexpr uint32 RunCycles = 20000u;
+
+    // Copies of one instruction filling the code from 0x0200 followed by JMP $0200, so the loop
+    // is almost all the one addressing mode. X and Y are both index, the zero page pointers at
+    // 0x10 and 0x10 + index point at 0x4480 so every indirect mode reads the same data, and the
+    // one at 0x30 points back at 0x0200 for JMP ($0030)
+    static constexpr uint32 ModeRepeats = 64u;
+
+    void BM_AddressingMode(benchmark::State & state, Byte opCode, Word operand, Byte index)
+    {
+        static Memory memory;
+        CPU cpu;
+        cpu.Reset(memory, 0x0200);
+
+        auto const & info = CPU::OpCodeTable[opCode];
+
+        Word pc = 0x0200;
+        for (uint32 i = 0; i < ModeRepeats; ++i)
+        {
+            memory.WriteByte(pc++, opCode);
+            if (info.Length >= 2)
+                memory.WriteByte(pc++, static_cast<Byte>(operand));
+            if (info.Length == 3)
+                memory.WriteByte(pc++, static_cast<Byte>(operand >> 8));
+        }
+
+        memory.WriteByte(pc++, CPU::INS_JMP_ABS);
+        memory.WriteWord(pc, 0x0200);
+
+        memory.WriteWord(static_cast<Byte>(0x10 + index), 0x4480);
+        memory.WriteWord(0x0010, 0x4480);
+        memory.WriteWord(0x0030, 0x0200);
+
+        uint32 loopInstructions, loopCycles;
+        cpu.X = cpu.Y = index;
+        MeasureLoop(cpu, memory, loopInstructions, loopCycles);
+        cpu.X = cpu.Y = index;
+
+        const uint32 iterations = std::max(1u, RunCycles / loopCycles);
+        const uint32 cycles = loopCycles * iterations;
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(cpu.Execute(cycles, memory));
+        }
+
+        if (cpu.DebugFlags.UnhandledInstruction)
+            state.SkipWithError("CPU hit an unhandled instruction");
+
+        SetEmulationCounters(state,
+            static_cast<double>(state.iterations()) * loopInstructions * iterations,
+            static_cast<double>(state.iterations()) * cycles);
+    }
+
+    BENCHMARK_CAPTURE(BM_AddressingMode, Implied, CPU::INS_TSX, 0x0000, 0x00);
+    BENCHMARK_CAPTURE(BM_AddressingMode, Immediate, CPU::INS_LDA_IM, 0x0042, 0x00);
+    BENCHMARK_CAPTURE(BM_AddressingMode, ZeroPage, CPU::INS_LDA_ZP, 0x0020, 0x00);
+    BENCHMARK_CAPTURE(BM_AddressingMode, ZeroPageX, CPU::INS_LDA_ZPX, 0x0020, 0x04);
+    BENCHMARK_CAPTURE(BM_AddressingMode, ZeroPageY, CPU::INS_LDX_ZPY, 0x0020, 0x04);
+    BENCHMARK_CAPTURE(BM_AddressingMode, Absolute, CPU::INS_LDA_ABS, 0x4480, 0x00);
+    BENCHMARK_CAPTURE(BM_AddressingMode, AbsoluteX, CPU::INS_LDA_ABSX, 0x4480, 0x04);
+    BENCHMARK_CAPTURE(BM_AddressingMode, AbsoluteX/PageCross, CPU::INS_LDA_ABSX, 0x4480, 0xFF);
+    BENCHMARK_CAPTURE(BM_AddressingMode, AbsoluteY, CPU::INS_LDA_ABSY, 0x4480, 0x04);
+    BENCHMARK_CAPTURE(BM_AddressingMode, AbsoluteX/Store, CPU::INS_STA_ABSX, 0x4480, 0x04);
+    BENCHMARK_CAPTURE(BM_AddressingMode, IndirectX, CPU::INS_LDA_INDX, 0x0010, 0x04);
+    BENCHMARK_CAPTURE(BM_AddressingMode, IndirectY, CPU::INS_LDA_INDY, 0x0010, 0x04);
+    BENCHMARK_CAPTURE(BM_AddressingMode, IndirectY/PageCross, CPU::INS_LDA_INDY, 0x0010, 0xFF);
+    BENCHMARK_CAPTURE(BM_AddressingMode, Indirect, CPU::INS_JMP_IND, 0x0030, 0x00);
+
+
+    // Power on through the CPU, registers and all of memory
+    void BM_CPU_Reset(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+
+        for (auto _ : state)
+        {
+            memory.WriteByte(0x4480, 0x42);
+            cpu.Reset(memory, 0x0200);
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // Back to a loaded program, only the pages the last run wrote are copied
+    void BM_CPU_ResetToSnapshot(benchmark::State & state)
+    {
+        static Memory memory;
+        static MemorySnapshot snapshot;
+        CPU cpu;
+        memory.Checkpoint(snapshot);
+
+        for (auto _ : state)
+        {
+            memory.WriteByte(0x4480, 0x42);
+            cpu.Reset(memory, snapshot, 0x0200);
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    BENCHMARK(BM_CPU_Reset);
+    BENCHMARK(BM_CPU_ResetToSnapshot);
+
+}
\ No newline at end of file
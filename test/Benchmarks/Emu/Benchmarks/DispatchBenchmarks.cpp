@@ -0,0 +1,323 @@
+#include <benchmark/benchmark.h>
+
+#include <optional>
+
+#include <Emu/CallStackProfiler.hpp>
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+#include <Emu/Profiler.hpp>
+#include <Emu/Recompiler.hpp>
+#include <Emu/Scheduler.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // Tight guest loop touching most of the implemented addressing modes
+    //
+    //  0x0200  LDA #$42        2
+    //  0x0202  AND $10         3
+    //  0x0204  ORA $4480       4
+    //  0x0207  EOR $4480,X     4
+    //  0x020A  STA $20         3
+    //  0x020C  LDX #$01        2
+    //  0x020E  LDY $11         3
+    //  0x0210  PHA             3
+    //  0x0211  PLA             4
+    //  0x0212  JMP $0200       3
+    static constexpr uint32 MixedLoopInstructions = 10u;
+    static constexpr uint32 MixedLoopCycles = 31u;
+
+    void LoadMixedLoop(CPU & cpu, Memory & memory)
+    {
+        cpu.Reset(memory, 0x0200);
+
+        Word pc = 0x0200;
+        auto emit = [&memory, &pc](Byte value) { memory.WriteByte(pc++, value); };
+
+        emit(CPU::INS_LDA_IM);   emit(0x42);
+        emit(CPU::INS_AND_ZP);   emit(0x10);
+        emit(CPU::INS_ORA_ABS);  emit(0x80); emit(0x44);
+        emit(CPU::INS_EOR_ABSX); emit(0x80); emit(0x44);
+        emit(CPU::INS_STA_ZP);   emit(0x20);
+        emit(CPU::INS_LDX_IM);   emit(0x01);
+        emit(CPU::INS_LDY_ZP);   emit(0x11);
+        emit(CPU::INS_PHA);
+        emit(CPU::INS_PLA);
+        emit(CPU::INS_JMP_ABS);  emit(0x00); emit(0x02);
+
+        memory.WriteByte(0x0010, 0x7F);
+        memory.WriteByte(0x0011, 0x81);
+        memory.WriteByte(0x4480, 0x11);
+        memory.WriteByte(0x4481, 0x22);
+    }
+
+    // Call/return heavy loop
+    //
+    //  0x0200  JSR $0300       6
+    //  0x0203  JMP $0200       3
+    //  0x0300  LDA $10         3
+    //  0x0302  RTS             6
+    static constexpr uint32 SubroutineLoopInstructions = 4u;
+    static constexpr uint32 SubroutineLoopCycles = 18u;
+
+    void LoadSubroutineLoop(CPU & cpu, Memory & memory)
+    {
+        cpu.Reset(memory, 0x0200);
+
+        memory.WriteByte(0x0200, CPU::INS_JSR);
+        memory.WriteWord(0x0201, 0x0300);
+        memory.WriteByte(0x0203, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0204, 0x0200);
+
+        memory.WriteByte(0x0300, CPU::INS_LDA_ZP);
+        memory.WriteByte(0x0301, 0x10);
+        memory.WriteByte(0x0302, CPU::INS_RTS);
+    }
+
+    // Guest work over the whole run as rates. cycles/s is the emulated clock, 800M/s is an
+    // 800 MHz 6502, and time/instruction is host time for each guest instruction
+    void SetEmulationCounters(benchmark::State & state, double instructions, double cycles)
+    {
+        state.counters["instructions/s"] = benchmark::Counter(instructions, benchmark::Counter::kIsRate);
+        state.counters["cycles/s"] = benchmark::Counter(cycles, benchmark::Counter::kIsRate);
+        state.counters["time/instruction"] = benchmark::Counter(
+            instructions, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    }
+
+    // Switch dispatch as in the Execute the table replaced, over today's handlers so only the
+    // dispatch differs: each handler is inlined into its case. Kept as the reference the Table
+    // and Threaded runs are measured against
+    uint32 RunSwitch(CPU & cpu, uint32 budget, Memory & memory)
+    {
+        static constexpr auto DispatchTable = CPU::MakeDispatchTable(
+            std::make_index_sequence<std::size(CPU::OpCodeDescriptions)>{});
+
+        uint32 cycles = budget;
+
+        while (CPU::HasCycles(cycles))
+        {
+            #define EMU_SWITCH_CASE(OpCode)                                         \
+                case OpCode:                                                        \
+                    cycles = DispatchTable[OpCode](cpu, cycles, memory);            \
+                    if constexpr (DispatchTable[OpCode] == &CPU::UnhandledInstruction) \
+                        return cpu.Leave(budget - cycles);                          \
+                    break;
+
+            switch (cpu.FetchByte(cycles, memory))
+            {
+                EMU_FOR_EACH_OPCODE(EMU_SWITCH_CASE)
+            }
+
+            #undef EMU_SWITCH_CASE
+        }
+
+        return cpu.Leave(budget - cycles);
+    }
+
+    uint32 ExecuteSwitch(CPU & cpu, uint32 cycles, Memory & memory)
+    {
+        return cpu.Budgeted(cycles, [&](uint32 budget) { return RunSwitch(cpu, budget, memory); });
+    }
+
+    using ExecuteFunction = uint32 (CPU::*)(uint32, Memory &);
+
+    template <typename Execute>
+    void RunLoop(
+        benchmark::State & state,
+        Execute execute,
+        void (*load)(CPU &, Memory &),
+        uint32 loopInstructions,
+        uint32 loopCycles)
+    {
+        static Memory memory;
+        CPU cpu;
+        load(cpu, memory);
+
+        const uint32 iterations = static_cast<uint32>(state.range(0));
+        const uint32 cycles = loopCycles * iterations;
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(execute(cpu, cycles, memory));
+        }
+
+        if (cpu.DebugStatus != 0)
+            state.SkipWithError("CPU reported a debug status");
+
+        SetEmulationCounters(state,
+            static_cast<double>(state.iterations()) * loopInstructions * iterations,
+            static_cast<double>(state.iterations()) * cycles);
+    }
+
+    void BM_Dispatch_MixedLoop(benchmark::State & state, ExecuteFunction execute)
+    {
+        auto run = [execute](CPU & cpu, uint32 cycles, Memory & memory) { return (cpu.*execute)(cycles, memory); };
+        RunLoop(state, run, LoadMixedLoop, MixedLoopInstructions, MixedLoopCycles);
+    }
+
+    void BM_Dispatch_SubroutineLoop(benchmark::State & state, ExecuteFunction execute)
+    {
+        auto run = [execute](CPU & cpu, uint32 cycles, Memory & memory) { return (cpu.*execute)(cycles, memory); };
+        RunLoop(state, run, LoadSubroutineLoop, SubroutineLoopInstructions, SubroutineLoopCycles);
+    }
+
+    void BM_Switch_MixedLoop(benchmark::State & state)
+    {
+        RunLoop(state, ExecuteSwitch, LoadMixedLoop, MixedLoopInstructions, MixedLoopCycles);
+    }
+
+    void BM_Switch_SubroutineLoop(benchmark::State & state)
+    {
+        RunLoop(state, ExecuteSwitch, LoadSubroutineLoop, SubroutineLoopInstructions, SubroutineLoopCycles);
+    }
+
+    void BM_BlockCache_MixedLoop(benchmark::State & state)
+    {
+        BlockCache cache;
+        auto run = [&cache](CPU & cpu, uint32 cycles, Memory & memory) { return cpu.Execute(cycles, memory, cache); };
+        RunLoop(state, run, LoadMixedLoop, MixedLoopInstructions, MixedLoopCycles);
+    }
+
+    void BM_BlockCache_SubroutineLoop(benchmark::State & state)
+    {
+        BlockCache cache;
+        auto run = [&cache](CPU & cpu, uint32 cycles, Memory & memory) { return cpu.Execute(cycles, memory, cache); };
+        RunLoop(state, run, LoadSubroutineLoop, SubroutineLoopInstructions, SubroutineLoopCycles);
+    }
+
+    void BM_Recompiler_MixedLoop(benchmark::State & state)
+    {
+        Recompiler recompiler;
+        auto run = [&recompiler](CPU & cpu, uint32 cycles, Memory & memory) { return cpu.Execute(cycles, memory, recompiler); };
+        RunLoop(state, run, LoadMixedLoop, MixedLoopInstructions, MixedLoopCycles);
+    }
+
+    void BM_Recompiler_SubroutineLoop(benchmark::State & state)
+    {
+        Recompiler recompiler;
+        auto run = [&recompiler](CPU & cpu, uint32 cycles, Memory & memory) { return cpu.Execute(cycles, memory, recompiler); };
+        RunLoop(state, run, LoadSubroutineLoop, SubroutineLoopInstructions, SubroutineLoopCycles);
+    }
+
+    // Table dispatch through ExecuteProfiled with the empty policy, the profiled runs below are
+    // measured against these rather than the Table runs so both sides are the same loop
+    void BM_Unprofiled_MixedLoop(benchmark::State & state)
+    {
+        NoProfiler profiler;
+        auto run = [&profiler](CPU & cpu, uint32 cycles, Memory & memory) { return cpu.ExecuteProfiled(cycles, memory, profiler); };
+        RunLoop(state, run, LoadMixedLoop, MixedLoopInstructions, MixedLoopCycles);
+    }
+
+    void BM_Unprofiled_SubroutineLoop(benchmark::State & state)
+    {
+        NoProfiler profiler;
+        auto run = [&profiler](CPU & cpu, uint32 cycles, Memory & memory) { return cpu.ExecuteProfiled(cycles, memory, profiler); };
+        RunLoop(state, run, LoadSubroutineLoop, SubroutineLoopInstructions, SubroutineLoopCycles);
+    }
+
+    // Table dispatch counting every instruction
+    void BM_Profiled_MixedLoop(benchmark::State & state)
+    {
+        OpCodeProfiler profiler;
+        auto run = [&profiler](CPU & cpu, uint32 cycles, Memory & memory) { return cpu.ExecuteProfiled(cycles, memory, profiler); };
+        RunLoop(state, run, LoadMixedLoop, MixedLoopInstructions, MixedLoopCycles);
+    }
+
+    // Table dispatch following the guest call stack, the subroutine loop is its worst case. The
+    // profiler is made on the first run as it keeps a reference to the CPU RunLoop makes
+    void BM_CallStack_MixedLoop(benchmark::State & state)
+    {
+        std::optional<CallStackProfiler> profiler;
+        auto run = [&profiler](CPU & cpu, uint32 cycles, Memory & memory)
+        {
+            if (!profiler)
+                profiler.emplace(cpu);
+            return cpu.ExecuteProfiled(cycles, memory, *profiler);
+        };
+        RunLoop(state, run, LoadMixedLoop, MixedLoopInstructions, MixedLoopCycles);
+    }
+
+    void BM_CallStack_SubroutineLoop(benchmark::State & state)
+    {
+        std::optional<CallStackProfiler> profiler;
+        auto run = [&profiler](CPU & cpu, uint32 cycles, Memory & memory)
+        {
+            if (!profiler)
+                profiler.emplace(cpu);
+            return cpu.ExecuteProfiled(cycles, memory, *profiler);
+        };
+        RunLoop(state, run, LoadSubroutineLoop, SubroutineLoopInstructions, SubroutineLoopCycles);
+    }
+
+    // The default back end through the scheduler with nothing scheduled, what the sampled runs
+    // below are measured against
+    void BM_Scheduled_MixedLoop(benchmark::State & state)
+    {
+        Scheduler scheduler;
+        auto run = [&scheduler](CPU & cpu, uint32 cycles, Memory & memory) { return cpu.Execute(cycles, memory, scheduler); };
+        RunLoop(state, run, LoadMixedLoop, MixedLoopInstructions, MixedLoopCycles);
+    }
+
+    void BM_Scheduled_SubroutineLoop(benchmark::State & state)
+    {
+        Scheduler scheduler;
+        auto run = [&scheduler](CPU & cpu, uint32 cycles, Memory & memory) { return cpu.Execute(cycles, memory, scheduler); };
+        RunLoop(state, run, LoadSubroutineLoop, SubroutineLoopInstructions, SubroutineLoopCycles);
+    }
+
+    // Sampling the guest call stack every 1000 cycles on average
+    void BM_Sampled_MixedLoop(benchmark::State & state)
+    {
+        Scheduler scheduler;
+        std::optional<CallStackSampler> sampler;
+        auto run = [&scheduler, &sampler](CPU & cpu, uint32 cycles, Memory & memory)
+        {
+            if (!sampler)
+                sampler.emplace(cpu, memory, scheduler);
+            return cpu.ExecuteProfiled(cycles, memory, scheduler, *sampler);
+        };
+        RunLoop(state, run, LoadMixedLoop, MixedLoopInstructions, MixedLoopCycles);
+    }
+
+    void BM_Sampled_SubroutineLoop(benchmark::State & state)
+    {
+        Scheduler scheduler;
+        std::optional<CallStackSampler> sampler;
+        auto run = [&scheduler, &sampler](CPU & cpu, uint32 cycles, Memory & memory)
+        {
+            if (!sampler)
+                sampler.emplace(cpu, memory, scheduler);
+            return cpu.ExecuteProfiled(cycles, memory, scheduler, *sampler);
+        };
+        RunLoop(state, run, LoadSubroutineLoop, SubroutineLoopInstructions, SubroutineLoopCycles);
+    }
+
+    BENCHMARK(BM_Switch_MixedLoop)->Arg(1000);
+    BENCHMARK(BM_Switch_SubroutineLoop)->Arg(1000);
+
+    BENCHMARK_CAPTURE(BM_Dispatch_MixedLoop, Table, &CPU::ExecuteTable)->Arg(1000);
+    BENCHMARK_CAPTURE(BM_Dispatch_SubroutineLoop, Table, &CPU::ExecuteTable)->Arg(1000);
+
+#if EMU_THREADED_DISPATCH
+    BENCHMARK_CAPTURE(BM_Dispatch_MixedLoop, Threaded, &CPU::ExecuteThreaded)->Arg(1000);
+    BENCHMARK_CAPTURE(BM_Dispatch_SubroutineLoop, Threaded, &CPU::ExecuteThreaded)->Arg(1000);
+#endif
+
+    BENCHMARK(BM_Unprofiled_MixedLoop)->Arg(1000);
+    BENCHMARK(BM_Unprofiled_SubroutineLoop)->Arg(1000);
+    BENCHMARK(BM_Profiled_MixedLoop)->Arg(1000);
+    BENCHMARK(BM_CallStack_MixedLoop)->Arg(1000);
+    BENCHMARK(BM_CallStack_SubroutineLoop)->Arg(1000);
+    BENCHMARK(BM_Scheduled_MixedLoop)->Arg(1000);
+    BENCHMARK(BM_Scheduled_SubroutineLoop)->Arg(1000);
+    BENCHMARK(BM_Sampled_MixedLoop)->Arg(1000);
+    BENCHMARK(BM_Sampled_SubroutineLoop)->Arg(1000);
+
+    BENCHMARK(BM_BlockCache_MixedLoop)->Arg(1000);
+    BENCHMARK(BM_BlockCache_SubroutineLoop)->Arg(1000);
+
+    BENCHMARK(BM_Recompiler_MixedLoop)->Arg(1000);
+    BENCHMARK(BM_Recompiler_SubroutineLoop)->Arg(1000);
+
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include <Emu/Fork.hpp>
+
+#if defined(__linux__)
+    #include <unistd.h>
+#endif
+
+
+namespace Emu::Benchmarks
+{
+
+    // Branches one machine into 10k children that each write a few bytes, comparing copy-on-write
+    // forks against copying the whole memory. ResidentKB is what the children add to the process
+    static constexpr uint32 Children = 10000u;
+    static constexpr uint32 WritesPerChild = 4u;
+
+    // Resident set in KB, 0 where the platform does not say
+    uint64 ResidentKB()
+    {
+#if defined(__linux__)
+        std::ifstream statm("/proc/self/statm");
+        uint64 size = 0, resident = 0;
+        statm >> size >> resident;
+        return resident * static_cast<uint64>(sysconf(_SC_PAGESIZE)) / 1024;
+#else
+        return 0;
+#endif
+    }
+
+    void Warm(CPU & cpu, Memory & memory)
+    {
+        memory.Initialize();
+        cpu.Reset(memory, 0x0200);
+
+        for (uint32 address = 0; address < Memory::MAX_MEMORY; ++address)
+            memory.WriteByte(address, static_cast<Byte>(address * 7));
+    }
+
+    template <typename TChild, typename TFork>
+    void RunForks(benchmark::State & state, TFork fork)
+    {
+        std::vector<TChild> children;
+        children.reserve(Children);
+        uint64 resident = 0;
+
+        for (auto _ : state)
+        {
+            auto before = ResidentKB();
+
+            for (uint32 i = 0; i < Children; ++i)
+            {
+                auto & child = children.emplace_back(fork());
+                for (uint32 write = 0; write < WritesPerChild; ++write)
+                    child.Ram->WriteByte(static_cast<Word>(i * 131 + write * 4099), static_cast<Byte>(i));
+            }
+
+            resident = std::max(resident, ResidentKB() - before);
+
+            state.PauseTiming();
+            children.clear();
+            state.ResumeTiming();
+        }
+
+        state.SetItemsProcessed(state.iterations() * Children);
+        state.counters["ResidentKB"] = static_cast<double>(resident);
+    }
+
+    void BM_Fork_CopyOnWrite(benchmark::State & state)
+    {
+        CPU cpu;
+        Memory memory;
+        Warm(cpu, memory);
+        ForkPoint point(cpu, memory);
+
+        RunForks<ForkedMachine>(state, [&]() { return point.Fork(); });
+    }
+
+    void BM_Fork_FullCopy(benchmark::State & state)
+    {
+        struct CopiedMachine
+        {
+            CPU Cpu;
+            std::unique_ptr<Memory> Ram;
+        };
+
+        CPU cpu;
+        Memory memory;
+        Warm(cpu, memory);
+
+        RunForks<CopiedMachine>(state, [&]() { return CopiedMachine { cpu, std::make_unique<Memory>(memory) }; });
+    }
+
+    BENCHMARK(BM_Fork_CopyOnWrite)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_Fork_FullCopy)->Unit(benchmark::kMillisecond);
+
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/InputLog.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // Defined in DispatchBenchmarks.cpp
+    void SetEmulationCounters(benchmark::State & state, double instructions, double cycles);
+
+    // Counts through $0010 by table lookup, 13 cycles and 4 instructions a pass. The IRQ
+    // handler only returns
+    static void LoadInputCounter(CPU & cpu, Memory & memory)
+    {
+        cpu.Reset(memory, 0x0200);
+
+        for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+            memory.WriteByte(0x3000 + i, static_cast<Byte>(i + 1));
+
+        memory.WriteByte(0x0200, CPU::INS_LDX_ZP);
+        memory.WriteByte(0x0201, 0x10);
+        memory.WriteByte(0x0202, CPU::INS_LDA_ABSX);
+        memory.WriteWord(0x0203, 0x3000);
+        memory.WriteByte(0x0205, CPU::INS_STA_ZP);
+        memory.WriteByte(0x0206, 0x10);
+        memory.WriteByte(0x0207, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0208, 0x0200);
+
+        memory.WriteWord(CPU::IRQ_VECTOR, 0x0300);
+        memory.WriteByte(0x0300, CPU::INS_RTI);
+    }
+
+    static constexpr uint64 ReplayRunCycles = 10000000u;
+    static constexpr uint32 ReplayEventInterval = 10000u;
+
+    // Replaying a run with a write and a one instruction IRQ pulse every 10k cycles, against
+    // running the same cycles through the scheduler with nothing injected
+    void BM_InputLog_Replay(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        Scheduler scheduler;
+        InputDevices devices;
+        auto replaying = state.range(0) != 0;
+
+        LoadInputCounter(cpu, memory);
+        InputRecorder recorder(cpu, memory, scheduler, devices);
+
+        while (cpu.TotalCycles < ReplayRunCycles)
+        {
+            cpu.Execute(ReplayEventInterval, memory, scheduler);
+            recorder.WriteByte(0x0010, static_cast<Byte>(cpu.TotalCycles));
+            recorder.RaiseIrq();
+            cpu.Execute(1, memory, scheduler);
+            recorder.ClearIrq();
+        }
+
+        auto end = cpu.TotalCycles;
+        auto const & log = recorder.Log;
+
+        for (auto _ : state)
+        {
+            Scheduler fresh;
+
+            if (replaying)
+            {
+                benchmark::DoNotOptimize(log.Replay(cpu, memory, fresh, devices, end));
+            }
+            else
+            {
+                SaveState::Restore(log.StartState, cpu, memory);
+                InputLog::RunTo(end, cpu, memory, fresh);
+            }
+
+            benchmark::DoNotOptimize(cpu.TotalCycles);
+        }
+
+        state.counters["log_bytes"] = static_cast<double>(log.Encode().size() - log.StartState.Size);
+        SetEmulationCounters(state,
+            static_cast<double>(state.iterations()) * end * 4 / 13,
+            static_cast<double>(state.iterations()) * end);
+    }
+
+    BENCHMARK(BM_InputLog_Replay)->ArgName("replaying")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+}
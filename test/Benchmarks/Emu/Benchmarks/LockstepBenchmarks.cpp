@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <Emu/Lockstep.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // Defined in DispatchBenchmarks.cpp
+    void LoadMixedLoop(CPU & cpu, Memory & memory);
+
+    // The mixed loop over 256 values of 0x0010, 31 cycles and 10 instructions per iteration. The
+    // argument is the iteration count
+    static constexpr uint32 SweepLanes = 256u;
+    static constexpr uint32 SweepLoopInstructions = 10u;
+    static constexpr uint32 SweepLoopCycles = 31u;
+
+    void BM_Sweep_Scalar(benchmark::State & state)
+    {
+        std::vector<CPU> cpus(SweepLanes);
+        std::vector<std::unique_ptr<Memory>> memories;
+
+        for (uint32 lane = 0; lane < SweepLanes; ++lane)
+        {
+            memories.push_back(std::make_unique<Memory>());
+            LoadMixedLoop(cpus[lane], *memories[lane]);
+            memories[lane]->WriteByte(0x0010, static_cast<Byte>(lane));
+        }
+
+        const uint32 cycles = SweepLoopCycles * static_cast<uint32>(state.range(0));
+
+        for (auto _ : state)
+        {
+            for (uint32 lane = 0; lane < SweepLanes; ++lane)
+                benchmark::DoNotOptimize(cpus[lane].Execute(cycles, *memories[lane]));
+        }
+
+        state.counters["instructions/s"] = benchmark::Counter(
+            static_cast<double>(state.iterations()) * SweepLanes * SweepLoopInstructions * state.range(0),
+            benchmark::Counter::kIsRate);
+    }
+
+    void BM_Sweep_Lockstep(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        LoadMixedLoop(cpu, memory);
+
+        auto lockstep = std::make_unique<Lockstep<SweepLanes>>(memory, 0x0200);
+        for (uint32 lane = 0; lane < SweepLanes; ++lane)
+            lockstep->WriteByte(lane, 0x0010, static_cast<Byte>(lane));
+
+        const uint32 cycles = SweepLoopCycles * static_cast<uint32>(state.range(0));
+
+        for (auto _ : state)
+        {
+            lockstep->Run(cycles);
+            benchmark::DoNotOptimize(lockstep->CyclesUsed.data());
+        }
+
+        if (lockstep->DivergedCount() != 0)
+            state.SkipWithError("Lanes diverged");
+
+        state.counters["instructions/s"] = benchmark::Counter(
+            static_cast<double>(state.iterations()) * SweepLanes * SweepLoopInstructions * state.range(0),
+            benchmark::Counter::kIsRate);
+    }
+
+    BENCHMARK(BM_Sweep_Scalar)->Arg(1000);
+    BENCHMARK(BM_Sweep_Lockstep)->Arg(1000);
+
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include <benchmark/benchmark.h>
+
+#include <Emu/Loader.hpp>
+#include <Emu/Memory.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // Walks the address space with a stride that touches every page, comparing the page table
+    // fast path against indexing Data directly
+    static constexpr uint32 Stride = 257u;
+
+    void BM_Memory_DirectRead(benchmark::State & state)
+    {
+        static Memory memory;
+        uint32 address = 0;
+
+        for (auto _ : state)
+        {
+            Byte sum = 0;
+            for (uint32 i = 0; i < Memory::MAX_MEMORY; ++i)
+            {
+                sum += memory.Data[address];
+                address = (address + Stride) & 0xFFFF;
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+
+        state.SetItemsProcessed(state.iterations() * Memory::MAX_MEMORY);
+    }
+
+    void BM_Memory_PageTableRead(benchmark::State & state)
+    {
+        static Memory memory;
+        uint32 address = 0;
+
+        for (auto _ : state)
+        {
+            Byte sum = 0;
+            for (uint32 i = 0; i < Memory::MAX_MEMORY; ++i)
+            {
+                sum += memory.ReadByte(address);
+                address = (address + Stride) & 0xFFFF;
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+
+        state.SetItemsProcessed(state.iterations() * Memory::MAX_MEMORY);
+    }
+
+    void BM_Memory_DirectWrite(benchmark::State & state)
+    {
+        static Memory memory;
+        uint32 address = 0;
+
+        for (auto _ : state)
+        {
+            for (uint32 i = 0; i < Memory::MAX_MEMORY; ++i)
+            {
+                memory.Data[address] = static_cast<Byte>(i);
+                address = (address + Stride) & 0xFFFF;
+            }
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * Memory::MAX_MEMORY);
+    }
+
+    void BM_Memory_PageTableWrite(benchmark::State & state)
+    {
+        static Memory memory;
+        uint32 address = 0;
+
+        for (auto _ : state)
+        {
+            for (uint32 i = 0; i < Memory::MAX_MEMORY; ++i)
+            {
+                memory.WriteByte(address, static_cast<Byte>(i));
+                address = (address + Stride) & 0xFFFF;
+            }
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * Memory::MAX_MEMORY);
+    }
+
+    // Guest writes a handful of pages between resets, the way a fuzz loop or test fixture does
+    static constexpr uint32 PagesWritten = 4u;
+
+    void WriteSomePages(Memory & memory, uint32 iteration)
+    {
+        for (uint32 page = 0; page < PagesWritten; ++page)
+            memory.WriteByte(page * 0x3100 + iteration % Memory::PAGE_SIZE, static_cast<Byte>(iteration));
+    }
+
+    void BM_Memory_FullReset(benchmark::State & state)
+    {
+        static Memory memory;
+        static MemorySnapshot snapshot;
+        uint32 iteration = 0;
+
+        for (auto _ : state)
+        {
+            WriteSomePages(memory, ++iteration);
+            memcpy(memory.Data, snapshot.Data, Memory::MAX_MEMORY);
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_Memory_ResetToSnapshot(benchmark::State & state)
+    {
+        static Memory memory;
+        static MemorySnapshot snapshot;
+        memory.Checkpoint(snapshot);
+        uint32 iteration = 0;
+
+        for (auto _ : state)
+        {
+            WriteSomePages(memory, ++iteration);
+            memory.ResetToSnapshot(snapshot);
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // Bringing a 32KB program into a fresh machine, byte by byte against mapping its pages
+    static constexpr uint32 ProgramSize = 32 * 1024;
+
+    void BM_Memory_LoadByWrites(benchmark::State & state)
+    {
+        static Memory memory;
+        RomImage image(std::vector<Byte>(ProgramSize, 0xEA));
+
+        for (auto _ : state)
+        {
+            for (uint32 i = 0; i < ProgramSize; ++i)
+                memory.WriteByte(0x8000 + i, image.Data()[i]);
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_Memory_LoadMapped(benchmark::State & state)
+    {
+        static Memory memory;
+        RomImage image(std::vector<Byte>(ProgramSize, 0xEA));
+
+        for (auto _ : state)
+        {
+            Loader::LoadRaw(memory, image, 0x8000);
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    BENCHMARK(BM_Memory_DirectRead);
+    BENCHMARK(BM_Memory_PageTableRead);
+    BENCHMARK(BM_Memory_DirectWrite);
+    BENCHMARK(BM_Memory_PageTableWrite);
+    BENCHMARK(BM_Memory_FullReset);
+    BENCHMARK(BM_Memory_ResetToSnapshot);
+    BENCHMARK(BM_Memory_LoadByWrites);
+    BENCHMARK(BM_Memory_LoadMapped);
+
+}
\ No newline at end of file
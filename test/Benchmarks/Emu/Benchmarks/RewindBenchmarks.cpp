@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Rewind.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // Defined in DispatchBenchmarks.cpp
+    void SetEmulationCounters(benchmark::State & state, double instructions, double cycles);
+
+    // Counts through $0010 by table lookup and leaves each count in a page at $4000, 18 cycles
+    // and 5 instructions a pass that write two pages
+    static void LoadCounter(CPU & cpu, Memory & memory)
+    {
+        cpu.Reset(memory, 0x0200);
+
+        for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+            memory.WriteByte(0x3000 + i, static_cast<Byte>(i + 1));
+
+        memory.WriteByte(0x0200, CPU::INS_LDX_ZP);
+        memory.WriteByte(0x0201, 0x10);
+        memory.WriteByte(0x0202, CPU::INS_LDA_ABSX);
+        memory.WriteWord(0x0203, 0x3000);
+        memory.WriteByte(0x0205, CPU::INS_STA_ZP);
+        memory.WriteByte(0x0206, 0x10);
+        memory.WriteByte(0x0207, CPU::INS_STA_ABSX);
+        memory.WriteWord(0x0208, 0x4000);
+        memory.WriteByte(0x020A, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x020B, 0x0200);
+    }
+
+    static constexpr uint64 RewindRunCycles = 1000000u;
+
+    // A million cycles with the default history, against the same run without it
+    void BM_Rewind_Run(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        auto recording = state.range(0) != 0;
+
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            LoadCounter(cpu, memory);
+            RewindBuffer rewind;
+            state.ResumeTiming();
+
+            if (recording)
+                rewind.Run(cpu, memory, RewindRunCycles);
+            else
+                cpu.ExecuteUntil(RewindRunCycles, memory);
+
+            benchmark::DoNotOptimize(cpu.TotalCycles);
+        }
+
+        SetEmulationCounters(state,
+            static_cast<double>(state.iterations()) * RewindRunCycles * 5 / 18,
+            static_cast<double>(state.iterations()) * RewindRunCycles);
+    }
+
+    // Seeking to a cycle some way past the nearest capture, the cost of stepping back
+    void BM_Rewind_Seek(benchmark::State & state)
+    {
+        static Memory memory;
+        static Memory rewoundMemory;
+        CPU cpu, rewound;
+        LoadCounter(cpu, memory);
+        rewound.Reset(rewoundMemory);
+
+        RewindBuffer rewind;
+        rewind.Run(cpu, memory, 5 * RewindRunCycles);
+
+        uint64 cycle = 0;
+        for (auto _ : state)
+        {
+            cycle = (cycle + 777777u) % (5 * RewindRunCycles);
+            benchmark::DoNotOptimize(rewind.Seek(rewound, rewoundMemory, cycle));
+        }
+
+        state.counters["history_bytes"] = static_cast<double>(rewind.MemoryUsed);
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    BENCHMARK(BM_Rewind_Run)->ArgName("recording")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_Rewind_Seek)->Unit(benchmark::kMicrosecond);
+
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+
+#include <Emu/CPU.hpp>
+#include <Emu/SaveState.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // A machine that has run a while, mostly zero RAM with code, a table and some busy pages
+    static void LoadMachine(CPU & cpu, Memory & memory)
+    {
+        cpu.Reset(memory, 0x0200);
+
+        for (uint32 i = 0; i < 0x200; ++i)
+            memory.WriteByte(0x0200 + i, static_cast<Byte>(i % 5 == 0 ? CPU::INS_LDA_IM : i));
+
+        for (uint32 i = 0; i < 8 * Memory::PAGE_SIZE; ++i)
+            memory.WriteByte(0x4000 + i, static_cast<Byte>(i * 37 + 11));
+
+        for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+            memory.WriteByte(0x0100 + i, static_cast<Byte>(i < 0xF0 ? 0 : i));
+
+        cpu.TotalCycles = 123456789u;
+    }
+
+    static std::string StatePath(char const * name)
+    {
+        return (std::filesystem::temp_directory_path() / (std::string("Emu6502_") + name + ".state")).string();
+    }
+
+    static void SetStateCounters(benchmark::State & state, size_t fileSize)
+    {
+        state.SetBytesProcessed(state.iterations() * Memory::MAX_MEMORY);
+        state.counters["file_bytes"] = static_cast<double>(fileSize);
+    }
+
+
+    // The baseline, CPU and RAM written out as they are
+    void BM_SaveState_FwriteStruct(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        LoadMachine(cpu, memory);
+        auto path = StatePath("FwriteStruct");
+
+        for (auto _ : state)
+        {
+            auto * file = fopen(path.c_str(), "wb");
+            fwrite(&cpu, sizeof(cpu), 1, file);
+            fwrite(memory.Data, Memory::MAX_MEMORY, 1, file);
+            fclose(file);
+        }
+
+        SetStateCounters(state, sizeof(cpu) + Memory::MAX_MEMORY);
+        std::filesystem::remove(path);
+    }
+
+    void BM_SaveState_FreadStruct(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        LoadMachine(cpu, memory);
+        auto path = StatePath("FreadStruct");
+
+        auto * file = fopen(path.c_str(), "wb");
+        fwrite(&cpu, sizeof(cpu), 1, file);
+        fwrite(memory.Data, Memory::MAX_MEMORY, 1, file);
+        fclose(file);
+
+        for (auto _ : state)
+        {
+            file = fopen(path.c_str(), "rb");
+            benchmark::DoNotOptimize(fread(&cpu, sizeof(cpu), 1, file));
+            benchmark::DoNotOptimize(fread(memory.Data, Memory::MAX_MEMORY, 1, file));
+            fclose(file);
+        }
+
+        SetStateCounters(state, sizeof(cpu) + Memory::MAX_MEMORY);
+        std::filesystem::remove(path);
+    }
+
+    void BM_SaveState_SaveFile(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        LoadMachine(cpu, memory);
+        auto compress = state.range(0) != 0;
+        auto path = StatePath("SaveFile");
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(SaveState::SaveFile(path.c_str(), cpu, memory, compress));
+        }
+
+        SetStateCounters(state, std::filesystem::file_size(path));
+        std::filesystem::remove(path);
+    }
+
+    // Mapping the file and restoring from it, the mapping is dropped each time so this pays
+    // for the mmap and the page faults on the header and packed pages
+    void BM_SaveState_RestoreFile(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        LoadMachine(cpu, memory);
+        auto path = StatePath("RestoreFile");
+        SaveState::SaveFile(path.c_str(), cpu, memory, state.range(0) != 0);
+
+        static Memory restoredMemory;
+        CPU restored;
+        restored.Reset(restoredMemory);
+
+        for (auto _ : state)
+        {
+            auto image = MapFile(path.c_str());
+            benchmark::DoNotOptimize(SaveState::Restore(image, restored, restoredMemory));
+
+            // The mapping goes with the image, RAM has to stop pointing into it first
+            restoredMemory.Unshare();
+        }
+
+        if (restored.TotalCycles != cpu.TotalCycles || restoredMemory.ReadByte(0x4001) != memory.ReadByte(0x4001))
+            state.SkipWithError("Restored state does not match");
+
+        SetStateCounters(state, std::filesystem::file_size(path));
+        std::filesystem::remove(path);
+    }
+
+    // Restoring from an image already in memory, only what the format itself costs
+    void BM_SaveState_Restore(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        LoadMachine(cpu, memory);
+        RomImage image(SaveState::Save(cpu, memory, state.range(0) != 0));
+
+        static Memory restoredMemory;
+        CPU restored;
+        restored.Reset(restoredMemory);
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(SaveState::Restore(image, restored, restoredMemory));
+        }
+
+        SetStateCounters(state, image.Size);
+    }
+
+    BENCHMARK(BM_SaveState_FwriteStruct);
+    BENCHMARK(BM_SaveState_FreadStruct);
+    BENCHMARK(BM_SaveState_SaveFile)->ArgName("compress")->Arg(0)->Arg(1);
+    BENCHMARK(BM_SaveState_RestoreFile)->ArgName("compress")->Arg(0)->Arg(1);
+    BENCHMARK(BM_SaveState_Restore)->ArgName("compress")->Arg(0)->Arg(1);
+
+}
\ No newline at end of file
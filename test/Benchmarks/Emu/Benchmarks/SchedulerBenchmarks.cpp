@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+
+#include <Emu/Scheduler.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // Defined in DispatchBenchmarks.cpp
+    void LoadMixedLoop(CPU & cpu, Memory & memory);
+
+    static constexpr uint32 SchedulerLoopInstructions = 10u;
+    static constexpr uint32 SchedulerLoopCycles = 31u;
+
+    static void PeriodicTick(void * context, Scheduler & scheduler, Memory & memory, uint64 deadline)
+    {
+        auto period = *static_cast<uint64 *>(context);
+        scheduler.Schedule(deadline + period, &PeriodicTick, context);
+    }
+
+    // The mixed loop through the scheduler, the argument is the event period in cycles with zero
+    // for nothing scheduled. Compare with BM_Dispatch_MixedLoop for the cost of the scheduler
+    void BM_Scheduler_MixedLoop(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        Scheduler scheduler;
+        LoadMixedLoop(cpu, memory);
+
+        uint64 period = static_cast<uint64>(state.range(0));
+        if (period != 0)
+            scheduler.ScheduleIn(period, &PeriodicTick, &period);
+
+        const uint32 iterations = 10000u;
+        const uint32 cycles = SchedulerLoopCycles * iterations;
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(cpu.Execute(cycles, memory, scheduler));
+        }
+
+        if (cpu.DebugFlags.UnhandledInstruction)
+            state.SkipWithError("CPU hit an unhandled instruction");
+
+        state.counters["instructions/s"] = benchmark::Counter(
+            static_cast<double>(state.iterations()) * SchedulerLoopInstructions * iterations,
+            benchmark::Counter::kIsRate);
+    }
+
+    BENCHMARK(BM_Scheduler_MixedLoop)->Arg(0)->Arg(1000)->Arg(100);
+
+}
\ No newline at end of file
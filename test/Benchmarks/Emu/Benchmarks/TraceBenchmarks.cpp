@@ -0,0 +1,170 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <optional>
+
+#include <Emu/CPU.hpp>
+#include <Emu/TraceDiff.hpp>
+#include <Emu/TraceRecorder.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // Defined in DispatchBenchmarks.cpp
+    void SetEmulationCounters(benchmark::State & state, double instructions, double cycles);
+
+    // Counts through $0010 by table lookup, 13 cycles and 4 instructions a pass
+    static void LoadTraceCounter(CPU & cpu, Memory & memory)
+    {
+        cpu.Reset(memory, 0x0200);
+
+        for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+            memory.WriteByte(0x3000 + i, static_cast<Byte>(i + 1));
+
+        memory.WriteByte(0x0200, CPU::INS_LDX_ZP);
+        memory.WriteByte(0x0201, 0x10);
+        memory.WriteByte(0x0202, CPU::INS_LDA_ABSX);
+        memory.WriteWord(0x0203, 0x3000);
+        memory.WriteByte(0x0205, CPU::INS_STA_ZP);
+        memory.WriteByte(0x0206, 0x10);
+        memory.WriteByte(0x0207, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0208, 0x0200);
+    }
+
+    static constexpr uint32 TraceRunCycles = 1300000u;
+
+    // Steady state recording: a run through the profiled loop with no profiler, to a raw trace
+    // file and to a packed one. The recorder is made before the timed runs and stopped after
+    // them, BM_Trace_Setup has that part. The writer thread runs alongside, so this is the
+    // emulation thread's cost
+    void BM_Trace_Run(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        auto mode = state.range(0);
+        auto path = (std::filesystem::temp_directory_path() / "Emu6502_Trace.trace").string();
+        LoadTraceCounter(cpu, memory);
+
+        {
+            std::optional<TraceRecorder> recorder;
+            if (mode != 0)
+                recorder.emplace(cpu, memory, path.c_str(), mode == 2);
+
+            for (auto _ : state)
+            {
+                if (mode == 0)
+                {
+                    NoProfiler profiler;
+                    cpu.ExecuteProfiled(TraceRunCycles, memory, profiler);
+                }
+                else
+                    cpu.ExecuteProfiled(TraceRunCycles, memory, *recorder);
+
+                benchmark::DoNotOptimize(cpu.TotalCycles);
+            }
+        }
+
+        if (mode != 0)
+            state.counters["file_bytes"] = static_cast<double>(std::filesystem::file_size(path)) / static_cast<double>(state.iterations());
+
+        std::error_code error;
+        std::filesystem::remove(path, error);
+
+        SetEmulationCounters(state,
+            static_cast<double>(state.iterations()) * TraceRunCycles * 4 / 13,
+            static_cast<double>(state.iterations()) * TraceRunCycles);
+    }
+
+    // Making a recorder and stopping it with nothing recorded: the ring, the file and the
+    // writer thread
+    void BM_Trace_Setup(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        LoadTraceCounter(cpu, memory);
+        auto path = (std::filesystem::temp_directory_path() / "Emu6502_TraceSetup.trace").string();
+
+        for (auto _ : state)
+        {
+            TraceRecorder recorder(cpu, memory, path.c_str());
+            benchmark::DoNotOptimize(recorder.Stop());
+        }
+
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    // Decoding a packed trace back into blocks
+    void BM_Trace_Read(benchmark::State & state)
+    {
+        static Memory memory;
+        CPU cpu;
+        LoadTraceCounter(cpu, memory);
+        auto path = (std::filesystem::temp_directory_path() / "Emu6502_TraceRead.trace").string();
+
+        {
+            TraceRecorder recorder(cpu, memory, path.c_str(), true);
+            cpu.ExecuteProfiled(TraceRunCycles, memory, recorder);
+        }
+
+        TraceFile trace;
+        trace.Open(path.c_str());
+        auto block = std::make_unique<TraceBlock>();
+        uint64 records = 0u;
+
+        for (auto _ : state)
+        {
+            trace.ForEachChunk(*block, [&records](TraceBlock const & chunk) { records += chunk.Count; });
+            benchmark::DoNotOptimize(records);
+        }
+
+        state.SetItemsProcessed(static_cast<int64_t>(records));
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * trace.Image.Size));
+
+        trace = { };
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    // Comparing two copies of the same run to the end, raw and packed, counting bytes of both
+    // files. The files are in the page cache so this is the compare and decode cost
+    void BM_TraceDiff_Compare(benchmark::State & state)
+    {
+        static Memory memory;
+        auto packed = state.range(0) != 0;
+        std::string paths[2];
+
+        for (auto i = 0; i < 2; ++i)
+        {
+            CPU cpu;
+            LoadTraceCounter(cpu, memory);
+            paths[i] = (std::filesystem::temp_directory_path() / fmt::format("Emu6502_TraceDiff{}.trace", i)).string();
+
+            TraceRecorder recorder(cpu, memory, paths[i].c_str(), packed);
+            cpu.ExecuteProfiled(4 * TraceRunCycles, memory, recorder);
+        }
+
+        TraceFile left, right;
+        left.Open(paths[0].c_str());
+        right.Open(paths[1].c_str());
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(TraceDiff::Compare(left, right));
+
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * TraceDiff::Compare(left, right).Index));
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * (left.Image.Size + right.Image.Size)));
+
+        left = { };
+        right = { };
+        std::error_code error;
+        for (auto const & path : paths)
+            std::filesystem::remove(path, error);
+    }
+
+    BENCHMARK(BM_Trace_Run)->ArgName("mode")->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_Trace_Setup)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_Trace_Read)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_TraceDiff_Compare)->ArgName("packed")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+}
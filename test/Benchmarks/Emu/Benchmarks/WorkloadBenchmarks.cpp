@@ -0,0 +1,197 @@
+#include <benchmark/benchmark.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+
+
+namespace Emu::Benchmarks
+{
+
+    // Defined in DispatchBenchmarks.cpp
+    void SetEmulationCounters(benchmark::State & state, double instructions, double cycles);
+
+    // Defined in CPUBenchmarks.cpp
+    void MeasureLoop(CPU & cpu, Memory & memory, uint32 & instructions, uint32 & cycles);
+
+    // Whole passes of about this many cycles per Execute
+    static constexpr uint32 RunCycles = 20000u;
+
+    // Writes 6502 code a byte at a time
+    struct Assembler
+    {
+        Memory & Target;
+        Word PC;
+
+        void Emit(Byte opCode)
+        {
+            Target.WriteByte(PC++, opCode);
+        }
+
+        void Emit(Byte opCode, Byte operand)
+        {
+            Emit(opCode);
+            Emit(operand);
+        }
+
+        void EmitWord(Byte opCode, Word operand)
+        {
+            Emit(opCode);
+            Target.WriteWord(PC, operand);
+            PC += 2;
+        }
+    };
+
+    template <typename TLoad, typename TCheck>
+    void RunWorkload(benchmark::State & state, TLoad && load, TCheck && check)
+    {
+        static Memory memory;
+        CPU cpu;
+        cpu.Reset(memory, 0x0200);
+        load(memory);
+
+        uint32 loopInstructions, loopCycles;
+        MeasureLoop(cpu, memory, loopInstructions, loopCycles);
+
+        const uint32 passes = std::max(1u, RunCycles / loopCycles);
+        const uint32 cycles = loopCycles * passes;
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(cpu.Execute(cycles, memory));
+        }
+
+        // The budget is whole passes so each run ends back at the top with the work done
+        if (cpu.DebugFlags.UnhandledInstruction || cpu.PC != 0x0200 || !check(memory))
+            state.SkipWithError("Workload did not produce the expected result");
+
+        SetEmulationCounters(state,
+            static_cast<double>(state.iterations()) * loopInstructions * passes,
+            static_cast<double>(state.iterations()) * cycles);
+    }
+
+
+    // Sorts eight keys in the zero page with the 19 comparator network for eight inputs. The
+    // implemented instructions have no compare or branch, so each compare-exchange looks the
+    // smaller and larger key up in tables instead. Keys are below 64, the tables are indexed by
+    // a pointer whose high byte holds one key and Y the other:
+    //
+    //      LDA $40+i       a
+    //      ORA #$40
+    //      STA $21         ($20) -> Min[a] at $4000 + a * 256
+    //      EOR #$C0
+    //      STA $23         ($22) -> Max[a] at $8000 + a * 256
+    //      LDY $40+j       b
+    //      LDA ($20),Y
+    //      STA $40+i       min(a, b)
+    //      LDA ($22),Y
+    //      STA $40+j       max(a, b)
+    //
+    // Each pass copies the unsorted keys in from $0300 first
+    static constexpr Byte SortKeys = 0x40;
+    static constexpr Word SortInput = 0x0300;
+    static constexpr Byte SortCount = 8;
+    static constexpr Byte SortNetwork[][2] = {
+        { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+        { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+        { 1, 2 }, { 5, 6 },
+        { 0, 4 }, { 3, 7 },
+        { 1, 5 }, { 2, 6 },
+        { 1, 4 }, { 3, 6 },
+        { 2, 4 }, { 3, 5 },
+        { 3, 4 } };
+
+    void LoadSort(Memory & memory)
+    {
+        for (uint32 a = 0; a < 64; ++a)
+        {
+            for (uint32 b = 0; b < 64; ++b)
+            {
+                memory.WriteByte(0x4000 + a * 256 + b, static_cast<Byte>(std::min(a, b)));
+                memory.WriteByte(0x8000 + a * 256 + b, static_cast<Byte>(std::max(a, b)));
+            }
+        }
+
+        memory.WriteWord(0x0020, 0x0000);
+        memory.WriteWord(0x0022, 0x0000);
+
+        constexpr Byte keys[SortCount] = { 42, 7, 63, 0, 19, 7, 55, 31 };
+        for (Byte i = 0; i < SortCount; ++i)
+            memory.WriteByte(SortInput + i, keys[i]);
+
+        Assembler code { memory, 0x0200 };
+
+        for (Byte i = 0; i < SortCount; ++i)
+        {
+            code.EmitWord(CPU::INS_LDA_ABS, SortInput + i);
+            code.Emit(CPU::INS_STA_ZP, SortKeys + i);
+        }
+
+        for (auto const & pair : SortNetwork)
+        {
+            code.Emit(CPU::INS_LDA_ZP, SortKeys + pair[0]);
+            code.Emit(CPU::INS_ORA_IM, 0x40);
+            code.Emit(CPU::INS_STA_ZP, 0x21);
+            code.Emit(CPU::INS_EOR_IM, 0xC0);
+            code.Emit(CPU::INS_STA_ZP, 0x23);
+            code.Emit(CPU::INS_LDY_ZP, SortKeys + pair[1]);
+            code.Emit(CPU::INS_LDA_INDY, 0x20);
+            code.Emit(CPU::INS_STA_ZP, SortKeys + pair[0]);
+            code.Emit(CPU::INS_LDA_INDY, 0x22);
+            code.Emit(CPU::INS_STA_ZP, SortKeys + pair[1]);
+        }
+
+        code.EmitWord(CPU::INS_JMP_ABS, 0x0200);
+    }
+
+    bool CheckSort(Memory & memory)
+    {
+        for (Byte i = 1; i < SortCount; ++i)
+        {
+            if (memory.ReadByte(SortKeys + i - 1) > memory.ReadByte(SortKeys + i))
+                return false;
+        }
+        return true;
+    }
+
+    void BM_Workload_Sort(benchmark::State & state)
+    {
+        RunWorkload(state, LoadSort, CheckSort);
+    }
+
+
+    // Copies a page from $1000 to $2000 the way speed code does, fully unrolled LDA/STA pairs
+    void LoadMemcpy(Memory & memory)
+    {
+        for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+            memory.WriteByte(0x1000 + i, static_cast<Byte>(i * 7 + 3));
+
+        Assembler code { memory, 0x0200 };
+
+        for (Word i = 0; i < Memory::PAGE_SIZE; ++i)
+        {
+            code.EmitWord(CPU::INS_LDA_ABS, 0x1000 + i);
+            code.EmitWord(CPU::INS_STA_ABS, 0x2000 + i);
+        }
+
+        code.EmitWord(CPU::INS_JMP_ABS, 0x0200);
+    }
+
+    bool CheckMemcpy(Memory & memory)
+    {
+        for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+        {
+            if (memory.ReadByte(0x2000 + i) != memory.ReadByte(0x1000 + i))
+                return false;
+        }
+        return true;
+    }
+
+    void BM_Workload_Memcpy(benchmark::State & state)
+    {
+        RunWorkload(state, LoadMemcpy, CheckMemcpy);
+    }
+
+    BENCHMARK(BM_Workload_Sort);
+    BENCHMARK(BM_Workload_Memcpy);
+
+}
\ No newline at end of file
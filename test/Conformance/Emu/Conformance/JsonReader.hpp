@@ -0,0 +1,210 @@
+#pragma once
+
+#include <streambuf>
+#include <string>
+
+#include <Emu/includes.hpp>
+
+
+namespace Emu::Conformance
+{
+
+    // Pull parser reading JSON a buffer at a time so a file of any size is never held in memory.
+    // Values are read in the order they appear, anything not wanted is skipped. The first error
+    // sets Failed and every read after it returns false or zero
+    struct JsonReader
+    {
+        static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+        std::streambuf & Source;
+        std::unique_ptr<char[]> Buffer;
+        size_t Position = 0;
+        size_t Size = 0;
+        bool Failed = false;
+
+        explicit JsonReader(std::streambuf & source)
+            : Source(source), Buffer(std::make_unique<char[]>(BUFFER_SIZE))
+        { }
+
+        bool BeginArray()
+        {
+            return Expect('[');
+        }
+
+        // True while there is another element to read, consumes the closing bracket at the end
+        bool NextElement()
+        {
+            return Next(']');
+        }
+
+        bool BeginObject()
+        {
+            return Expect('{');
+        }
+
+        // True with the member's name while there is another member, consumes the closing brace
+        // at the end
+        bool NextMember(std::string & name)
+        {
+            if (!Next('}') || !ReadString(name))
+                return false;
+
+            return Expect(':');
+        }
+
+        bool ReadString(std::string & value)
+        {
+            value.clear();
+            if (!Expect('"'))
+                return false;
+
+            while (true)
+            {
+                auto c = Get();
+                if (c == '"')
+                    return true;
+
+                if (c < 0)
+                    return Fail();
+
+                if (c == '\\')
+                {
+                    // Escapes are kept as their character, names in the vectors never use \u
+                    c = Get();
+                    if (c < 0)
+                        return Fail();
+                }
+
+                value.push_back(static_cast<char>(c));
+            }
+        }
+
+        int64 ReadInteger()
+        {
+            SkipWhitespace();
+
+            bool negative = Peek() == '-';
+            if (negative)
+                Get();
+
+            if (Peek() < '0' || Peek() > '9')
+            {
+                Fail();
+                return 0;
+            }
+
+            int64 value = 0;
+            while (Peek() >= '0' && Peek() <= '9')
+                value = value * 10 + (Get() - '0');
+
+            return negative ? -value : value;
+        }
+
+        // Reads past one value of any type
+        bool Skip()
+        {
+            SkipWhitespace();
+
+            std::string text;
+            switch (Peek())
+            {
+            case '[':
+                BeginArray();
+                while (NextElement())
+                    Skip();
+                return !Failed;
+
+            case '{':
+                BeginObject();
+                while (NextMember(text))
+                    Skip();
+                return !Failed;
+
+            case '"':
+                return ReadString(text);
+
+            default:
+                // Numbers and literals run until the next delimiter
+                while (Peek() >= 0 && Peek() != ',' && Peek() != ']' && Peek() != '}' && !IsWhitespace(Peek()))
+                    Get();
+                return !Failed;
+            }
+        }
+
+        bool Next(char close)
+        {
+            if (Failed)
+                return false;
+
+            SkipWhitespace();
+            if (Peek() == ',')
+            {
+                Get();
+                SkipWhitespace();
+            }
+
+            if (Peek() == close)
+            {
+                Get();
+                return false;
+            }
+
+            return Peek() >= 0 || Fail();
+        }
+
+        bool Expect(char c)
+        {
+            SkipWhitespace();
+            if (Get() != c)
+                return Fail();
+
+            return true;
+        }
+
+        bool Fail()
+        {
+            Failed = true;
+            Position = Size;
+            return false;
+        }
+
+        static bool IsWhitespace(int c)
+        {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+        }
+
+        void SkipWhitespace()
+        {
+            while (IsWhitespace(Peek()))
+                Get();
+        }
+
+        // Next character without consuming it, -1 at the end of the input or after an error
+        int Peek()
+        {
+            if (Position == Size && !Refill())
+                return -1;
+
+            return static_cast<unsigned char>(Buffer[Position]);
+        }
+
+        int Get()
+        {
+            auto c = Peek();
+            if (c >= 0)
+                ++Position;
+            return c;
+        }
+
+        bool Refill()
+        {
+            if (Failed)
+                return false;
+
+            Position = 0;
+            Size = static_cast<size_t>(Source.sgetn(Buffer.get(), BUFFER_SIZE));
+            return Size > 0;
+        }
+    };
+
+}
\ No newline at end of file
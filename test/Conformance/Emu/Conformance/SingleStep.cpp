@@ -0,0 +1,170 @@
+#include <Emu/Conformance/SingleStep.hpp>
+
+#include <chrono>
+#include <fstream>
+
+#include <fmt/format.h>
+
+
+namespace Emu::Conformance
+{
+
+    static bool ReadState(JsonReader & reader, MachineState & state)
+    {
+        state.Ram.clear();
+
+        std::string name;
+        if (!reader.BeginObject())
+            return false;
+
+        while (reader.NextMember(name))
+        {
+            if (name == "pc")       state.PC = static_cast<Word>(reader.ReadInteger());
+            else if (name == "s")   state.SP = static_cast<Byte>(reader.ReadInteger());
+            else if (name == "a")   state.A = static_cast<Byte>(reader.ReadInteger());
+            else if (name == "x")   state.X = static_cast<Byte>(reader.ReadInteger());
+            else if (name == "y")   state.Y = static_cast<Byte>(reader.ReadInteger());
+            else if (name == "p")   state.P = static_cast<Byte>(reader.ReadInteger());
+            else if (name == "ram")
+            {
+                // [[address, value], ...]
+                reader.BeginArray();
+                while (reader.NextElement())
+                {
+                    reader.BeginArray();
+                    reader.NextElement();
+                    auto address = static_cast<Word>(reader.ReadInteger());
+                    reader.NextElement();
+                    auto value = static_cast<Byte>(reader.ReadInteger());
+                    while (reader.NextElement())
+                        reader.Skip();
+
+                    state.Ram.push_back({ address, value });
+                }
+            }
+            else
+                reader.Skip();
+        }
+
+        return !reader.Failed;
+    }
+
+    bool ReadCase(JsonReader & reader, TestCase & testCase)
+    {
+        if (!reader.NextElement())
+            return false;
+
+        testCase.Cycles = 0;
+
+        std::string name;
+        if (!reader.BeginObject())
+            return false;
+
+        while (reader.NextMember(name))
+        {
+            if (name == "name")
+                reader.ReadString(testCase.Name);
+            else if (name == "initial")
+                ReadState(reader, testCase.Initial);
+            else if (name == "final")
+                ReadState(reader, testCase.Final);
+            else if (name == "cycles")
+            {
+                reader.BeginArray();
+                while (reader.NextElement())
+                {
+                    reader.Skip();
+                    ++testCase.Cycles;
+                }
+            }
+            else
+                reader.Skip();
+        }
+
+        return !reader.Failed;
+    }
+
+    std::string RunCase(TestCase const & testCase, CPU & cpu, Memory & memory)
+    {
+        auto const & initial = testCase.Initial;
+        auto const & expected = testCase.Final;
+
+        memory.Initialize();
+        for (auto [address, value] : initial.Ram)
+            memory.WriteByte(address, value);
+
+        cpu.ResetRegisters(initial.PC);
+        cpu.SP = initial.SP;
+        cpu.A = initial.A;
+        cpu.X = initial.X;
+        cpu.Y = initial.Y;
+        cpu.Status = initial.P;
+
+        // A budget of one cycle runs exactly one instruction, which reports running over
+        auto cycles = cpu.Execute(1, memory);
+
+        std::string failure;
+        auto check = [&failure](char const * what, uint32 actual, uint32 wanted)
+        {
+            if (actual != wanted)
+                failure += fmt::format(" {} {:x} expected {:x}", what, actual, wanted);
+        };
+
+        check("cycles", cycles, testCase.Cycles);
+        check("pc", cpu.PC, expected.PC);
+        check("s", cpu.SP, expected.SP);
+        check("a", cpu.A, expected.A);
+        check("x", cpu.X, expected.X);
+        check("y", cpu.Y, expected.Y);
+        check("p", cpu.ObservedStatus(), expected.P);
+        check("unhandled", cpu.DebugFlags.UnhandledInstruction, 0);
+
+        for (auto [address, value] : expected.Ram)
+        {
+            auto actual = memory.ReadByte(address);
+            if (actual != value)
+                failure += fmt::format(" ram[{:04x}] {:x} expected {:x}", address, actual, value);
+        }
+
+        return failure;
+    }
+
+    FileResult RunFile(char const * path)
+    {
+        FileResult result;
+
+        std::filebuf file;
+        if (file.open(path, std::ios::in | std::ios::binary) == nullptr)
+            return result;
+
+        result.Opened = true;
+
+        auto start = std::chrono::steady_clock::now();
+
+        JsonReader reader(file);
+        auto memory = std::make_unique<Memory>();
+        CPU cpu;
+        TestCase testCase;
+
+        if (reader.BeginArray())
+        {
+            while (ReadCase(reader, testCase))
+            {
+                auto failure = RunCase(testCase, cpu, *memory);
+                if (failure.empty())
+                {
+                    ++result.Passed;
+                    continue;
+                }
+
+                if (result.Failed++ == 0)
+                    result.FirstFailure = testCase.Name + ":" + failure;
+            }
+        }
+
+        result.ParseError = reader.Failed;
+        result.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+}
\ No newline at end of file
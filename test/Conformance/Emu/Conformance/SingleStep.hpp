@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+
+#include <Emu/Conformance/JsonReader.hpp>
+
+
+namespace Emu::Conformance
+{
+
+    // Registers and the RAM a case sets up or expects, in the layout of the SingleStepTests corpus
+    struct MachineState
+    {
+        Word PC = 0;
+        Byte SP = 0;
+        Byte A = 0;
+        Byte X = 0;
+        Byte Y = 0;
+        Byte P = 0;
+        std::vector<std::pair<Word, Byte>> Ram;
+    };
+
+    // One instruction from an initial state. The corpus lists the bus activity of every cycle,
+    // the interpreter does not model the bus so only the number of cycles is kept
+    struct TestCase
+    {
+        std::string Name;
+        MachineState Initial;
+        MachineState Final;
+        uint32 Cycles = 0;
+    };
+
+    struct FileResult
+    {
+        uint32 Passed = 0;
+        uint32 Failed = 0;
+        double Milliseconds = 0.0;
+        bool Opened = false;
+        bool ParseError = false;
+        std::string FirstFailure;       // Case name and what differed
+    };
+
+    // Next case from an array of cases, false at the end of the array or on a parse error
+    bool ReadCase(JsonReader & reader, TestCase & testCase);
+
+    // Runs one instruction through CPU::Execute, memory is reset first. Empty when the final state
+    // matches, otherwise what differed
+    std::string RunCase(TestCase const & testCase, CPU & cpu, Memory & memory);
+
+    // Streams every case in a file through RunCase
+    FileResult RunFile(char const * path);
+
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+
+#include <fmt/format.h>
+
+#include <Emu/ThreadPool.hpp>
+
+#include <Emu/Conformance/SingleStep.hpp>
+
+
+namespace Emu::Conformance
+{
+
+    struct Run
+    {
+        std::string Directory;
+        std::vector<Byte> OpCodes;
+        std::vector<FileResult> Results;
+    };
+
+    static void RunOpCode(void * context, size_t index)
+    {
+        auto & run = *static_cast<Run *>(context);
+        auto path = fmt::format("{}/{:02x}.json", run.Directory, run.OpCodes[index]);
+        run.Results[index] = RunFile(path.c_str());
+    }
+
+}
+
+
+// Conformance <directory> [opcode ...]
+//
+// Runs <directory>/<opcode>.json vectors in the SingleStepTests format, one file per opcode spread
+// across every core. Opcodes are hex, the default is every implemented opcode. Opcodes without a
+// file are skipped, the exit code is non zero when any case fails
+int main(int argc, char ** argv)
+{
+    using namespace Emu;
+    using namespace Emu::Conformance;
+
+    if (argc < 2)
+    {
+        fmt::print("Usage: {} <directory> [opcode ...]\n", argv[0]);
+        return 2;
+    }
+
+    Run run;
+    run.Directory = argv[1];
+
+    for (int i = 2; i < argc; ++i)
+        run.OpCodes.push_back(static_cast<Byte>(strtoul(argv[i], nullptr, 16)));
+
+    if (run.OpCodes.empty())
+    {
+        for (auto const & description : CPU::OpCodeDescriptions)
+            run.OpCodes.push_back(description.OpCode);
+    }
+
+    std::sort(run.OpCodes.begin(), run.OpCodes.end());
+    run.Results.resize(run.OpCodes.size());
+
+    auto start = std::chrono::steady_clock::now();
+
+    ThreadPool pool;
+    pool.Run(run.OpCodes.size(), &RunOpCode, &run);
+
+    auto wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    uint64 passed = 0;
+    uint64 failed = 0;
+    uint32 skipped = 0;
+
+    fmt::print("{:>4} {:<6} {:>10} {:>10} {:>10}\n", "op", "", "passed", "failed", "ms");
+
+    for (size_t i = 0; i < run.OpCodes.size(); ++i)
+    {
+        auto opCode = run.OpCodes[i];
+        auto const & result = run.Results[i];
+
+        if (!result.Opened)
+        {
+            ++skipped;
+            continue;
+        }
+
+        auto const & info = CPU::OpCodeTable[opCode];
+        fmt::print("{:>4x} {:<6} {:>10} {:>10} {:>10.1f}\n",
+            opCode, info.Implemented ? Mnemonic(info.Op) : "???", result.Passed, result.Failed, result.Milliseconds);
+
+        if (result.ParseError)
+            fmt::print("     parse error after {} cases\n", result.Passed + result.Failed);
+
+        if (result.Failed > 0)
+            fmt::print("     first failure {}\n", result.FirstFailure);
+
+        passed += result.Passed;
+        failed += result.Failed + (result.ParseError ? 1 : 0);
+    }
+
+    fmt::print("{:>11} {:>10} {:>10} {:>10.1f} on {} workers, {} opcodes without vectors\n",
+        "total", passed, failed, wall, pool.WorkerCount(), skipped);
+
+    return failed == 0 ? 0 : 1;
+}
\ No newline at end of file
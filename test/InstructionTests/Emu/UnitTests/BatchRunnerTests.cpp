@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include <Emu/BatchRunner.hpp>
+#include <Emu/CPU.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class BatchRunnerFixture : public testing::Test
+    {
+    public:
+        static constexpr size_t MACHINE_COUNT = 64;
+
+        std::vector<CPU> cpus;
+        std::vector<std::unique_ptr<Memory>> memories;
+        std::vector<BatchMachine> machines;
+        std::vector<BatchResult> results;
+
+        void SetUp() override
+        {
+            cpus.resize(MACHINE_COUNT);
+            results.resize(MACHINE_COUNT);
+
+            for (size_t i = 0; i < MACHINE_COUNT; ++i)
+            {
+                memories.push_back(std::make_unique<Memory>());
+                cpus[i].Reset(*memories[i], 0x0200);
+                machines.push_back({ &cpus[i], memories[i].get() });
+            }
+        }
+
+        void TearDown() override
+        { }
+
+        // Random loads, stores and stack operations looping back to 0x0200, different per seed
+        void LoadRandomProgram(size_t index, uint32 seed)
+        {
+            static constexpr Byte OpCodes[] = {
+                CPU::INS_LDA_ZP, CPU::INS_LDX_ZP, CPU::INS_LDY_ZP, CPU::INS_STA_ZP, CPU::INS_STX_ZP,
+                CPU::INS_EOR_IM, CPU::INS_ORA_ZP, CPU::INS_AND_IM, CPU::INS_LDA_INDY, CPU::INS_STA_ZPX,
+            };
+
+            std::mt19937 random(seed);
+            auto & memory = *memories[index];
+
+            for (uint32 address = 0x0000; address < 0x0100; ++address)
+                memory.WriteByte(address, static_cast<Byte>(random()));
+
+            Word pc = 0x0200;
+            for (int i = 0; i < 20; ++i)
+            {
+                memory.WriteByte(pc++, OpCodes[random() % std::size(OpCodes)]);
+                memory.WriteByte(pc++, static_cast<Byte>(random()));
+            }
+
+            memory.WriteByte(pc++, CPU::INS_PHA);
+            memory.WriteByte(pc++, CPU::INS_JMP_ABS);
+            memory.WriteWord(pc, 0x0200);
+        }
+    };
+
+
+    TEST_F(BatchRunnerFixture, Run_SameResultsForAnyThreadCount)
+    {
+        // Arrange
+        std::vector<CPU> expectedCpus;
+        std::vector<std::unique_ptr<Memory>> expectedMemories;
+        std::vector<BatchResult> expectedResults;
+
+        for (uint32 threads : { 1u, 2u, 4u, 7u })
+        {
+            SCOPED_TRACE(testing::Message() << "Threads " << threads);
+
+            for (size_t i = 0; i < MACHINE_COUNT; ++i)
+            {
+                cpus[i].Reset(*memories[i], 0x0200);
+                LoadRandomProgram(i, static_cast<uint32>(i + 1));
+            }
+
+            // Act
+            ThreadPool pool(threads);
+            BatchRunner runner(pool);
+            runner.SliceCycles = 37u;
+            runner.Run(machines.data(), results.data(), MACHINE_COUNT, 5000u);
+
+            // Assert
+            if (expectedCpus.empty())
+            {
+                expectedCpus = cpus;
+                expectedResults = results;
+                for (auto & memory : memories)
+                    expectedMemories.push_back(std::make_unique<Memory>(*memory));
+                continue;
+            }
+
+            for (size_t i = 0; i < MACHINE_COUNT; ++i)
+            {
+                ASSERT_EQ(results[i].CyclesUsed, expectedResults[i].CyclesUsed) << i;
+                ASSERT_EQ(cpus[i].PC, expectedCpus[i].PC) << i;
+                ASSERT_EQ(cpus[i].SP, expectedCpus[i].SP) << i;
+                ASSERT_EQ(cpus[i].A, expectedCpus[i].A) << i;
+                ASSERT_EQ(memcmp(memories[i]->Data, expectedMemories[i]->Data, Memory::MAX_MEMORY), 0) << i;
+            }
+        }
+    }
+
+
+    TEST_F(BatchRunnerFixture, Run_UsesCycleBudget)
+    {
+        // Arrange
+        for (size_t i = 0; i < MACHINE_COUNT; ++i)
+            LoadRandomProgram(i, static_cast<uint32>(i + 1));
+
+        ThreadPool pool(3);
+        BatchRunner runner(pool);
+
+        // Act
+        runner.Run(machines.data(), results.data(), MACHINE_COUNT, 10000u);
+
+        // Assert
+        for (auto const & result : results)
+        {
+            EXPECT_GE(result.CyclesUsed, 10000u);
+            EXPECT_LT(result.CyclesUsed, 10000u + 6u);
+            EXPECT_FALSE(result.Stopped);
+            EXPECT_FALSE(result.Halted);
+        }
+    }
+
+
+    TEST_F(BatchRunnerFixture, Run_StopCondition_EndsMachineEarly)
+    {
+        // Arrange
+        for (size_t i = 0; i < MACHINE_COUNT; ++i)
+        {
+            memories[i]->WriteByte(0x0200, CPU::INS_PHA);
+            memories[i]->WriteByte(0x0201, CPU::INS_JMP_ABS);
+            memories[i]->WriteWord(0x0202, 0x0200);
+            cpus[i].SP = static_cast<Byte>(0x80 + i);
+        }
+
+        ThreadPool pool(4);
+        BatchRunner runner(pool);
+        runner.SliceCycles = 6u;
+
+        // Act
+        runner.Run(machines.data(), results.data(), MACHINE_COUNT, 1000000u,
+            [](CPU const & cpu, Memory const &) { return cpu.SP == 0x7F; });
+
+        // Assert
+        for (size_t i = 0; i < MACHINE_COUNT; ++i)
+        {
+            EXPECT_TRUE(results[i].Stopped) << i;
+            EXPECT_EQ(results[i].CyclesUsed, (i + 1) * 6u) << i;
+        }
+    }
+
+
+    TEST_F(BatchRunnerFixture, Run_UnhandledInstruction_Halts)
+    {
+        // Arrange
+        memories[5]->WriteByte(0x0200, CPU::INS_LDA_IM);
+        memories[5]->WriteByte(0x0201, 0x11);
+        memories[5]->WriteByte(0x0202, 0x00);
+
+        ThreadPool pool(2);
+        BatchRunner runner(pool);
+
+        // Act
+        runner.Run(machines.data() + 5, results.data() + 5, 1, 1000u);
+
+        // Assert
+        EXPECT_TRUE(results[5].Halted);
+        EXPECT_EQ(results[5].CyclesUsed, 3u);
+    }
+
+
+    TEST(ThreadPoolTests, Run_CallsEveryIndexOnce)
+    {
+        for (uint32 threads : { 1u, 3u, 8u })
+        {
+            ThreadPool pool(threads);
+
+            for (size_t count : { size_t(0), size_t(1), size_t(5), size_t(10000) })
+            {
+                // Arrange
+                std::vector<std::atomic<uint32>> calls(count);
+
+                // Act
+                pool.Run(count, [](void * context, size_t index)
+                {
+                    ++(*static_cast<std::vector<std::atomic<uint32>> *>(context))[index];
+                }, &calls);
+
+                // Assert
+                for (size_t i = 0; i < count; ++i)
+                    ASSERT_EQ(calls[i].load(), 1u) << threads << " threads, index " << i << " of " << count;
+            }
+        }
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <Emu/CPU.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class BlockCacheFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+        BlockCache cache;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory);
+        }
+
+        void TearDown() override
+        { }
+
+        void AssertSameState(CPU const & expected, CPU const & actual)
+        {
+            EXPECT_EQ(actual.PC, expected.PC);
+            EXPECT_EQ(actual.SP, expected.SP);
+            EXPECT_EQ(actual.A, expected.A);
+            EXPECT_EQ(actual.X, expected.X);
+            EXPECT_EQ(actual.Y, expected.Y);
+            EXPECT_EQ(actual.Status, expected.Status);
+            EXPECT_EQ(actual.DebugStatus, expected.DebugStatus);
+        }
+
+        // Runs a single opcode through the interpreter and the block cache and compares the results
+        void TestMatchesInterpreter(Byte opCode, Byte offset)
+        {
+            // Arrange
+            memory.WriteByte(0x0200, opCode);
+            memory.WriteByte(0x0201, 0x80);
+            memory.WriteByte(0x0202, 0x44);
+
+            for (Word address = 0x0000; address < 0x0100; ++address)
+                memory.WriteByte(address, static_cast<Byte>(address * 7 + 3));
+
+            memory.WriteWord(0x01FE, 0x0300);
+            memory.WriteByte(0x44F0, 0x5A);
+
+            cpu.PC = 0x0200;
+            cpu.SP = 0xFD;
+            cpu.A = 0x3C;
+            cpu.X = offset;
+            cpu.Y = offset;
+
+            CPU interpreted = cpu;
+            auto interpretedMemory = std::make_unique<Memory>(memory);
+
+            // Act
+            auto expectedCycles = interpreted.Execute(1u, *interpretedMemory);
+            auto cyclesUsed = cpu.Execute(1u, memory, cache);
+
+            // Assert
+            EXPECT_EQ(cyclesUsed, expectedCycles);
+            AssertSameState(interpreted, cpu);
+            EXPECT_EQ(memcmp(memory.Data, interpretedMemory->Data, Memory::MAX_MEMORY), 0);
+        }
+
+    };
+
+
+    TEST_F(BlockCacheFixture, EveryOpCode_MatchesInterpreter)
+    {
+        for (auto const & description : CPU::OpCodeDescriptions)
+        {
+            SCOPED_TRACE(testing::Message() << "OpCode 0x" << std::hex << (int)description.OpCode);
+            TestMatchesInterpreter(description.OpCode, 0x01);
+        }
+    }
+
+
+    TEST_F(BlockCacheFixture, EveryOpCode_WithCrossPageBoundary_MatchesInterpreter)
+    {
+        for (auto const & description : CPU::OpCodeDescriptions)
+        {
+            SCOPED_TRACE(testing::Message() << "OpCode 0x" << std::hex << (int)description.OpCode);
+            TestMatchesInterpreter(description.OpCode, 0xFF);
+        }
+    }
+
+
+    TEST_F(BlockCacheFixture, BadInstruction_SetsUnhandledInstructionBit)
+    {
+        // Arrange
+        constexpr uint32 expectedCycles = 1u;
+
+        memory.WriteByte(0xFFFC, 0x00);
+
+        // Act
+        auto cyclesUsed = cpu.Execute(expectedCycles + 10u, memory, cache);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, expectedCycles);
+        EXPECT_TRUE(cpu.DebugFlags.UnhandledInstruction);
+    }
+
+
+    TEST_F(BlockCacheFixture, HostWriteToCachedCode_InvalidatesBlock)
+    {
+        // Arrange
+        cpu.Reset(memory, 0x0200);
+
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x11);
+        memory.WriteByte(0x0202, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0203, 0x0200);
+
+        cpu.Execute(5u, memory, cache);
+        EXPECT_EQ(cpu.A, 0x11);
+
+        // Act
+        memory.WriteByte(0x0201, 0x22);
+        cpu.Execute(5u, memory, cache);
+
+        // Assert
+        EXPECT_EQ(cpu.A, 0x22);
+        EXPECT_EQ(cpu.PC, 0x0200);
+    }
+
+
+    TEST_F(BlockCacheFixture, SelfModifyingCode_WithinBlock_ExecutesNewInstruction)
+    {
+        // Arrange
+        cpu.Reset(memory, 0x0200);
+        cpu.A = 0x33;
+
+        memory.WriteByte(0x0200, CPU::INS_STA_ABS);     // Overwrite the operand of the following load
+        memory.WriteWord(0x0201, 0x0204);
+        memory.WriteByte(0x0203, CPU::INS_LDX_IM);
+        memory.WriteByte(0x0204, 0x44);
+
+        // Act
+        auto cyclesUsed = cpu.Execute(4u + 2u, memory, cache);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 6u);
+        EXPECT_EQ(cpu.X, 0x33);
+    }
+
+
+    TEST_F(BlockCacheFixture, Reset_InvalidatesBlocks)
+    {
+        // Arrange
+        cpu.Reset(memory, 0x0200);
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x11);
+        cpu.Execute(2u, memory, cache);
+
+        // Act
+        cpu.Reset(memory, 0x0200);
+        auto cyclesUsed = cpu.Execute(2u, memory, cache);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 1u);
+        EXPECT_TRUE(cpu.DebugFlags.UnhandledInstruction);
+    }
+
+}
\ No newline at end of file
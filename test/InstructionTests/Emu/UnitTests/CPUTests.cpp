@@ -83,4 +83,142 @@ namespace Emu::UnitTests
         EXPECT_TRUE(cpu.DebugFlags.UnhandledInstruction);
     }
 
+
+    TEST_F(CPUFixture, EveryOpCode_WithoutPageCross_UsesOpCodeTableCycles)
+    {
+        for (auto const & description : CPU::OpCodeDescriptions)
+        {
+            SCOPED_TRACE(testing::Message() << "OpCode 0x" << std::hex << (int)description.OpCode);
+
+            // Arrange
+            auto const & info = CPU::OpCodeTable[description.OpCode];
+
+            cpu.Reset(memory, 0x0200);
+            memory.WriteByte(0x0200, description.OpCode);
+            memory.WriteByte(0x0201, 0x10);
+            memory.WriteByte(0x0202, 0x30);
+            memory.WriteWord(0x0010, 0x4000);
+
+            // Act
+            auto cyclesUsed = cpu.Execute(info.Cycles, memory);
+
+            // Assert
+            EXPECT_EQ(cyclesUsed, info.Cycles);
+            EXPECT_EQ(cpu.DebugStatus, 0);
+        }
+    }
+
+
+    TEST_F(CPUFixture, EveryOpCode_WithPageCross_MatchesNextInstructionCycles)
+    {
+        for (auto const & description : CPU::OpCodeDescriptions)
+        {
+            SCOPED_TRACE(testing::Message() << "OpCode 0x" << std::hex << (int)description.OpCode);
+
+            // Arrange
+            cpu.Reset(memory, 0x0200);
+            cpu.X = cpu.Y = 0xFF;
+            memory.WriteByte(0x0200, description.OpCode);
+            memory.WriteByte(0x0201, 0x10);
+            memory.WriteByte(0x0202, 0x30);
+            memory.WriteWord(0x0010, 0x4080);
+
+            auto expectedCycles = cpu.NextInstructionCycles(memory);
+
+            // Act
+            auto cyclesUsed = cpu.Execute(1, memory);
+
+            // Assert
+            EXPECT_EQ(cyclesUsed, expectedCycles);
+        }
+    }
+
+
+    class TimelineFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory, 0x0200);
+
+            // LDA #$01 / JMP $0200, 5 cycles a loop
+            memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+            memory.WriteByte(0x0201, 0x01);
+            memory.WriteByte(0x0202, CPU::INS_JMP_ABS);
+            memory.WriteWord(0x0203, 0x0200);
+        }
+
+        void TearDown() override
+        { }
+    };
+
+
+    TEST_F(TimelineFixture, Execute_Repeatedly_AccumulatesTotalCycles)
+    {
+        // Act
+        cpu.Execute(10, memory);
+        cpu.Execute(10, memory);
+        cpu.Execute(4, memory);
+
+        // Assert
+        EXPECT_EQ(cpu.TotalCycles, 25u);
+        EXPECT_TRUE(cpu.DebugFlags.CycleOverflow);
+    }
+
+
+    TEST_F(TimelineFixture, ExecuteUntil_PastTwoToThe32_ReportsCycles)
+    {
+        // Arrange
+        cpu.TotalCycles = 0xFFFFFFF0ull;
+
+        // Act
+        auto cyclesUsed = cpu.ExecuteUntil(cpu.TotalCycles + 100u, memory);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 100u);
+        EXPECT_EQ(cpu.TotalCycles, 0x100000054ull);
+        EXPECT_FALSE(cpu.DebugFlags.CycleOverflow);
+    }
+
+
+    TEST_F(TimelineFixture, ExecuteUntilPrecise_InstructionWouldRunPast_StopsBeforeIt)
+    {
+        // Act
+        auto cyclesUsed = cpu.ExecuteUntilPrecise(4u, memory);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 2u);
+        EXPECT_EQ(cpu.PC, 0x0202);
+        EXPECT_FALSE(cpu.DebugFlags.CycleOverflow);
+
+        // Act
+        cyclesUsed = cpu.ExecuteUntilPrecise(1003u, memory);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 1000u);
+        EXPECT_EQ(cpu.TotalCycles, 1002u);
+        EXPECT_FALSE(cpu.DebugFlags.CycleOverflow);
+    }
+
+
+    TEST_F(TimelineFixture, ExecuteUntilPrecise_PageCross_CountsPenalty)
+    {
+        // Arrange
+        cpu.X = 0x01;
+        memory.WriteByte(0x0200, CPU::INS_LDA_ABSX);
+        memory.WriteWord(0x0201, 0x40FF);
+
+        // Act
+        auto before = cpu.ExecuteUntilPrecise(4u, memory);
+        auto after = cpu.ExecuteUntilPrecise(5u, memory);
+
+        // Assert
+        EXPECT_EQ(before, 0u);
+        EXPECT_EQ(after, 5u);
+        EXPECT_EQ(cpu.PC, 0x0203);
+    }
+
 }
\ No newline at end of file
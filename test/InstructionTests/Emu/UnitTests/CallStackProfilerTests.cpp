@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include <Emu/CallStackProfiler.hpp>
+#include <Emu/CPU.hpp>
+#include <Emu/Scheduler.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class CallStackProfilerFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory, 0x0200);
+
+            // JSR $0300 / JMP $0200
+            memory.WriteByte(0x0200, CPU::INS_JSR);
+            memory.WriteWord(0x0201, 0x0300);
+            memory.WriteByte(0x0203, CPU::INS_JMP_ABS);
+            memory.WriteWord(0x0204, 0x0200);
+        }
+
+        void TearDown() override
+        { }
+
+        // LDA #$01 / JSR $0400 / RTS, and LDX #$02 / RTS at 0x0400, 31 cycles a loop
+        void WriteNestedCalls()
+        {
+            memory.WriteByte(0x0300, CPU::INS_LDA_IM);
+            memory.WriteByte(0x0301, 0x01);
+            memory.WriteByte(0x0302, CPU::INS_JSR);
+            memory.WriteWord(0x0303, 0x0400);
+            memory.WriteByte(0x0305, CPU::INS_RTS);
+
+            memory.WriteByte(0x0400, CPU::INS_LDX_IM);
+            memory.WriteByte(0x0401, 0x02);
+            memory.WriteByte(0x0402, CPU::INS_RTS);
+        }
+    };
+
+
+    TEST_F(CallStackProfilerFixture, NestedCalls_AttributesCyclesToEachPath)
+    {
+        // Arrange
+        WriteNestedCalls();
+        CallStackProfiler profiler(cpu);
+
+        // Act
+        auto cyclesUsed = cpu.ExecuteProfiled(31 * 3, memory, profiler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 31u * 3);
+        EXPECT_EQ(profiler.Folded(),
+            "$0200 27\n"
+            "$0200;$0300 42\n"
+            "$0200;$0300;$0400 24\n");
+
+        EXPECT_EQ(profiler.Current, 0u);
+        EXPECT_EQ(profiler.Depth, 0u);
+        EXPECT_EQ(profiler.Tree.Nodes[1].Calls, 3u);
+        EXPECT_EQ(profiler.InclusiveCycles(0x0300), 66u);
+        EXPECT_EQ(profiler.InclusiveCycles(0x0400), 24u);
+    }
+
+    TEST_F(CallStackProfilerFixture, Symbols_NameRoutines)
+    {
+        // Arrange
+        WriteNestedCalls();
+
+        SymbolTable symbols;
+        symbols.Add(0x0200, "main");
+        symbols.Add(0x0300, "update");
+
+        CallStackProfiler profiler(cpu, &symbols);
+
+        // Act
+        cpu.ExecuteProfiled(31, memory, profiler);
+
+        // Assert
+        EXPECT_EQ(profiler.Folded(),
+            "main 9\n"
+            "main;update 14\n"
+            "main;update;$0400 8\n");
+    }
+
+    TEST_F(CallStackProfilerFixture, ReturnAddressDropped_UnwindsToMatchingFrame)
+    {
+        // Arrange, 0x0400 drops its own return address so its RTS returns from 0x0300 as well
+        memory.WriteByte(0x0300, CPU::INS_JSR);
+        memory.WriteWord(0x0301, 0x0400);
+
+        memory.WriteByte(0x0400, CPU::INS_PLA);
+        memory.WriteByte(0x0401, CPU::INS_PLA);
+        memory.WriteByte(0x0402, CPU::INS_RTS);
+
+        CallStackProfiler profiler(cpu);
+
+        // Act
+        cpu.ExecuteProfiled(29 * 2, memory, profiler);
+
+        // Assert
+        EXPECT_EQ(cpu.PC, 0x0200);
+        EXPECT_EQ(profiler.Current, 0u);
+        EXPECT_EQ(profiler.Depth, 0u);
+        EXPECT_EQ(profiler.Folded(),
+            "$0200 18\n"
+            "$0200;$0300 12\n"
+            "$0200;$0300;$0400 28\n");
+    }
+
+    TEST_F(CallStackProfilerFixture, Interrupt_ChargedToMarkedHandler)
+    {
+        // Arrange, LDA #$01 / JMP $0200 interrupted by an NMI running LDX #$22 / RTI
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x01);
+        memory.WriteByte(0x0202, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0203, 0x0200);
+
+        memory.WriteWord(CPU::NMI_VECTOR, 0x0400);
+        memory.WriteByte(0x0400, CPU::INS_LDX_IM);
+        memory.WriteByte(0x0401, 0x22);
+        memory.WriteByte(0x0402, CPU::INS_RTI);
+
+        Scheduler scheduler;
+        scheduler.RaiseNmi();
+        CallStackProfiler profiler(cpu);
+
+        // Act
+        auto cyclesUsed = cpu.ExecuteProfiled(CPU::INTERRUPT_CYCLES + 2 + 6 + 5, memory, scheduler, profiler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 20u);
+        EXPECT_EQ(cpu.X, 0x22);
+        EXPECT_EQ(profiler.Current, 0u);
+        EXPECT_EQ(profiler.Folded(),
+            "$0200 5\n"
+            "$0200;[NMI] $0400 15\n");
+    }
+
+    TEST_F(CallStackProfilerFixture, Sampler_NestedCalls_ChargesInnermostRoutine)
+    {
+        // Arrange, the interval is long enough that only the sample taken here counts
+        WriteNestedCalls();
+        Scheduler scheduler;
+        CallStackSampler sampler(cpu, memory, scheduler, nullptr, 1000000u);
+
+        // Act, JSR $0300 / LDA #$01 / JSR $0400
+        cpu.ExecuteProfiled(6 + 2 + 6, memory, scheduler, sampler);
+        sampler.Sample(10);
+
+        // Assert
+        EXPECT_EQ(cpu.PC, 0x0400);
+        EXPECT_EQ(sampler.Folded(), "$0200;$0300;$0400 10\n");
+    }
+
+    TEST_F(CallStackProfilerFixture, Sampler_LongRun_MatchesExactProfile)
+    {
+        // Arrange, per loop the exact profile is 9 cycles in $0200, 14 in $0300 and 8 in $0400
+        WriteNestedCalls();
+        Scheduler scheduler;
+        CallStackSampler sampler(cpu, memory, scheduler, nullptr, 100u);
+
+        // Act
+        cpu.ExecuteProfiled(31 * 10000, memory, scheduler, sampler);
+
+        // Assert
+        ASSERT_EQ(sampler.Tree.Nodes.size(), 3u);
+
+        uint64 total = 0u;
+        for (auto const & node : sampler.Tree.Nodes)
+            total += node.Cycles;
+
+        EXPECT_EQ(total, sampler.LastSample);
+        EXPECT_GT(total, 31u * 10000 - 200);
+        EXPECT_NEAR(static_cast<double>(sampler.Tree.Nodes[0].Cycles) / total, 9.0 / 31, 0.03);
+        EXPECT_NEAR(static_cast<double>(sampler.InclusiveCycles(0x0300)) / total, 22.0 / 31, 0.03);
+        EXPECT_NEAR(static_cast<double>(sampler.InclusiveCycles(0x0400)) / total, 8.0 / 31, 0.03);
+    }
+
+    TEST_F(CallStackProfilerFixture, Sampler_Interrupt_MarksHandlerUntilRti)
+    {
+        // Arrange, LDA #$01 / JMP $0200 interrupted by an NMI running LDX #$22 / RTI
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x01);
+        memory.WriteByte(0x0202, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0203, 0x0200);
+
+        memory.WriteWord(CPU::NMI_VECTOR, 0x0400);
+        memory.WriteByte(0x0400, CPU::INS_LDX_IM);
+        memory.WriteByte(0x0401, 0x22);
+        memory.WriteByte(0x0402, CPU::INS_RTI);
+
+        Scheduler scheduler;
+        scheduler.RaiseNmi();
+        CallStackSampler sampler(cpu, memory, scheduler, nullptr, 1000000u);
+
+        // Act
+        cpu.ExecuteProfiled(CPU::INTERRUPT_CYCLES + 2, memory, scheduler, sampler);
+        sampler.Sample(10);
+        cpu.ExecuteProfiled(6 + 2, memory, scheduler, sampler);
+        sampler.Sample(5);
+
+        // Assert
+        EXPECT_EQ(cpu.X, 0x22);
+        EXPECT_EQ(sampler.Folded(),
+            "$0200 5\n"
+            "$0200;[NMI] $0400 10\n");
+    }
+
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <Emu/Disassembler.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class DisassemblerFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory);
+        }
+
+        void TearDown() override
+        { }
+
+        void TestDisassemble(std::vector<Byte> const & bytes, char const * expected)
+        {
+            // Arrange
+            for (size_t i = 0; i < bytes.size(); ++i)
+                memory.WriteByte(0x0200 + static_cast<Word>(i), bytes[i]);
+
+            // Act
+            auto text = Disassembler::Disassemble(memory, 0x0200);
+
+            // Assert
+            EXPECT_EQ(text, expected);
+        }
+    };
+
+
+    TEST_F(DisassemblerFixture, Implied)
+    { TestDisassemble({ CPU::INS_PHA }, "PHA"); }
+
+    TEST_F(DisassemblerFixture, Immediate)
+    { TestDisassemble({ CPU::INS_LDA_IM, 0x42 }, "LDA #$42"); }
+
+    TEST_F(DisassemblerFixture, ZeroPageY)
+    { TestDisassemble({ CPU::INS_STX_ZPY, 0x10 }, "STX $10,Y"); }
+
+    TEST_F(DisassemblerFixture, AbsoluteX)
+    { TestDisassemble({ CPU::INS_LDA_ABSX, 0x80, 0x44 }, "LDA $4480,X"); }
+
+    TEST_F(DisassemblerFixture, Indirect)
+    { TestDisassemble({ CPU::INS_JMP_IND, 0x34, 0x12 }, "JMP ($1234)"); }
+
+    TEST_F(DisassemblerFixture, IndirectX)
+    { TestDisassemble({ CPU::INS_EOR_INDX, 0x20 }, "EOR ($20,X)"); }
+
+    TEST_F(DisassemblerFixture, IndirectY)
+    { TestDisassemble({ CPU::INS_ORA_INDY, 0x20 }, "ORA ($20),Y"); }
+
+    TEST_F(DisassemblerFixture, UnknownOpCode)
+    { TestDisassemble({ 0x02 }, ".byte $02"); }
+
+
+    TEST_F(DisassemblerFixture, Line_IncludesAddressAndBytes)
+    {
+        // Arrange
+        memory.WriteByte(0x0200, CPU::INS_JSR);
+        memory.WriteWord(0x0201, 0x0300);
+        memory.WriteByte(0x0203, CPU::INS_RTS);
+        Word next = 0;
+
+        // Act
+        auto first = Disassembler::Line(memory, 0x0200, &next);
+        auto second = Disassembler::Line(memory, next, &next);
+
+        // Assert
+        EXPECT_EQ(first, "0200  20 00 03  JSR $0300");
+        EXPECT_EQ(second, "0203  60        RTS");
+        EXPECT_EQ(next, 0x0204);
+    }
+
+
+    TEST_F(DisassemblerFixture, EveryOpCode_ReadsOpCodeTable)
+    {
+        for (uint32 opCode = 0; opCode < 256; ++opCode)
+        {
+            SCOPED_TRACE(testing::Message() << "OpCode 0x" << std::hex << opCode);
+
+            // Arrange
+            auto const & info = CPU::OpCodeTable[opCode];
+            memory.WriteByte(0x0200, static_cast<Byte>(opCode));
+            Word next = 0;
+
+            // Act
+            auto text = Disassembler::Line(memory, 0x0200, &next);
+
+            // Assert
+            EXPECT_EQ(next, 0x0200 + info.Length);
+            if (info.Implemented)
+            {
+                EXPECT_NE(text.find(Mnemonic(info.Op)), std::string::npos);
+            }
+        }
+    }
+
+}
\ No newline at end of file
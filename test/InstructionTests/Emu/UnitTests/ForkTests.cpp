@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Fork.hpp>
+#include <Emu/Mapper.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class ForkFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+
+        void SetUp() override
+        {
+            memory.Initialize();
+            cpu.Reset(memory, 0x0200);
+
+            // Flips 0x0010 and copies it to 0x0400
+            memory.WriteByte(0x0200, CPU::INS_LDA_ZP);
+            memory.WriteByte(0x0201, 0x10);
+            memory.WriteByte(0x0202, CPU::INS_EOR_IM);
+            memory.WriteByte(0x0203, 0xFF);
+            memory.WriteByte(0x0204, CPU::INS_STA_ZP);
+            memory.WriteByte(0x0205, 0x10);
+            memory.WriteByte(0x0206, CPU::INS_STA_ABS);
+            memory.WriteWord(0x0207, 0x0400);
+            memory.WriteByte(0x0209, CPU::INS_JMP_ABS);
+            memory.WriteWord(0x020A, 0x0200);
+        }
+
+        void TearDown() override
+        { }
+    };
+
+
+    TEST_F(ForkFixture, Fork_SharesParentPages)
+    {
+        // Arrange
+        memory.WriteByte(0x1234, 0x56);
+        ForkPoint point(cpu, memory);
+
+        // Act
+        auto child = point.Fork();
+
+        // Assert
+        EXPECT_EQ(child.Ram->ReadByte(0x1234), 0x56);
+        EXPECT_EQ(child.Ram->ReadPages[0x12], point.Ram->ReadPages[0x12]);
+        EXPECT_TRUE(child.Ram->IsShared(0x12));
+        EXPECT_EQ(child.Cpu.PC, 0x0200);
+    }
+
+
+    TEST_F(ForkFixture, ChildWrite_CopiesOnlyThatPage)
+    {
+        // Arrange
+        memory.WriteByte(0x1234, 0x56);
+        memory.WriteByte(0x12FF, 0x78);
+        ForkPoint point(cpu, memory);
+        auto child = point.Fork();
+
+        // Act
+        child.Ram->WriteByte(0x1234, 0x9A);
+
+        // Assert
+        EXPECT_FALSE(child.Ram->IsShared(0x12));
+        EXPECT_EQ(child.Ram->ReadPages[0x12], child.Ram->Data + 0x1200);
+        EXPECT_EQ(child.Ram->ReadByte(0x1234), 0x9A);
+        EXPECT_EQ(child.Ram->ReadByte(0x12FF), 0x78);
+        EXPECT_TRUE(child.Ram->IsShared(0x13));
+        EXPECT_EQ(point.Ram->ReadByte(0x1234), 0x56);
+    }
+
+
+    TEST_F(ForkFixture, Siblings_DoNotSeeEachOthersWrites)
+    {
+        // Arrange
+        ForkPoint point(cpu, memory);
+        auto first = point.Fork();
+        auto second = point.Fork();
+
+        // Act
+        first.Ram->WriteByte(0x0010, 0x01);
+        second.Ram->WriteByte(0x0010, 0x02);
+
+        // Assert
+        EXPECT_EQ(first.Ram->ReadByte(0x0010), 0x01);
+        EXPECT_EQ(second.Ram->ReadByte(0x0010), 0x02);
+        EXPECT_EQ(point.Ram->ReadByte(0x0010), 0x00);
+    }
+
+
+    TEST_F(ForkFixture, ParentChanges_AfterForkPoint_AreNotSeen)
+    {
+        // Arrange
+        ForkPoint point(cpu, memory);
+        auto child = point.Fork();
+
+        // Act
+        memory.WriteByte(0x0010, 0x42);
+
+        // Assert
+        EXPECT_EQ(child.Ram->ReadByte(0x0010), 0x00);
+    }
+
+
+    TEST_F(ForkFixture, Child_RunsLikeFullCopy)
+    {
+        // Arrange
+        cpu.Execute(100u, memory);
+        ForkPoint point(cpu, memory);
+        auto child = point.Fork();
+
+        CPU copy = cpu;
+        auto copyMemory = std::make_unique<Memory>(memory);
+
+        // Act
+        auto expectedCycles = copy.Execute(500u, *copyMemory);
+        auto cyclesUsed = child.Cpu.Execute(500u, *child.Ram);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, expectedCycles);
+        EXPECT_EQ(child.Cpu.PC, copy.PC);
+        EXPECT_EQ(child.Cpu.A, copy.A);
+        EXPECT_EQ(child.Ram->ReadByte(0x0010), copyMemory->ReadByte(0x0010));
+        EXPECT_EQ(child.Ram->ReadByte(0x0400), copyMemory->ReadByte(0x0400));
+        EXPECT_TRUE(child.Ram->IsShared(0x02));
+    }
+
+
+    TEST_F(ForkFixture, Child_WritingCachedCode_InvalidatesBlocks)
+    {
+        // Arrange
+        ForkPoint point(cpu, memory);
+        auto child = point.Fork();
+        BlockCache cache;
+        child.Cpu.Execute(3u, *child.Ram, cache);
+
+        // Act
+        child.Ram->WriteByte(0x0201, 0x11);
+        child.Ram->WriteByte(0x0011, 0x99);
+        child.Cpu.PC = 0x0200;
+        child.Cpu.Execute(3u, *child.Ram, cache);
+
+        // Assert
+        EXPECT_EQ(child.Cpu.A, 0x99);
+    }
+
+
+    TEST_F(ForkFixture, ForkOfFork_DoesNotDependOnFirstForkPoint)
+    {
+        // Arrange
+        memory.WriteByte(0x1234, 0x56);
+        auto first = std::make_unique<ForkPoint>(cpu, memory);
+        auto child = first->Fork();
+        child.Ram->WriteByte(0x0010, 0x07);
+
+        // Act
+        ForkPoint second(child.Cpu, *child.Ram);
+        child = { };
+        first.reset();
+        auto grandchild = second.Fork();
+
+        // Assert
+        EXPECT_EQ(grandchild.Ram->ReadByte(0x1234), 0x56);
+        EXPECT_EQ(grandchild.Ram->ReadByte(0x0010), 0x07);
+    }
+
+
+    TEST_F(ForkFixture, Fork_KeepsRomMappings)
+    {
+        // Arrange
+        RomImage image(std::vector<Byte>(0x4000, 0xEA));
+        memory.MapRom(0xC0, 0x40, image.Data());
+        ForkPoint point(cpu, memory);
+
+        // Act
+        auto child = point.Fork();
+        child.Ram->WriteByte(0xC000, 0x00);
+
+        // Assert
+        EXPECT_EQ(child.Ram->ReadPages[0xC0], image.Data());
+        EXPECT_EQ(child.Ram->ReadByte(0xC000), 0xEA);
+    }
+
+}
\ No newline at end of file
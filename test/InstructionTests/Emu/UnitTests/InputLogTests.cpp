@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include <Emu/CPU.hpp>
+#include <Emu/InputLog.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    // A machine with a timer on the scheduler and a keypad taking input from outside
+    struct InputLogMachine
+    {
+        Memory memory;
+        CPU cpu;
+        Scheduler scheduler;
+        InputDevices devices;
+
+        InputLogMachine()
+        {
+            scheduler.Schedule(1000u, &Tick, nullptr);
+            devices.Connect(1, &Key, nullptr);
+        }
+
+        // Leaves the low byte of each deadline at $0014
+        static void Tick(void *, Scheduler & scheduler, Memory & memory, uint64 deadline)
+        {
+            memory.WriteByte(0x0014, static_cast<Byte>(deadline >> 3));
+            scheduler.Schedule(deadline + 1000u, &Tick, nullptr);
+        }
+
+        // Latches the key at $0013
+        static void Key(void *, Memory & memory, Scheduler &, uint32 value)
+        {
+            memory.WriteByte(0x0013, static_cast<Byte>(value));
+        }
+
+        // Counts through $0010 and reads the key into Y. The IRQ handler counts through $0011
+        // and the NMI handler through $0012, both by table lookup
+        void Load()
+        {
+            cpu.Reset(memory, 0x0200);
+
+            for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+                memory.WriteByte(0x3000 + i, static_cast<Byte>(i + 1));
+
+            memory.WriteByte(0x0200, CPU::INS_LDX_ZP);
+            memory.WriteByte(0x0201, 0x10);
+            memory.WriteByte(0x0202, CPU::INS_LDA_ABSX);
+            memory.WriteWord(0x0203, 0x3000);
+            memory.WriteByte(0x0205, CPU::INS_STA_ZP);
+            memory.WriteByte(0x0206, 0x10);
+            memory.WriteByte(0x0207, CPU::INS_LDY_ZP);
+            memory.WriteByte(0x0208, 0x13);
+            memory.WriteByte(0x0209, CPU::INS_JMP_ABS);
+            memory.WriteWord(0x020A, 0x0200);
+
+            memory.WriteWord(CPU::IRQ_VECTOR, 0x0300);
+            memory.WriteByte(0x0300, CPU::INS_LDX_ZP);
+            memory.WriteByte(0x0301, 0x11);
+            memory.WriteByte(0x0302, CPU::INS_LDA_ABSX);
+            memory.WriteWord(0x0303, 0x3000);
+            memory.WriteByte(0x0305, CPU::INS_STA_ZP);
+            memory.WriteByte(0x0306, 0x11);
+            memory.WriteByte(0x0307, CPU::INS_RTI);
+
+            memory.WriteWord(CPU::NMI_VECTOR, 0x0400);
+            memory.WriteByte(0x0400, CPU::INS_LDX_ZP);
+            memory.WriteByte(0x0401, 0x12);
+            memory.WriteByte(0x0402, CPU::INS_LDA_ABSX);
+            memory.WriteWord(0x0403, 0x3000);
+            memory.WriteByte(0x0405, CPU::INS_STA_ZP);
+            memory.WriteByte(0x0406, 0x12);
+            memory.WriteByte(0x0407, CPU::INS_RTI);
+        }
+    };
+
+    class InputLogFixture : public testing::Test
+    {
+    public:
+        InputLogMachine machine;
+
+        void SetUp() override
+        {
+            machine.Load();
+        }
+
+        void TearDown() override
+        { }
+
+        // A host harness poking the machine at odd times between runs of odd lengths
+        static InputLog RecordRun(InputLogMachine & machine, uint32 steps)
+        {
+            uint32 seed = 12345u;
+            auto next = [&seed]() { seed = seed * 1103515245u + 12345u; return seed >> 16; };
+
+            machine.scheduler.RaiseIrq(4u);
+            InputRecorder recorder(machine.cpu, machine.memory, machine.scheduler, machine.devices);
+
+            for (uint32 step = 0; step < steps; ++step)
+            {
+                machine.cpu.Execute(1 + next() % 400, machine.memory, machine.scheduler);
+
+                if (step == 0)
+                    recorder.ClearIrq(4u);
+
+                switch (next() % 8)
+                {
+                case 0: recorder.WriteByte(0x0010, static_cast<Byte>(next())); break;
+                case 1: recorder.RaiseIrq(); break;
+                case 2: recorder.ClearIrq(); break;
+                case 3: recorder.RaiseNmi(); break;
+                case 4: recorder.Input(1, next() % 256); break;
+                default: break;
+                }
+            }
+
+            recorder.ClearIrq();
+            return recorder.Log;
+        }
+
+        static void ExpectSameMachine(InputLogMachine & actual, InputLogMachine & expected)
+        {
+            EXPECT_EQ(actual.cpu.TotalCycles, expected.cpu.TotalCycles);
+            EXPECT_EQ(actual.cpu.PC, expected.cpu.PC);
+            EXPECT_EQ(actual.cpu.SP, expected.cpu.SP);
+            EXPECT_EQ(actual.cpu.A, expected.cpu.A);
+            EXPECT_EQ(actual.cpu.X, expected.cpu.X);
+            EXPECT_EQ(actual.cpu.Y, expected.cpu.Y);
+            EXPECT_EQ(actual.cpu.ObservedStatus(), expected.cpu.ObservedStatus());
+
+            uint32 differing = 0u;
+            for (uint32 address = 0; address < Memory::MAX_MEMORY; ++address)
+                differing += actual.memory.ReadByte(address) != expected.memory.ReadByte(address) ? 1u : 0u;
+
+            EXPECT_EQ(differing, 0u);
+        }
+    };
+
+
+    TEST_F(InputLogFixture, Replay_RecordedRun_EndsInSameState)
+    {
+        // Arrange
+        auto log = RecordRun(machine, 2000);
+        InputLogMachine replayed;
+
+        // Act
+        auto replay = log.Replay(replayed.cpu, replayed.memory, replayed.scheduler, replayed.devices, machine.cpu.TotalCycles);
+
+        // Assert
+        EXPECT_TRUE(replay);
+        EXPECT_GT(log.Events.size(), 1000u);
+        EXPECT_NE(machine.memory.ReadByte(0x0011), 0x00);
+        EXPECT_NE(machine.memory.ReadByte(0x0012), 0x00);
+        ExpectSameMachine(replayed, machine);
+    }
+
+    TEST_F(InputLogFixture, Replay_FromFile_EndsInSameState)
+    {
+        // Arrange
+        auto path = std::filesystem::temp_directory_path() / "Emu6502_Replay_FromFile_EndsInSameState.input";
+        auto recorded = RecordRun(machine, 500);
+        ASSERT_TRUE(recorded.SaveFile(path.string().c_str()));
+
+        InputLog log;
+        ASSERT_TRUE(log.Open(path.string().c_str()));
+        InputLogMachine replayed;
+
+        // Act
+        auto replay = log.Replay(replayed.cpu, replayed.memory, replayed.scheduler, replayed.devices, machine.cpu.TotalCycles);
+
+        // Assert
+        EXPECT_TRUE(replay);
+        EXPECT_EQ(log.Events, recorded.Events);
+        ExpectSameMachine(replayed, machine);
+
+        log = { };
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    TEST_F(InputLogFixture, Replay_EventBetweenInstructions_ReturnsFalse)
+    {
+        // Arrange
+        auto log = RecordRun(machine, 100);
+        log.Events[50].Cycle += 1;
+        InputLogMachine replayed;
+
+        // Act
+        auto replay = log.Replay(replayed.cpu, replayed.memory, replayed.scheduler, replayed.devices, machine.cpu.TotalCycles);
+
+        // Assert
+        EXPECT_FALSE(replay);
+    }
+
+    TEST_F(InputLogFixture, Replay_UnhandledInstruction_ReturnsFalse)
+    {
+        // Arrange, a BRK in place of the JMP ends the first pass
+        machine.memory.WriteByte(0x0209, 0x00);
+        InputRecorder recorder(machine.cpu, machine.memory, machine.scheduler, machine.devices);
+        InputLogMachine replayed;
+
+        // Act
+        auto replay = recorder.Log.Replay(replayed.cpu, replayed.memory, replayed.scheduler, replayed.devices, 2000u);
+
+        // Assert
+        EXPECT_FALSE(replay);
+        EXPECT_TRUE(replayed.cpu.DebugFlags.UnhandledInstruction);
+        EXPECT_LT(replayed.cpu.TotalCycles, 2000u);
+    }
+
+    TEST_F(InputLogFixture, Encode_EventsAreCompact)
+    {
+        // Arrange
+        auto log = RecordRun(machine, 2000);
+        auto stateSize = log.StartState.Size;
+
+        // Act
+        auto bytes = log.Encode();
+
+        // Assert, a varint cycle delta, the kind and the operands
+        EXPECT_LT(bytes.size() - sizeof(InputLog::Header) - stateSize, log.Events.size() * 5);
+    }
+
+    TEST_F(InputLogFixture, Decode_Truncated_ReturnsFalse)
+    {
+        // Arrange
+        auto bytes = RecordRun(machine, 100).Encode();
+        InputLog log;
+
+        // Act, cutting off the lines of the final ClearIrq
+        auto truncated = std::vector<Byte>(bytes.begin(), bytes.end() - 1);
+        auto decoded = log.Decode(RomImage(truncated));
+
+        // Assert
+        EXPECT_FALSE(decoded);
+        EXPECT_TRUE(log.Events.empty());
+    }
+
+    TEST_F(InputLogFixture, Decode_NotALog_ReturnsFalse)
+    {
+        // Arrange
+        auto bytes = SaveState::Save(machine.cpu, machine.memory);
+        InputLog log;
+
+        // Act
+        auto decoded = log.Decode(RomImage(bytes));
+
+        // Assert
+        EXPECT_FALSE(decoded);
+    }
+
+}
@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Loader.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class LoaderFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+        std::filesystem::path path;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory, 0x0200);
+            path = std::filesystem::temp_directory_path()
+                / (std::string("Emu6502_") + testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin");
+        }
+
+        void TearDown() override
+        {
+            std::error_code error;
+            std::filesystem::remove(path, error);
+        }
+
+        RomImage WriteFile(std::vector<Byte> const & bytes)
+        {
+            {
+                std::ofstream file(path, std::ios::binary);
+                file.write(reinterpret_cast<char const *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            }
+
+            return MapFile(path.string().c_str());
+        }
+
+        // Every byte of the returned buffer is its offset from start, mod 251 so pages differ
+        static std::vector<Byte> Pattern(size_t size, size_t start = 0)
+        {
+            std::vector<Byte> bytes(size);
+            for (size_t i = 0; i < size; ++i)
+                bytes[i] = static_cast<Byte>((start + i) % 251);
+            return bytes;
+        }
+
+        static std::vector<Byte> NesImage(Byte prgBanks, Byte mapperNumber)
+        {
+            std::vector<Byte> bytes = { 'N', 'E', 'S', 0x1A, prgBanks, 0, static_cast<Byte>(mapperNumber << 4), 0 };
+            bytes.resize(16);
+
+            for (uint32 bank = 0; bank < prgBanks; ++bank)
+            {
+                std::vector<Byte> prg(16 * 1024, static_cast<Byte>(bank));
+                bytes.insert(bytes.end(), prg.begin(), prg.end());
+            }
+
+            return bytes;
+        }
+    };
+
+
+    TEST_F(LoaderFixture, MapFile_ReadsFile)
+    {
+        // Act
+        auto image = WriteFile({ 0x01, 0x02, 0x03 });
+
+        // Assert
+        ASSERT_EQ(image.Size, 3u);
+        EXPECT_EQ(image.Data()[0], 0x01);
+        EXPECT_EQ(image.Data()[2], 0x03);
+    }
+
+
+    TEST_F(LoaderFixture, MapFile_Missing_IsEmpty)
+    {
+        // Act
+        auto image = MapFile((path.string() + ".missing").c_str());
+
+        // Assert
+        EXPECT_EQ(image.Size, 0u);
+        EXPECT_EQ(image.Data(), nullptr);
+        EXPECT_FALSE(Loader::LoadRaw(memory, image, 0x0000));
+    }
+
+
+    TEST_F(LoaderFixture, LoadRaw_PageAligned_MapsWithoutCopying)
+    {
+        // Arrange
+        auto image = WriteFile(Pattern(0x2000));
+
+        // Act
+        auto loaded = Loader::LoadRaw(memory, image, 0x4000);
+
+        // Assert
+        ASSERT_TRUE(loaded);
+        EXPECT_EQ(memory.ReadPages[0x40], image.Data());
+        EXPECT_EQ(memory.ReadPages[0x5F], image.Data() + 0x1F00);
+        EXPECT_EQ(memory.ReadByte(0x4000 + 1000), 1000 % 251);
+        EXPECT_EQ(memory.ReadByte(0x6000), 0x00);
+    }
+
+
+    TEST_F(LoaderFixture, LoadRaw_Unaligned_CopiesPartialPages)
+    {
+        // Arrange
+        memory.WriteByte(0x40FF, 0xAA);
+        memory.WriteByte(0x4381, 0xBB);
+        auto image = WriteFile(Pattern(0x0280));
+
+        // Act
+        Loader::LoadRaw(memory, image, 0x4101);
+
+        // Assert
+        EXPECT_EQ(memory.ReadPages[0x41], memory.Data + 0x4100);
+        EXPECT_EQ(memory.ReadPages[0x42], image.Data() + 0xFF);
+        EXPECT_EQ(memory.ReadPages[0x43], memory.Data + 0x4300);
+        EXPECT_EQ(memory.ReadByte(0x40FF), 0xAA);
+        EXPECT_EQ(memory.ReadByte(0x4381), 0xBB);
+
+        for (uint32 i = 0; i < 0x0280; ++i)
+            ASSERT_EQ(memory.ReadByte(0x4101 + i), i % 251) << i;
+    }
+
+
+    TEST_F(LoaderFixture, LoadRaw_Write_CopiesPageAndLeavesImage)
+    {
+        // Arrange
+        auto image = WriteFile(Pattern(0x0100));
+        Loader::LoadRaw(memory, image, 0x0300);
+
+        // Act
+        memory.WriteByte(0x0310, 0xEE);
+
+        // Assert
+        EXPECT_EQ(memory.ReadByte(0x0310), 0xEE);
+        EXPECT_EQ(memory.ReadByte(0x0311), 0x11);
+        EXPECT_EQ(image.Data()[0x10], 0x10);
+    }
+
+
+    TEST_F(LoaderFixture, LoadRaw_PastTopOfMemory_IsDropped)
+    {
+        // Arrange
+        auto image = WriteFile(Pattern(0x0200));
+
+        // Act
+        Loader::LoadRaw(memory, image, 0xFF80);
+
+        // Assert
+        EXPECT_EQ(memory.ReadByte(0xFFFF), 0x7F);
+        EXPECT_EQ(memory.ReadByte(0x0000), 0x00);
+    }
+
+
+    TEST_F(LoaderFixture, LoadPrg_RunsFromLoadAddress)
+    {
+        // Arrange
+        auto bytes = std::vector<Byte> { 0x01, 0x08, CPU::INS_LDA_IM, 0x42, CPU::INS_STA_ABS, 0x00, 0x30 };
+        auto image = WriteFile(bytes);
+        Word loadAddress = 0;
+
+        // Act
+        auto loaded = Loader::LoadPrg(memory, image, &loadAddress);
+        cpu.PC = loadAddress;
+        cpu.Execute(2u + 4u, memory);
+
+        // Assert
+        ASSERT_TRUE(loaded);
+        EXPECT_EQ(loadAddress, 0x0801);
+        EXPECT_EQ(memory.ReadByte(0x3000), 0x42);
+    }
+
+
+    TEST_F(LoaderFixture, SameImage_SharedBetweenMemories)
+    {
+        // Arrange
+        Memory other;
+        auto image = WriteFile(Pattern(0x4000));
+
+        // Act
+        Loader::LoadRaw(memory, image, 0x8000);
+        Loader::LoadRaw(other, image, 0x8000);
+        other.WriteByte(0x8000, 0xEE);
+
+        // Assert
+        EXPECT_EQ(memory.ReadPages[0x81], other.ReadPages[0x81]);
+        EXPECT_EQ(memory.ReadByte(0x8000), 0x00);
+        EXPECT_EQ(other.ReadByte(0x8000), 0xEE);
+    }
+
+
+    TEST_F(LoaderFixture, LoadNes_Nrom128_MirrorsPrg)
+    {
+        // Arrange
+        auto image = WriteFile(NesImage(1, 0));
+
+        // Act
+        auto mapper = Loader::LoadNes(memory, image);
+
+        // Assert
+        ASSERT_NE(mapper, nullptr);
+        EXPECT_EQ(memory.ReadPages[0x80], image.Data() + 16);
+        EXPECT_EQ(memory.ReadPages[0xC0], image.Data() + 16);
+    }
+
+
+    TEST_F(LoaderFixture, LoadNes_UxRom_GuestWriteSwitchesBank)
+    {
+        // Arrange
+        auto image = WriteFile(NesImage(8, 2));
+        auto mapper = Loader::LoadNes(memory, image);
+        ASSERT_NE(mapper, nullptr);
+
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x05);
+        memory.WriteByte(0x0202, CPU::INS_STA_ABS);
+        memory.WriteWord(0x0203, 0x8000);
+        memory.WriteByte(0x0205, CPU::INS_LDX_ABS);
+        memory.WriteWord(0x0206, 0x8000);
+        memory.WriteByte(0x0208, CPU::INS_LDY_ABS);
+        memory.WriteWord(0x0209, 0xC000);
+
+        // Act
+        cpu.Execute(2u + 4u + 4u + 4u, memory);
+
+        // Assert
+        EXPECT_EQ(cpu.X, 5);
+        EXPECT_EQ(cpu.Y, 7);
+        EXPECT_EQ(memory.ReadByte(0x8000), 5);
+    }
+
+
+    TEST_F(LoaderFixture, LoadNes_BadHeaderOrMapper_Fails)
+    {
+        // Arrange
+        auto bad = Pattern(0x8000);
+        auto unsupported = NesImage(2, 1);
+
+        // Act / Assert
+        EXPECT_EQ(Loader::LoadNes(memory, RomImage(bad)), nullptr);
+        EXPECT_EQ(Loader::LoadNes(memory, RomImage(unsupported)), nullptr);
+        EXPECT_TRUE(memory.IsFlat());
+    }
+
+}
\ No newline at end of file
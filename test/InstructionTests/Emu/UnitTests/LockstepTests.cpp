@@ -0,0 +1,261 @@
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Lockstep.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class LockstepFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+
+        void SetUp() override
+        {
+            memory.Initialize();
+        }
+
+        void TearDown() override
+        { }
+
+        // Runs every lane on the interpreter from the lane's starting CPU and compares the results
+        template <uint32 Lanes>
+        void AssertMatchesInterpreter(
+            Lockstep<Lanes> & lockstep,
+            CPU const * initial,
+            std::vector<std::pair<Word, Byte>> const * inputs,
+            uint32 cycles)
+        {
+            for (uint32 lane = 0; lane < Lanes; ++lane)
+            {
+                Memory laneMemory = memory;
+                for (auto [address, value] : inputs[lane])
+                    laneMemory.WriteByte(address, value);
+
+                CPU cpu = initial[lane];
+                auto cyclesUsed = cpu.Execute(cycles, laneMemory);
+
+                auto const & result = lockstep.Cpus[lane];
+                ASSERT_EQ(lockstep.CyclesUsed[lane], cyclesUsed) << "lane " << lane;
+                ASSERT_EQ(result.PC, cpu.PC) << "lane " << lane;
+                ASSERT_EQ(result.A, cpu.A) << "lane " << lane;
+                ASSERT_EQ(result.X, cpu.X) << "lane " << lane;
+                ASSERT_EQ(result.Y, cpu.Y) << "lane " << lane;
+                ASSERT_EQ(result.SP, cpu.SP) << "lane " << lane;
+                ASSERT_EQ(result.Status, cpu.Status) << "lane " << lane;
+                ASSERT_EQ(result.TotalCycles, cpu.TotalCycles) << "lane " << lane;
+                ASSERT_EQ(result.DebugFlags.UnhandledInstruction, cpu.DebugFlags.UnhandledInstruction) << "lane " << lane;
+                ASSERT_EQ(result.DebugFlags.CycleOverflow, cpu.DebugFlags.CycleOverflow) << "lane " << lane;
+
+                for (uint32 address = 0; address < Memory::MAX_MEMORY; ++address)
+                {
+                    ASSERT_EQ(lockstep.ReadByte(lane, static_cast<Word>(address)), laneMemory.ReadByte(static_cast<Word>(address)))
+                        << "lane " << lane << " address " << address;
+                }
+            }
+        }
+    };
+
+
+    TEST_F(LockstepFixture, Run_LogicalSweep_MatchesInterpreter)
+    {
+        // Arrange
+        Word address = 0x0200;
+        auto emit = [&](Byte value) { memory.WriteByte(address++, value); };
+
+        // A and 0x0010 take every value across the lanes
+        emit(CPU::INS_AND_ZP);      emit(0x10);
+        emit(CPU::INS_STA_ZP);      emit(0x11);
+        emit(CPU::INS_EOR_IM);      emit(0x5A);
+        emit(CPU::INS_ORA_ZP);      emit(0x10);
+        emit(CPU::INS_BIT_ZP);      emit(0x11);
+        emit(CPU::INS_PHP);
+        emit(CPU::INS_STA_ABS);     emit(0x00);     emit(0x04);
+        emit(CPU::INS_LDX_ZP);      emit(0x10);
+        emit(CPU::INS_EOR_ABSX);    emit(0xC0);     emit(0x04);
+        emit(CPU::INS_JMP_ABS);     emit(0x00);     emit(0x02);
+
+        for (uint32 i = 0; i < 0x0200; ++i)
+            memory.WriteByte(static_cast<Word>(0x0400 + i), static_cast<Byte>(i * 7));
+
+        auto lockstep = std::make_unique<Lockstep<256>>(memory, 0x0200);
+        std::array<CPU, 256> initial;
+        std::vector<std::pair<Word, Byte>> inputs[256];
+
+        for (uint32 lane = 0; lane < 256; ++lane)
+        {
+            lockstep->Cpus[lane].A = static_cast<Byte>(lane);
+            lockstep->WriteByte(lane, 0x0010, static_cast<Byte>(255 - lane));
+            initial[lane] = lockstep->Cpus[lane];
+            inputs[lane].push_back({ 0x0010, static_cast<Byte>(255 - lane) });
+        }
+
+        // Act
+        lockstep->Run(1000);
+
+        // Assert
+        EXPECT_EQ(lockstep->DivergedCount(), 0u);
+        AssertMatchesInterpreter(*lockstep, initial.data(), inputs, 1000);
+    }
+
+    TEST_F(LockstepFixture, Run_RandomPrograms_MatchInterpreter)
+    {
+        std::mt19937 random(6502);
+        auto randomByte = [&]() { return static_cast<Byte>(random()); };
+
+        for (uint32 program = 0; program < 8; ++program)
+        {
+            // Arrange
+            memory.Initialize();
+            for (uint32 address = 0; address < Memory::MAX_MEMORY; ++address)
+                memory.WriteByte(static_cast<Word>(address), randomByte());
+
+            Word address = 0x0200;
+            while (address < 0x0300)
+            {
+                auto const & description = CPU::OpCodeDescriptions[random() % std::size(CPU::OpCodeDescriptions)];
+                auto length = InstructionLength(description.Mode);
+
+                memory.WriteByte(address++, description.OpCode);
+                for (uint32 i = 1; i < length; ++i)
+                    memory.WriteByte(address++, randomByte());
+            }
+
+            auto lockstep = std::make_unique<Lockstep<64>>(memory, 0x0200);
+            std::array<CPU, 64> initial;
+            std::vector<std::pair<Word, Byte>> inputs[64];
+
+            for (uint32 lane = 0; lane < 64; ++lane)
+            {
+                auto & cpu = lockstep->Cpus[lane];
+                cpu.A = randomByte();
+                cpu.X = randomByte() & 0x0F;
+                cpu.Y = randomByte() & 0x0F;
+                cpu.SP = randomByte();
+                cpu.Status = randomByte();
+                initial[lane] = cpu;
+
+                for (uint32 i = 0; i < 16; ++i)
+                {
+                    // Zero page, stack and data pages
+                    Word input = (random() % 3) * 0x0100 + randomByte();
+                    if (input >= 0x0200)
+                        input += 0x0200;
+
+                    auto value = randomByte();
+                    lockstep->WriteByte(lane, input, value);
+                    inputs[lane].push_back({ input, value });
+                }
+            }
+
+            // Act
+            lockstep->Run(300);
+
+            // Assert
+            AssertMatchesInterpreter(*lockstep, initial.data(), inputs, 300);
+        }
+    }
+
+    TEST_F(LockstepFixture, Run_ReturnAddressDiffers_LanesDiverge)
+    {
+        // Arrange
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x03);
+        memory.WriteByte(0x0202, CPU::INS_PHA);
+        memory.WriteByte(0x0203, CPU::INS_LDA_ZP);
+        memory.WriteByte(0x0204, 0x10);
+        memory.WriteByte(0x0205, CPU::INS_PHA);
+        memory.WriteByte(0x0206, CPU::INS_RTS);
+        memory.WriteByte(0x0301, CPU::INS_LDX_IM);
+        memory.WriteByte(0x0302, 0x01);
+        memory.WriteByte(0x0311, CPU::INS_LDX_IM);
+        memory.WriteByte(0x0312, 0x02);
+
+        auto lockstep = std::make_unique<Lockstep<64>>(memory, 0x0200);
+        for (uint32 lane = 0; lane < 64; ++lane)
+            lockstep->WriteByte(lane, 0x0010, lane % 2 == 0 ? 0x00 : 0x10);
+
+        // Act
+        lockstep->Run(2 + 3 + 3 + 3 + 6 + 2);
+
+        // Assert
+        EXPECT_EQ(lockstep->DivergedCount(), 32u);
+
+        for (uint32 lane = 0; lane < 64; ++lane)
+        {
+            EXPECT_EQ(lockstep->Cpus[lane].X, lane % 2 == 0 ? 0x01 : 0x02);
+            EXPECT_EQ(lockstep->Cpus[lane].PC, lane % 2 == 0 ? 0x0303 : 0x0313);
+            EXPECT_EQ(lockstep->CyclesUsed[lane], 19u);
+        }
+    }
+
+    TEST_F(LockstepFixture, Run_DifferentStartingPCs_RunSeparately)
+    {
+        // Arrange
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x42);
+        memory.WriteByte(0x0300, CPU::INS_LDY_IM);
+        memory.WriteByte(0x0301, 0x24);
+
+        auto lockstep = std::make_unique<Lockstep<32>>(memory, 0x0200);
+        lockstep->Cpus[5].PC = 0x0300;
+
+        // Act
+        lockstep->Run(2);
+
+        // Assert
+        EXPECT_EQ(lockstep->DivergedCount(), 1u);
+        EXPECT_EQ(lockstep->Cpus[0].A, 0x42);
+        EXPECT_EQ(lockstep->Cpus[5].Y, 0x24);
+        EXPECT_EQ(lockstep->Cpus[5].A, 0x00);
+        EXPECT_EQ(lockstep->CyclesUsed[5], 2u);
+    }
+
+    TEST_F(LockstepFixture, Run_UnhandledInstruction_HaltsEveryLane)
+    {
+        // Arrange
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x42);
+        memory.WriteByte(0x0202, 0xFF);
+
+        auto lockstep = std::make_unique<Lockstep<32>>(memory, 0x0200);
+
+        // Act
+        lockstep->Run(100);
+
+        // Assert
+        for (uint32 lane = 0; lane < 32; ++lane)
+        {
+            EXPECT_TRUE(lockstep->Cpus[lane].DebugFlags.UnhandledInstruction);
+            EXPECT_EQ(lockstep->Cpus[lane].PC, 0x0203);
+            EXPECT_EQ(lockstep->CyclesUsed[lane], 3u);
+        }
+    }
+
+    TEST_F(LockstepFixture, Run_WriteToRom_IsDropped)
+    {
+        // Arrange
+        static Byte const rom[Memory::PAGE_SIZE] = { };
+        memory.MapRom(0x80, 1, rom);
+
+        memory.WriteByte(0x0200, CPU::INS_STA_ABS);
+        memory.WriteWord(0x0201, 0x8010);
+
+        auto lockstep = std::make_unique<Lockstep<32>>(memory, 0x0200);
+        for (uint32 lane = 0; lane < 32; ++lane)
+            lockstep->Cpus[lane].A = static_cast<Byte>(lane + 1);
+
+        // Act
+        lockstep->Run(4);
+
+        // Assert
+        EXPECT_TRUE(lockstep->Pages.empty());
+        for (uint32 lane = 0; lane < 32; ++lane)
+            EXPECT_EQ(lockstep->ReadByte(lane, 0x8010), 0x00);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Mapper.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class MapperFixture : public testing::Test
+    {
+    public:
+        static constexpr uint32 BANK_SIZE = 16 * 1024;
+        static constexpr uint32 BANK_COUNT = 16;
+
+        Memory memory;
+        CPU cpu;
+        RomImage image;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory, 0x0200);
+
+            // 256KB image, every bank starts with its own number and an LDA #bank; RTS routine
+            std::vector<Byte> bytes(BANK_SIZE * BANK_COUNT);
+            for (uint32 bank = 0; bank < BANK_COUNT; ++bank)
+            {
+                bytes[bank * BANK_SIZE + 0] = static_cast<Byte>(bank);
+                bytes[bank * BANK_SIZE + 1] = CPU::INS_LDA_IM;
+                bytes[bank * BANK_SIZE + 2] = static_cast<Byte>(bank);
+                bytes[bank * BANK_SIZE + 3] = CPU::INS_RTS;
+            }
+
+            image = RomImage(bytes);
+        }
+
+        void TearDown() override
+        { }
+
+        // Switchable bank at 0x8000 and the last bank fixed at 0xC000
+        BankedMapper MakeMapper()
+        {
+            return BankedMapper(image, { { 0x80, 0x40, 0 }, { 0xC0, 0x40, BANK_COUNT - 1 } });
+        }
+    };
+
+
+    TEST_F(MapperFixture, Attach_MapsInitialBanks)
+    {
+        // Arrange
+        auto mapper = MakeMapper();
+
+        // Act
+        mapper.Attach(memory);
+
+        // Assert
+        EXPECT_EQ(mapper.BankCount(0), BANK_COUNT);
+        EXPECT_EQ(memory.ReadByte(0x8000), 0);
+        EXPECT_EQ(memory.ReadByte(0xC000), BANK_COUNT - 1);
+    }
+
+
+    TEST_F(MapperFixture, Select_RepointsPagesWithoutCopying)
+    {
+        // Arrange
+        auto mapper = MakeMapper();
+        mapper.Attach(memory);
+
+        // Act
+        mapper.Select(memory, 0, 5);
+
+        // Assert
+        EXPECT_EQ(memory.ReadByte(0x8000), 5);
+        EXPECT_EQ(memory.ReadPages[0x80], image.Data() + 5 * BANK_SIZE);
+        EXPECT_EQ(memory.ReadPages[0xBF], image.Data() + 5 * BANK_SIZE + 0x3F00);
+        EXPECT_EQ(memory.ReadByte(0xC000), BANK_COUNT - 1);
+    }
+
+
+    TEST_F(MapperFixture, Select_PastLastBank_Wraps)
+    {
+        // Arrange
+        auto mapper = MakeMapper();
+        mapper.Attach(memory);
+
+        // Act
+        mapper.Select(memory, 0, BANK_COUNT + 3);
+
+        // Assert
+        EXPECT_EQ(mapper.Windows[0].Bank, 3u);
+        EXPECT_EQ(memory.ReadByte(0x8000), 3);
+    }
+
+
+    TEST_F(MapperFixture, Attach_ImageSmallerThanBank_FailsAndLeavesMemoryAlone)
+    {
+        // Arrange
+        BankedMapper small(RomImage(std::vector<Byte>(BANK_SIZE - 1)), { { 0x80, 0x40, 0 } });
+        BankedMapper empty(RomImage(std::vector<Byte>()), { { 0x80, 0x40, 0 } });
+
+        // Act
+        auto smallAttached = small.Attach(memory);
+        auto emptyAttached = empty.Attach(memory);
+        auto selected = small.Select(memory, 0, 1);
+
+        // Assert
+        EXPECT_EQ(small.BankCount(0), 0u);
+        EXPECT_FALSE(smallAttached);
+        EXPECT_FALSE(emptyAttached);
+        EXPECT_FALSE(selected);
+        EXPECT_TRUE(memory.IsFlat());
+    }
+
+
+    TEST_F(MapperFixture, WriteToRom_WithoutRegister_IsDropped)
+    {
+        // Arrange
+        auto mapper = MakeMapper();
+        mapper.Attach(memory);
+
+        // Act
+        memory.WriteByte(0x8000, 0x77);
+
+        // Assert
+        EXPECT_EQ(memory.ReadByte(0x8000), 0);
+        EXPECT_EQ(mapper.Windows[0].Bank, 0u);
+    }
+
+
+    TEST_F(MapperFixture, GuestWriteToRegister_SwitchesBank)
+    {
+        // Arrange
+        auto mapper = MakeMapper();
+        mapper.RegisterWindow = 0;
+        mapper.Attach(memory);
+
+        memory.WriteByte(0x0200, CPU::INS_LDX_IM);
+        memory.WriteByte(0x0201, 0x07);
+        memory.WriteByte(0x0202, CPU::INS_STX_ABS);
+        memory.WriteWord(0x0203, 0xC123);
+        memory.WriteByte(0x0205, CPU::INS_LDA_ABS);
+        memory.WriteWord(0x0206, 0x8000);
+
+        // Act
+        cpu.Execute(2u + 4u + 4u, memory);
+
+        // Assert
+        EXPECT_EQ(mapper.Windows[0].Bank, 7u);
+        EXPECT_EQ(cpu.A, 7);
+    }
+
+
+    TEST_F(MapperFixture, BankSwitch_InvalidatesCachedCode)
+    {
+        // Arrange
+        BlockCache cache;
+        auto mapper = MakeMapper();
+        mapper.Attach(memory);
+
+        memory.WriteByte(0x0200, CPU::INS_JSR);
+        memory.WriteWord(0x0201, 0x8001);
+
+        cpu.Execute(6u + 2u + 6u, memory, cache);
+        EXPECT_EQ(cpu.A, 0);
+
+        // Act
+        mapper.Select(memory, 0, 9);
+        cpu.PC = 0x0200;
+        cpu.Execute(6u + 2u + 6u, memory, cache);
+
+        // Assert
+        EXPECT_EQ(cpu.A, 9);
+        EXPECT_EQ(cpu.PC, 0x0203);
+    }
+
+
+    TEST_F(MapperFixture, Image_IsSharedBetweenMappers)
+    {
+        // Arrange
+        Memory other;
+        auto first = MakeMapper();
+        auto second = MakeMapper();
+
+        // Act
+        first.Attach(memory);
+        second.Attach(other);
+
+        // Assert
+        EXPECT_EQ(first.Image.Data(), second.Image.Data());
+        EXPECT_EQ(memory.ReadPages[0xC0], other.ReadPages[0xC0]);
+        EXPECT_EQ(image.Bytes.use_count(), 3);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include <gtest/gtest.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Memory.hpp>
+#include <Emu/Recompiler.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    // Records accesses to a mapped page
+    struct TestDevice
+    {
+        Byte Value = 0x00;
+        Word LastReadAddress = 0;
+        Word LastWriteAddress = 0;
+        uint32 Reads = 0;
+        uint32 Writes = 0;
+
+        static Byte Read(void * context, Word address)
+        {
+            auto & device = *static_cast<TestDevice *>(context);
+            device.LastReadAddress = address;
+            ++device.Reads;
+            return device.Value;
+        }
+
+        static void Write(void * context, Memory & memory, Word address, Byte value)
+        {
+            auto & device = *static_cast<TestDevice *>(context);
+            device.LastWriteAddress = address;
+            device.Value = value;
+            ++device.Writes;
+        }
+    };
+
+    class MemoryFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+        TestDevice device;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory, 0x0200);
+        }
+
+        void TearDown() override
+        { }
+    };
+
+
+    TEST_F(MemoryFixture, Default_IsFlatRam)
+    {
+        // Act
+        memory.WriteByte(0x1234, 0x56);
+
+        // Assert
+        EXPECT_TRUE(memory.IsFlat());
+        EXPECT_EQ(memory.ReadByte(0x1234), 0x56);
+        EXPECT_EQ(memory.Data[0x1234], 0x56);
+    }
+
+
+    TEST_F(MemoryFixture, MapMemory_ReadOnly_DropsWrites)
+    {
+        // Arrange
+        Byte rom[Memory::PAGE_SIZE * 2] = { };
+        rom[0x0101] = 0x42;
+        memory.MapMemory(0xC0, 2, rom, false);
+
+        // Act
+        memory.WriteByte(0xC101, 0x11);
+
+        // Assert
+        EXPECT_FALSE(memory.IsFlat());
+        EXPECT_EQ(memory.ReadByte(0xC101), 0x42);
+        EXPECT_EQ(rom[0x0101], 0x42);
+    }
+
+
+    TEST_F(MemoryFixture, MapHandlers_LoadAndStore_CallDevice)
+    {
+        // Arrange
+        memory.MapHandlers(0xD0, 1, &TestDevice::Read, &TestDevice::Write, &device);
+        device.Value = 0x80;
+
+        memory.WriteByte(0x0200, CPU::INS_LDA_ABS);
+        memory.WriteWord(0x0201, 0xD012);
+        memory.WriteByte(0x0203, CPU::INS_STX_ABS);
+        memory.WriteWord(0x0204, 0xD020);
+        cpu.X = 0x33;
+
+        // Act
+        auto cyclesUsed = cpu.Execute(4u + 4u, memory);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 8u);
+        EXPECT_EQ(cpu.A, 0x80);
+        EXPECT_TRUE(cpu.StatusFlags.NegativeFlag);
+        EXPECT_EQ(device.LastReadAddress, 0xD012);
+        EXPECT_EQ(device.LastWriteAddress, 0xD020);
+        EXPECT_EQ(device.Value, 0x33);
+        EXPECT_EQ(device.Reads, 1u);
+        EXPECT_EQ(device.Writes, 1u);
+    }
+
+
+    TEST_F(MemoryFixture, Unmap_RestoresRam)
+    {
+        // Arrange
+        memory.WriteByte(0xD000, 0x12);
+        memory.MapHandlers(0xD0, 1, &TestDevice::Read, &TestDevice::Write, &device);
+
+        // Act
+        memory.Unmap(0xD0, 1);
+
+        // Assert
+        EXPECT_TRUE(memory.IsFlat());
+        EXPECT_EQ(memory.ReadByte(0xD000), 0x12);
+    }
+
+
+    TEST_F(MemoryFixture, Copy_RebasesRamPages)
+    {
+        // Arrange
+        Byte rom[Memory::PAGE_SIZE] = { 0x99 };
+        memory.MapMemory(0xF0, 1, rom, false);
+        memory.WriteByte(0x0010, 0x01);
+
+        // Act
+        auto copy = std::make_unique<Memory>(memory);
+        copy->WriteByte(0x0010, 0x02);
+
+        // Assert
+        EXPECT_EQ(memory.ReadByte(0x0010), 0x01);
+        EXPECT_EQ(copy->ReadByte(0x0010), 0x02);
+        EXPECT_EQ(copy->ReadByte(0xF000), 0x99);
+        EXPECT_EQ(copy->RemappedPages, 1u);
+    }
+
+
+    TEST_F(MemoryFixture, ReadWord_AtTopOfMemory_WrapsToZero)
+    {
+        // Arrange
+        memory.WriteByte(0xFFFF, 0x34);
+        memory.WriteByte(0x0000, 0x12);
+
+        // Act / Assert
+        EXPECT_EQ(memory.ReadWord(0xFFFF), 0x1234);
+    }
+
+
+    TEST_F(MemoryFixture, MapMemory_OverCachedCode_InvalidatesBlock)
+    {
+        // Arrange
+        BlockCache cache;
+        Byte rom[Memory::PAGE_SIZE] = { CPU::INS_LDA_IM, 0x22 };
+
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x11);
+        cpu.Execute(2u, memory, cache);
+
+        // Act
+        memory.MapMemory(0x02, 1, rom, false);
+        cpu.PC = 0x0200;
+        cpu.Execute(2u, memory, cache);
+
+        // Assert
+        EXPECT_EQ(cpu.A, 0x22);
+    }
+
+
+    TEST_F(MemoryFixture, Recompiler_WithMappedPage_MatchesInterpreter)
+    {
+        // Arrange
+        Recompiler recompiler;
+        recompiler.HotThreshold = 1u;
+        memory.MapHandlers(0xD0, 1, &TestDevice::Read, &TestDevice::Write, &device);
+
+        memory.WriteByte(0x0200, CPU::INS_LDA_ABS);
+        memory.WriteWord(0x0201, 0xD000);
+        memory.WriteByte(0x0203, CPU::INS_STA_ABS);
+        memory.WriteWord(0x0204, 0xD000);
+        memory.WriteByte(0x0206, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0207, 0x0200);
+        device.Value = 0x5A;
+
+        // Act
+        auto cyclesUsed = cpu.Execute(11u * 10u, memory, recompiler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 110u);
+        EXPECT_EQ(cpu.A, 0x5A);
+        EXPECT_EQ(device.Reads, 10u);
+        EXPECT_EQ(device.Writes, 10u);
+    }
+
+
+    TEST_F(MemoryFixture, Write_ToCleanPage_ListsPageOnce)
+    {
+        // Act
+        memory.WriteByte(0x1234, 0x56);
+        memory.WriteByte(0x12FF, 0x57);
+        memory.WriteByte(0x4000, 0x58);
+
+        // Assert
+        ASSERT_EQ(memory.DirtyCount, 2u);
+        EXPECT_EQ(memory.DirtyPages[0], 0x12);
+        EXPECT_EQ(memory.DirtyPages[1], 0x40);
+        EXPECT_EQ(memory.WatchedPages[0x12], 0);
+    }
+
+
+    TEST_F(MemoryFixture, Initialize_AfterWrites_ClearsOnlyDirtyPages)
+    {
+        // Arrange
+        memory.WriteByte(0x1234, 0x56);
+        memory.WriteByte(0x8000, 0x57);
+
+        // Act
+        auto cleared = memory.ResetTo(Memory::Zeroes);
+
+        // Assert
+        EXPECT_EQ(cleared, 2u);
+        EXPECT_EQ(memory.ReadByte(0x1234), 0x00);
+        EXPECT_EQ(memory.ReadByte(0x8000), 0x00);
+        EXPECT_EQ(memory.DirtyCount, 0u);
+    }
+
+
+    TEST_F(MemoryFixture, ResetToSnapshot_RestoresWrittenPages)
+    {
+        // Arrange
+        MemorySnapshot snapshot;
+        memory.WriteByte(0x1234, 0x56);
+        memory.Checkpoint(snapshot);
+
+        memory.WriteByte(0x1234, 0x11);
+        memory.WriteByte(0x2000, 0x22);
+
+        // Act
+        auto restored = memory.ResetToSnapshot(snapshot);
+
+        // Assert
+        EXPECT_EQ(restored, 2u);
+        EXPECT_EQ(memory.ReadByte(0x1234), 0x56);
+        EXPECT_EQ(memory.ReadByte(0x2000), 0x00);
+
+        memory.WriteByte(0x3000, 0x33);
+        EXPECT_EQ(memory.ResetToSnapshot(snapshot), 1u);
+        EXPECT_EQ(memory.ReadByte(0x3000), 0x00);
+    }
+
+
+    TEST_F(MemoryFixture, ResetToSnapshot_NotLastCheckpoint_CopiesEverything)
+    {
+        // Arrange
+        MemorySnapshot snapshot;
+        memory.WriteByte(0x1234, 0x56);
+        memory.Checkpoint(snapshot);
+        memory.Initialize();
+
+        // Act
+        auto restored = memory.ResetToSnapshot(snapshot);
+
+        // Assert
+        EXPECT_EQ(restored, Memory::PAGE_COUNT);
+        EXPECT_EQ(memory.ReadByte(0x1234), 0x56);
+    }
+
+
+    TEST_F(MemoryFixture, ResetToSnapshot_OverCachedCode_InvalidatesBlock)
+    {
+        // Arrange
+        BlockCache cache;
+        MemorySnapshot snapshot;
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x11);
+        memory.Checkpoint(snapshot);
+
+        memory.WriteByte(0x0201, 0x22);
+        cpu.Execute(2u, memory, cache);
+        EXPECT_EQ(cpu.A, 0x22);
+
+        // Act
+        cpu.Reset(memory, snapshot, 0x0200);
+        cpu.Execute(2u, memory, cache);
+
+        // Assert
+        EXPECT_EQ(cpu.A, 0x11);
+    }
+
+
+    TEST_F(MemoryFixture, Recompiler_StoresAfterCheckpoint_AreTracked)
+    {
+        // Arrange
+        Recompiler recompiler;
+        recompiler.HotThreshold = 1u;
+        MemorySnapshot snapshot;
+
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x77);
+        memory.WriteByte(0x0202, CPU::INS_STA_ABS);
+        memory.WriteWord(0x0203, 0x3000);
+        memory.WriteByte(0x0205, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0206, 0x0200);
+        cpu.Execute(9u * 10u, memory, recompiler);
+        memory.Checkpoint(snapshot);
+
+        // Act
+        memory.WriteByte(0x0201, 0x88);
+        cpu.Execute(9u * 10u, memory, recompiler);
+        EXPECT_EQ(memory.ReadByte(0x3000), 0x88);
+        auto restored = memory.ResetToSnapshot(snapshot);
+
+        // Assert
+        EXPECT_EQ(restored, 2u);
+        EXPECT_EQ(memory.ReadByte(0x3000), 0x77);
+        EXPECT_EQ(memory.ReadByte(0x0201), 0x77);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Profiler.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class ProfilerFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+        OpCodeProfiler profiler;
+
+        // Cycles taken by one pass of the loop written in SetUp
+        static constexpr uint32 LOOP_CYCLES = 2 + 5 + 4 + 5 + 3;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory, 0x0200);
+
+            // LDX #$FF / LDA $10FF,X (crosses) / LDA $1000,X / STA $10FF,X / JMP $0200
+            memory.WriteByte(0x0200, CPU::INS_LDX_IM);
+            memory.WriteByte(0x0201, 0xFF);
+            memory.WriteByte(0x0202, CPU::INS_LDA_ABSX);
+            memory.WriteWord(0x0203, 0x10FF);
+            memory.WriteByte(0x0205, CPU::INS_LDA_ABSX);
+            memory.WriteWord(0x0206, 0x1000);
+            memory.WriteByte(0x0208, CPU::INS_STA_ABSX);
+            memory.WriteWord(0x0209, 0x10FF);
+            memory.WriteByte(0x020B, CPU::INS_JMP_ABS);
+            memory.WriteWord(0x020C, 0x0200);
+        }
+
+        void TearDown() override
+        { }
+    };
+
+
+    TEST_F(ProfilerFixture, ExecuteProfiled_CountsExecutionsCyclesAndPageCrossings)
+    {
+        // Act
+        auto cyclesUsed = cpu.ExecuteProfiled(LOOP_CYCLES * 10, memory, profiler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, LOOP_CYCLES * 10);
+
+        auto const & ldx = profiler.OpCodes[CPU::INS_LDX_IM];
+        EXPECT_EQ(ldx.Executions, 10u);
+        EXPECT_EQ(ldx.Cycles, 20u);
+        EXPECT_EQ(ldx.PageCrossings, 0u);
+
+        auto const & lda = profiler.OpCodes[CPU::INS_LDA_ABSX];
+        EXPECT_EQ(lda.Executions, 20u);
+        EXPECT_EQ(lda.Cycles, 90u);
+        EXPECT_EQ(lda.PageCrossings, 10u);
+
+        // Stores always take the indexing cycle, it is part of their base cycles
+        auto const & sta = profiler.OpCodes[CPU::INS_STA_ABSX];
+        EXPECT_EQ(sta.Executions, 10u);
+        EXPECT_EQ(sta.Cycles, 50u);
+        EXPECT_EQ(sta.PageCrossings, 0u);
+
+        auto total = profiler.Total();
+        EXPECT_EQ(total.Executions, 50u);
+        EXPECT_EQ(total.Cycles, LOOP_CYCLES * 10);
+    }
+
+    TEST_F(ProfilerFixture, ByMode_SumsOpCodesOfThatMode)
+    {
+        // Act
+        cpu.ExecuteProfiled(LOOP_CYCLES * 4, memory, profiler);
+
+        // Assert
+        auto indexed = profiler.ByMode(AddressingMode::AbsoluteX);
+        EXPECT_EQ(indexed.Executions, 12u);
+        EXPECT_EQ(indexed.Cycles, 4u * (5 + 4 + 5));
+        EXPECT_EQ(indexed.PageCrossings, 4u);
+
+        auto absolute = profiler.ByMode(AddressingMode::Absolute);
+        EXPECT_EQ(absolute.Executions, 4u);
+        EXPECT_EQ(absolute.Cycles, 12u);
+
+        EXPECT_EQ(profiler.ByMode(AddressingMode::IndirectY).Executions, 0u);
+    }
+
+    TEST_F(ProfilerFixture, ExecuteProfiled_MatchesUnprofiledRun)
+    {
+        // Arrange
+        Memory expectedMemory = memory;
+        CPU expected = cpu;
+
+        // Act
+        auto expectedCycles = expected.Execute(1000, expectedMemory);
+        auto cyclesUsed = cpu.ExecuteProfiled(1000, memory, profiler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, expectedCycles);
+        EXPECT_EQ(cpu.TotalCycles, expected.TotalCycles);
+        EXPECT_EQ(cpu.PC, expected.PC);
+        EXPECT_EQ(cpu.A, expected.A);
+        EXPECT_EQ(cpu.X, expected.X);
+        EXPECT_EQ(cpu.DebugFlags.CycleOverflow, expected.DebugFlags.CycleOverflow);
+        EXPECT_EQ(profiler.Total().Cycles, cyclesUsed);
+    }
+
+    TEST_F(ProfilerFixture, UnhandledInstruction_CountedWithoutMode)
+    {
+        // Arrange
+        memory.WriteByte(0x0200, 0x02);
+
+        // Act
+        auto cyclesUsed = cpu.ExecuteProfiled(10, memory, profiler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 1u);
+        EXPECT_EQ(profiler.OpCodes[0x02].Executions, 1u);
+        EXPECT_EQ(profiler.OpCodes[0x02].Cycles, 1u);
+        EXPECT_EQ(profiler.ByMode(AddressingMode::Implied).Executions, 0u);
+        EXPECT_NE(profiler.Csv().find("02,???,-,1,1,0\n"), std::string::npos);
+    }
+
+    TEST_F(ProfilerFixture, Exports_ListOnlyWhatRan)
+    {
+        // Arrange
+        cpu.ExecuteProfiled(LOOP_CYCLES, memory, profiler);
+
+        // Act
+        auto csv = profiler.Csv();
+        auto json = profiler.Json();
+        auto table = profiler.Table();
+
+        // Assert
+        EXPECT_EQ(csv,
+            "opcode,mnemonic,mode,executions,cycles,page_crossings\n"
+            "4C,JMP,Absolute,1,3,0\n"
+            "9D,STA,AbsoluteX,1,5,0\n"
+            "A2,LDX,Immediate,1,2,0\n"
+            "BD,LDA,AbsoluteX,2,9,1\n");
+
+        EXPECT_EQ(json.rfind("{\"opcodes\":[{\"opcode\":76,\"mnemonic\":\"JMP\",\"mode\":\"Absolute\",", 0), 0u);
+        EXPECT_NE(json.find("{\"mode\":\"AbsoluteX\",\"executions\":3,\"cycles\":14,\"page_crossings\":1}"), std::string::npos);
+        EXPECT_NE(json.find("\"total\":{\"executions\":5,\"cycles\":19,\"page_crossings\":1}}"), std::string::npos);
+
+        // Most cycles first
+        EXPECT_LT(table.find("$BD"), table.find("$9D"));
+        EXPECT_LT(table.find("$9D"), table.find("$4C"));
+        EXPECT_EQ(table.find("$A9"), std::string::npos);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Recompiler.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class RecompilerFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+        Recompiler recompiler;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory, 0x0200);
+            recompiler.HotThreshold = 1u;
+        }
+
+        void TearDown() override
+        { }
+
+        void AssertSameState(CPU const & expected, CPU const & actual)
+        {
+            EXPECT_EQ(actual.PC, expected.PC);
+            EXPECT_EQ(actual.SP, expected.SP);
+            EXPECT_EQ(actual.A, expected.A);
+            EXPECT_EQ(actual.X, expected.X);
+            EXPECT_EQ(actual.Y, expected.Y);
+            EXPECT_EQ(actual.Status, expected.Status);
+            EXPECT_EQ(actual.DebugStatus, expected.DebugStatus);
+        }
+
+        // Runs the same slices of cycles through the interpreter and the recompiler
+        void TestMatchesInterpreter(uint32 slices, uint32 cyclesPerSlice)
+        {
+            CPU interpreted = cpu;
+            auto interpretedMemory = std::make_unique<Memory>(memory);
+
+            for (uint32 i = 0; i < slices; ++i)
+            {
+                auto expectedCycles = interpreted.Execute(cyclesPerSlice, *interpretedMemory);
+                auto cyclesUsed = cpu.Execute(cyclesPerSlice, memory, recompiler);
+
+                ASSERT_EQ(cyclesUsed, expectedCycles) << "Slice " << i;
+            }
+
+            AssertSameState(interpreted, cpu);
+            EXPECT_EQ(memcmp(memory.Data, interpretedMemory->Data, Memory::MAX_MEMORY), 0);
+        }
+
+        // Straight line of random instructions looping back to 0x0200, control flow other than the
+        // closing jump is left out so every run stays inside the program
+        void LoadRandomProgram(std::mt19937 & random)
+        {
+            std::vector<OpCodeDescription> candidates;
+            for (auto const & description : CPU::OpCodeDescriptions)
+            {
+                if (description.Op != Operation::JMP && description.Op != Operation::JSR && description.Op != Operation::RTS)
+                    candidates.push_back(description);
+            }
+
+            for (uint32 address = 0x0000; address < 0x0200; ++address)
+                memory.WriteByte(address, static_cast<Byte>(random()));
+
+            Word pc = 0x0200;
+            for (int i = 0; i < 40; ++i)
+            {
+                auto const & description = candidates[random() % candidates.size()];
+                memory.WriteByte(pc++, description.OpCode);
+
+                auto length = InstructionLength(description.Mode);
+                if (length == 2)
+                {
+                    memory.WriteByte(pc++, static_cast<Byte>(random()));
+                }
+                else if (length == 3)
+                {
+                    // Keep absolute accesses near the program so some stores hit code
+                    memory.WriteWord(pc, static_cast<Word>(0x0180 + random() % 0x0100));
+                    pc += 2;
+                }
+            }
+
+            memory.WriteByte(pc++, CPU::INS_JMP_ABS);
+            memory.WriteWord(pc, 0x0200);
+
+            cpu.SP = 0xFF;
+            cpu.A = static_cast<Byte>(random());
+            cpu.X = static_cast<Byte>(random());
+            cpu.Y = static_cast<Byte>(random());
+        }
+
+    };
+
+
+    TEST_F(RecompilerFixture, RandomPrograms_MatchInterpreter)
+    {
+        for (uint32 seed = 1; seed <= 64; ++seed)
+        {
+            SCOPED_TRACE(testing::Message() << "Seed " << seed);
+
+            std::mt19937 random(seed);
+            memory.Initialize();
+            cpu.Reset(memory, 0x0200);
+            recompiler.Cache.Clear();
+            LoadRandomProgram(random);
+
+            TestMatchesInterpreter(100u, 1u + seed * 7u);
+        }
+    }
+
+
+    TEST_F(RecompilerFixture, SubroutineLoop_MatchesInterpreter)
+    {
+        // Arrange
+        memory.WriteByte(0x0200, CPU::INS_JSR);
+        memory.WriteWord(0x0201, 0x0300);
+        memory.WriteByte(0x0203, CPU::INS_JMP_IND);
+        memory.WriteWord(0x0204, 0x0010);
+        memory.WriteWord(0x0010, 0x0200);
+
+        memory.WriteByte(0x0300, CPU::INS_LDA_ZP);
+        memory.WriteByte(0x0301, 0x12);
+        memory.WriteByte(0x0302, CPU::INS_PHA);
+        memory.WriteByte(0x0303, CPU::INS_PLP);
+        memory.WriteByte(0x0304, CPU::INS_RTS);
+        memory.WriteByte(0x0012, 0x80);
+
+        // Act / Assert
+        TestMatchesInterpreter(50u, 37u);
+    }
+
+
+    TEST_F(RecompilerFixture, HotBlock_IsCompiled)
+    {
+        // Arrange
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x11);
+        memory.WriteByte(0x0202, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0203, 0x0200);
+
+        // Act
+        auto cyclesUsed = cpu.Execute(50u, memory, recompiler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 50u);
+        EXPECT_EQ(cpu.A, 0x11);
+#if EMU_RECOMPILER
+        EXPECT_NE(recompiler.Cache.Find(0x0200, memory)->Native, nullptr);
+#endif
+    }
+
+
+    TEST_F(RecompilerFixture, StoreToCompiledCode_MatchesInterpreter)
+    {
+        // Arrange
+        memory.WriteByte(0x0200, CPU::INS_LDA_ZP);
+        memory.WriteByte(0x0201, 0x10);
+        memory.WriteByte(0x0202, CPU::INS_STA_ABS);     // Overwrite the operand of the load in the other block
+        memory.WriteWord(0x0203, 0x0301);
+        memory.WriteByte(0x0205, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0206, 0x0300);
+
+        memory.WriteByte(0x0300, CPU::INS_LDX_IM);
+        memory.WriteByte(0x0301, 0x00);
+        memory.WriteByte(0x0302, CPU::INS_PHA);
+        memory.WriteByte(0x0303, CPU::INS_TSX);
+        memory.WriteByte(0x0304, CPU::INS_STX_ZP);
+        memory.WriteByte(0x0305, 0x10);
+        memory.WriteByte(0x0306, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0307, 0x0200);
+
+        // Act / Assert
+        TestMatchesInterpreter(40u, 23u);
+#if EMU_RECOMPILER
+        EXPECT_NE(recompiler.Cache.Find(0x0200, memory)->Native, nullptr);
+#endif
+    }
+
+
+    TEST_F(RecompilerFixture, BadInstruction_SetsUnhandledInstructionBit)
+    {
+        // Arrange
+        memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+        memory.WriteByte(0x0201, 0x11);
+        memory.WriteByte(0x0202, 0x00);
+
+        // Act
+        auto cyclesUsed = cpu.Execute(20u, memory, recompiler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 3u);
+        EXPECT_TRUE(cpu.DebugFlags.UnhandledInstruction);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Rewind.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class RewindFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+
+        void SetUp() override
+        {
+            Load(cpu, memory);
+        }
+
+        void TearDown() override
+        { }
+
+        // Counts through $0010 by table lookup and leaves each count in a page at $4000, so
+        // every pass changes memory. 18 cycles a pass
+        static void Load(CPU & cpu, Memory & memory)
+        {
+            cpu.Reset(memory, 0x0200);
+
+            for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+                memory.WriteByte(0x3000 + i, static_cast<Byte>(i + 1));
+
+            memory.WriteByte(0x0200, CPU::INS_LDX_ZP);
+            memory.WriteByte(0x0201, 0x10);
+            memory.WriteByte(0x0202, CPU::INS_LDA_ABSX);
+            memory.WriteWord(0x0203, 0x3000);
+            memory.WriteByte(0x0205, CPU::INS_STA_ZP);
+            memory.WriteByte(0x0206, 0x10);
+            memory.WriteByte(0x0207, CPU::INS_STA_ABSX);
+            memory.WriteWord(0x0208, 0x4000);
+            memory.WriteByte(0x020A, CPU::INS_JMP_ABS);
+            memory.WriteWord(0x020B, 0x0200);
+        }
+
+        // The same program run straight through to cycle
+        static void ExpectMatchesStraightRun(CPU & rewound, Memory const & rewoundMemory, uint64 cycle)
+        {
+            Memory expectedMemory;
+            CPU expected;
+            Load(expected, expectedMemory);
+            expected.ExecuteUntil(cycle, expectedMemory);
+
+            EXPECT_EQ(rewound.TotalCycles, expected.TotalCycles);
+            EXPECT_EQ(rewound.PC, expected.PC);
+            EXPECT_EQ(rewound.A, expected.A);
+            EXPECT_EQ(rewound.X, expected.X);
+            EXPECT_EQ(rewound.ObservedStatus(), expected.ObservedStatus());
+            EXPECT_EQ(memcmp(rewoundMemory.Data, expectedMemory.Data, Memory::MAX_MEMORY), 0);
+        }
+    };
+
+
+    TEST_F(RewindFixture, Seek_AnyCycle_MatchesStraightRun)
+    {
+        // Arrange
+        RewindBuffer rewind(3000, 500);
+        rewind.Run(cpu, memory, 20000);
+
+        for (uint64 cycle : { 0u, 1u, 500u, 777u, 3000u, 12345u, 19999u, 20000u })
+        {
+            // Act
+            CPU rewound;
+            Memory rewoundMemory;
+            auto ok = rewind.Seek(rewound, rewoundMemory, cycle);
+
+            // Assert
+            ASSERT_TRUE(ok);
+            ExpectMatchesStraightRun(rewound, rewoundMemory, cycle);
+        }
+    }
+
+    TEST_F(RewindFixture, Seek_PastCycle_ClearsCycleOverflow)
+    {
+        // Arrange
+        RewindBuffer rewind(3000, 500);
+        rewind.Run(cpu, memory, 20000);
+
+        // Act
+        CPU rewound;
+        Memory rewoundMemory;
+        auto ok = rewind.Seek(rewound, rewoundMemory, 778);
+
+        // Assert
+        ASSERT_TRUE(ok);
+        EXPECT_GT(rewound.TotalCycles, 778u);
+        EXPECT_FALSE(rewound.DebugFlags.CycleOverflow);
+    }
+
+    TEST_F(RewindFixture, Seek_UnhandledInstructionBeforeCycle_ReturnsFalse)
+    {
+        // Arrange
+        RewindBuffer rewind(3000, 500);
+        rewind.Run(cpu, memory, 2000);
+        memory.WriteByte(0x020A, 0x00);
+        rewind.Capture(cpu, memory);
+
+        // Act
+        CPU rewound;
+        Memory rewoundMemory;
+        auto ok = rewind.Seek(rewound, rewoundMemory, 5000);
+
+        // Assert
+        EXPECT_FALSE(ok);
+        EXPECT_LT(rewound.TotalCycles, 5000u);
+        EXPECT_TRUE(rewound.DebugFlags.UnhandledInstruction);
+    }
+
+    TEST_F(RewindFixture, Seek_CorruptDelta_ReturnsFalse)
+    {
+        // Arrange
+        RewindBuffer rewind(3000, 500);
+        rewind.Run(cpu, memory, 2000);
+        auto & pages = rewind.Keyframes.back().Deltas.front().Pages;
+        ASSERT_FALSE(pages.empty());
+        pages.resize(pages.size() - 1);
+
+        // Act
+        CPU rewound;
+        Memory rewoundMemory;
+        auto ok = rewind.Seek(rewound, rewoundMemory, 1999);
+
+        // Assert
+        EXPECT_FALSE(ok);
+    }
+
+    TEST_F(RewindFixture, Seek_ThenReset_ClearsMemory)
+    {
+        // Arrange
+        RewindBuffer rewind(3000, 500);
+        rewind.Run(cpu, memory, 5000);
+
+        CPU rewound;
+        Memory rewoundMemory;
+        rewound.Reset(rewoundMemory);
+        ASSERT_TRUE(rewind.Seek(rewound, rewoundMemory, 4100));
+
+        // Act
+        rewound.Reset(rewoundMemory);
+
+        // Assert
+        uint32 nonZero = 0u;
+        for (uint32 address = 0; address < Memory::MAX_MEMORY; ++address)
+            nonZero += rewoundMemory.ReadByte(address) != 0x00 ? 1u : 0u;
+
+        EXPECT_EQ(nonZero, 0u);
+    }
+
+    TEST_F(RewindFixture, Seek_ThenResetToSnapshot_PutsBackSnapshot)
+    {
+        // Arrange
+        RewindBuffer rewind(3000, 500);
+        rewind.Run(cpu, memory, 5000);
+
+        CPU rewound;
+        Memory rewoundMemory;
+        rewound.Reset(rewoundMemory);
+        rewoundMemory.WriteByte(0x3000, 0x77);
+
+        MemorySnapshot snapshot;
+        rewoundMemory.Checkpoint(snapshot);
+        ASSERT_TRUE(rewind.Seek(rewound, rewoundMemory, 4100));
+
+        // Act
+        rewound.Reset(rewoundMemory, snapshot);
+
+        // Assert
+        EXPECT_EQ(rewoundMemory.ReadByte(0x3000), 0x77);
+        EXPECT_EQ(rewoundMemory.ReadByte(0x3001), 0x00);
+        EXPECT_EQ(rewoundMemory.ReadByte(0x4000), 0x00);
+        EXPECT_EQ(memcmp(rewoundMemory.Data, snapshot.Data, Memory::MAX_MEMORY), 0);
+    }
+
+    TEST_F(RewindFixture, Run_BetweenKeyframes_StoresSmallDeltas)
+    {
+        // Arrange
+        RewindBuffer rewind(10000, 500);
+
+        // Act
+        rewind.Run(cpu, memory, 9999);
+
+        // Assert
+        ASSERT_EQ(rewind.Keyframes.size(), 1u);
+        EXPECT_GE(rewind.Keyframes[0].Deltas.size(), 19u);
+        for (auto const & delta : rewind.Keyframes[0].Deltas)
+        {
+            EXPECT_GT(delta.Pages.size(), 0u);
+            EXPECT_LT(delta.Pages.size(), 2u * (3u + 32u));
+        }
+    }
+
+    TEST_F(RewindFixture, Capture_PastMemoryCap_DropsOldestKeyframes)
+    {
+        // Arrange
+        RewindBuffer rewind(2000, 200, 96 * 1024);
+
+        // Act
+        rewind.Run(cpu, memory, 100000);
+
+        // Assert
+        EXPECT_LE(rewind.MemoryUsed, rewind.MemoryCap);
+        EXPECT_GT(rewind.OldestCycle(), 0u);
+        EXPECT_GE(rewind.NewestCycle(), 100000u - 200u);
+
+        CPU rewound;
+        Memory rewoundMemory;
+        EXPECT_FALSE(rewind.Seek(rewound, rewoundMemory, rewind.OldestCycle() - 1));
+        ASSERT_TRUE(rewind.Seek(rewound, rewoundMemory, rewind.OldestCycle() + 1));
+        ExpectMatchesStraightRun(rewound, rewoundMemory, rewind.OldestCycle() + 1);
+    }
+
+    TEST_F(RewindFixture, Run_AfterSeekBack_ReplacesLaterHistory)
+    {
+        // Arrange
+        RewindBuffer rewind(3000, 500);
+        rewind.Run(cpu, memory, 10000);
+        rewind.Seek(cpu, memory, 4100);
+        auto seekCycle = cpu.TotalCycles;
+
+        // Act
+        memory.WriteByte(0x5000, 0x42);
+        rewind.Run(cpu, memory, 6000);
+
+        // Assert
+        EXPECT_LT(rewind.NewestCycle(), 6500u);
+        EXPECT_EQ(rewind.Keyframes.back().Cycle, seekCycle);
+
+        CPU rewound;
+        Memory rewoundMemory;
+        ASSERT_TRUE(rewind.Seek(rewound, rewoundMemory, 5000));
+        EXPECT_EQ(rewoundMemory.ReadByte(0x5000), 0x42);
+
+        ASSERT_TRUE(rewind.Seek(rewound, rewoundMemory, 4000));
+        EXPECT_EQ(rewoundMemory.ReadByte(0x5000), 0x00);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include <Emu/CPU.hpp>
+#include <Emu/SaveState.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class SaveStateFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory, 0x0200);
+
+            // Mostly zero RAM with a program, a run of one value and a page of noise
+            memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+            memory.WriteByte(0x0201, 0x80);
+            memory.WriteByte(0x0202, CPU::INS_JMP_ABS);
+            memory.WriteWord(0x0203, 0x0200);
+
+            for (uint32 i = 0; i < 100; ++i)
+                memory.WriteByte(0x3000 + i, 0xEA);
+
+            for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+                memory.WriteByte(0x4000 + i, static_cast<Byte>(i * 37 + 11));
+
+            cpu.Execute(20, memory);
+            cpu.X = 0x12;
+            cpu.Y = 0x34;
+            cpu.SP = 0xF0;
+        }
+
+        void TearDown() override
+        { }
+
+        void ExpectSameMachine(CPU & restored, Memory const & restoredMemory)
+        {
+            EXPECT_EQ(restored.PC, cpu.PC);
+            EXPECT_EQ(restored.SP, cpu.SP);
+            EXPECT_EQ(restored.A, cpu.A);
+            EXPECT_EQ(restored.X, cpu.X);
+            EXPECT_EQ(restored.Y, cpu.Y);
+            EXPECT_EQ(restored.ObservedStatus(), cpu.ObservedStatus());
+            EXPECT_EQ(restored.TotalCycles, cpu.TotalCycles);
+
+            for (uint32 address = 0; address < Memory::MAX_MEMORY; ++address)
+            {
+                ASSERT_EQ(restoredMemory.ReadByte(address), memory.ReadByte(address)) << "at " << address;
+            }
+        }
+    };
+
+
+    TEST_F(SaveStateFixture, Save_MostlyZeroMemory_PacksIt)
+    {
+        // Act
+        auto bytes = SaveState::Save(cpu, memory);
+        SaveState::Header header;
+        memcpy(&header, bytes.data(), sizeof(header));
+
+        // Assert
+        EXPECT_LT(bytes.size(), sizeof(SaveState::Header) + 2 * Memory::PAGE_SIZE);
+        EXPECT_EQ(header.Pages[0x00].Encoding, SaveState::PageEncoding::Zero);
+        EXPECT_EQ(header.Pages[0x02].Encoding, SaveState::PageEncoding::Packed);
+        EXPECT_EQ(header.Pages[0x30].Encoding, SaveState::PageEncoding::Packed);
+        EXPECT_EQ(header.Pages[0x40].Encoding, SaveState::PageEncoding::Raw);
+    }
+
+    TEST_F(SaveStateFixture, Restore_Packed_RestoresMachine)
+    {
+        // Arrange
+        RomImage image(SaveState::Save(cpu, memory));
+        Memory restoredMemory;
+        CPU restored;
+        restored.Reset(restoredMemory);
+        restoredMemory.WriteByte(0x5000, 0x99);
+
+        // Act
+        auto ok = SaveState::Restore(image, restored, restoredMemory);
+
+        // Assert
+        ASSERT_TRUE(ok);
+        ExpectSameMachine(restored, restoredMemory);
+    }
+
+    TEST_F(SaveStateFixture, Restore_Raw_MapsPagesFromImage)
+    {
+        // Arrange
+        RomImage image(SaveState::Save(cpu, memory, false));
+        Memory restoredMemory;
+        CPU restored;
+
+        // Act
+        auto ok = SaveState::Restore(image, restored, restoredMemory);
+        restoredMemory.WriteByte(0x4001, 0x00);
+
+        // Assert
+        ASSERT_TRUE(ok);
+        EXPECT_TRUE(restoredMemory.IsShared(0x02));
+        EXPECT_GE(restoredMemory.ReadPages[0x02], image.Data());
+        EXPECT_LT(restoredMemory.ReadPages[0x02], image.Data() + image.Size);
+
+        // The write went to a private copy, the image still holds the saved byte
+        EXPECT_FALSE(restoredMemory.IsShared(0x40));
+        EXPECT_EQ(restoredMemory.ReadByte(0x4001), 0x00);
+        restoredMemory.WriteByte(0x4001, memory.ReadByte(0x4001));
+        ExpectSameMachine(restored, restoredMemory);
+    }
+
+    TEST_F(SaveStateFixture, Restore_RomPage_KeepsMappingAndFillsDataUnderIt)
+    {
+        // Arrange
+        RomImage image(SaveState::Save(cpu, memory));
+        static Byte const rom[Memory::PAGE_SIZE] = { 0x42 };
+        Memory restoredMemory;
+        CPU restored;
+        restoredMemory.MapRom(0x40, 1, rom);
+
+        // Act
+        auto ok = SaveState::Restore(image, restored, restoredMemory);
+
+        // Assert
+        ASSERT_TRUE(ok);
+        EXPECT_EQ(restoredMemory.ReadByte(0x4000), 0x42);
+        EXPECT_EQ(restoredMemory.Data[0x4001], memory.ReadByte(0x4001));
+    }
+
+    TEST_F(SaveStateFixture, Restore_ThenReset_ClearsPackedPages)
+    {
+        // Arrange
+        RomImage image(SaveState::Save(cpu, memory));
+        Memory restoredMemory;
+        CPU restored;
+        restored.Reset(restoredMemory);
+        ASSERT_TRUE(SaveState::Restore(image, restored, restoredMemory));
+
+        // Act
+        restored.Reset(restoredMemory);
+
+        // Assert
+        EXPECT_EQ(restoredMemory.ReadByte(0x0200), 0x00);
+        EXPECT_EQ(restoredMemory.ReadByte(0x3000), 0x00);
+        EXPECT_EQ(restoredMemory.ReadByte(0x3063), 0x00);
+    }
+
+    TEST_F(SaveStateFixture, Restore_RawThenReset_ClearsMappedPages)
+    {
+        // Arrange
+        RomImage image(SaveState::Save(cpu, memory, false));
+        Memory restoredMemory;
+        CPU restored;
+        ASSERT_TRUE(SaveState::Restore(image, restored, restoredMemory));
+        ASSERT_TRUE(restoredMemory.IsShared(0x02));
+
+        // Act
+        restored.Reset(restoredMemory);
+
+        // Assert
+        EXPECT_FALSE(restoredMemory.IsShared(0x02));
+        EXPECT_EQ(restoredMemory.ReadByte(0x0200), 0x00);
+        EXPECT_EQ(restoredMemory.ReadByte(0x3000), 0x00);
+        EXPECT_EQ(restoredMemory.ReadByte(0x3063), 0x00);
+    }
+
+    TEST_F(SaveStateFixture, Restore_RawThenResetTracked_ClearsMappedPages)
+    {
+        // Arrange
+        RomImage image(SaveState::Save(cpu, memory, false));
+        Memory restoredMemory;
+        CPU restored;
+        restored.Reset(restoredMemory);
+        ASSERT_TRUE(SaveState::Restore(image, restored, restoredMemory));
+
+        // Act
+        restored.Reset(restoredMemory);
+
+        // Assert
+        EXPECT_FALSE(restoredMemory.IsShared(0x02));
+        EXPECT_EQ(restoredMemory.ReadByte(0x0200), 0x00);
+        EXPECT_EQ(restoredMemory.ReadByte(0x3063), 0x00);
+    }
+
+    TEST_F(SaveStateFixture, Restore_ThenResetToSnapshot_PutsBackSnapshot)
+    {
+        // Arrange
+        RomImage image(SaveState::Save(cpu, memory));
+        Memory restoredMemory;
+        CPU restored;
+        restored.Reset(restoredMemory);
+        restoredMemory.WriteByte(0x3000, 0x77);
+
+        MemorySnapshot snapshot;
+        restoredMemory.Checkpoint(snapshot);
+        ASSERT_TRUE(SaveState::Restore(image, restored, restoredMemory));
+
+        // Act
+        restored.Reset(restoredMemory, snapshot);
+
+        // Assert
+        EXPECT_EQ(restoredMemory.ReadByte(0x0200), 0x00);
+        EXPECT_EQ(restoredMemory.ReadByte(0x3000), 0x77);
+        EXPECT_EQ(restoredMemory.ReadByte(0x3001), 0x00);
+    }
+
+    TEST_F(SaveStateFixture, Restore_BadImage_ReturnsFalseAndLeavesMachineAlone)
+    {
+        // Arrange
+        auto bytes = SaveState::Save(cpu, memory);
+        auto badVersion = bytes;
+        badVersion[8] = SaveState::VERSION + 1;
+        auto badPage = bytes;
+        badPage[32 + 2 * 8 + 4] = 0xFF;     // Size of the packed page 0x02
+        auto truncated = std::vector<Byte>(bytes.begin(), bytes.end() - 1);
+
+        Memory restoredMemory;
+        CPU restored;
+        restored.Reset(restoredMemory, 0x1234);
+
+        for (auto const & bad : { badVersion, badPage, truncated })
+        {
+            // Act
+            auto ok = SaveState::Restore(RomImage(bad), restored, restoredMemory);
+
+            // Assert
+            EXPECT_FALSE(ok);
+            EXPECT_EQ(restored.PC, 0x1234);
+            EXPECT_TRUE(restoredMemory.IsFlat());
+        }
+    }
+
+    TEST_F(SaveStateFixture, SaveFile_MapFile_RestoresMachine)
+    {
+        // Arrange
+        auto path = std::filesystem::temp_directory_path() / "Emu6502_SaveFile_MapFile_RestoresMachine.state";
+        Memory restoredMemory;
+        CPU restored;
+
+        // Act
+        auto saved = SaveState::SaveFile(path.string().c_str(), cpu, memory);
+        auto image = MapFile(path.string().c_str());
+        auto ok = SaveState::Restore(image, restored, restoredMemory);
+
+        // Assert
+        EXPECT_TRUE(saved);
+        ASSERT_TRUE(ok);
+        ExpectSameMachine(restored, restoredMemory);
+
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    TEST(SaveStateTests, Pack_RoundTripsEveryRunShape)
+    {
+        // Arrange
+        Byte page[Memory::PAGE_SIZE];
+        for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+            page[i] = static_cast<Byte>(i < 130 ? 0 : i < 132 ? 1 : i % 3 == 0 ? i : 7);
+
+        Byte packed[SaveState::MAX_PACKED_SIZE];
+        Byte unpacked[Memory::PAGE_SIZE];
+
+        // Act
+        auto size = SaveState::Pack(page, packed);
+        auto ok = SaveState::Unpack(packed, size, unpacked);
+
+        // Assert
+        EXPECT_LE(size, SaveState::MAX_PACKED_SIZE);
+        ASSERT_TRUE(ok);
+        EXPECT_EQ(memcmp(page, unpacked, Memory::PAGE_SIZE), 0);
+    }
+
+}
\ No newline at end of file
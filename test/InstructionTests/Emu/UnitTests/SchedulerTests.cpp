@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Scheduler.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    // Records when it ran and optionally comes back every Period cycles
+    struct TestDevice
+    {
+        std::vector<uint64> Deadlines;
+        std::vector<uint64> Times;
+        uint64 Period = 0u;
+        uint32 Irq = 0u;
+
+        static void Tick(void * context, Scheduler & scheduler, Memory & memory, uint64 deadline)
+        {
+            auto & device = *static_cast<TestDevice *>(context);
+            device.Deadlines.push_back(deadline);
+            device.Times.push_back(scheduler.Now);
+
+            if (device.Irq != 0)
+                scheduler.RaiseIrq(device.Irq);
+
+            if (device.Period != 0)
+                scheduler.Schedule(deadline + device.Period, &Tick, context);
+        }
+    };
+
+    class SchedulerFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+        Scheduler scheduler;
+
+        void SetUp() override
+        {
+            cpu.Reset(memory, 0x0200);
+
+            // LDA #$01 / JMP $0200, 5 cycles a loop
+            memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+            memory.WriteByte(0x0201, 0x01);
+            memory.WriteByte(0x0202, CPU::INS_JMP_ABS);
+            memory.WriteWord(0x0203, 0x0200);
+
+            // Handlers at 0x0300 (IRQ) and 0x0400 (NMI) load a marker into X and return
+            memory.WriteWord(CPU::IRQ_VECTOR, 0x0300);
+            memory.WriteByte(0x0300, CPU::INS_LDX_IM);
+            memory.WriteByte(0x0301, 0x11);
+            memory.WriteByte(0x0302, CPU::INS_RTI);
+
+            memory.WriteWord(CPU::NMI_VECTOR, 0x0400);
+            memory.WriteByte(0x0400, CPU::INS_LDX_IM);
+            memory.WriteByte(0x0401, 0x22);
+            memory.WriteByte(0x0402, CPU::INS_RTI);
+        }
+
+        void TearDown() override
+        { }
+    };
+
+
+    TEST_F(SchedulerFixture, RunDue_RunsEventsInDeadlineThenScheduleOrder)
+    {
+        // Arrange
+        std::vector<int> order;
+        struct Context { std::vector<int> * Order; int Value; };
+        Context first { &order, 1 }, second { &order, 2 }, third { &order, 3 };
+
+        auto record = [](void * context, Scheduler &, Memory &, uint64)
+        {
+            auto & c = *static_cast<Context *>(context);
+            c.Order->push_back(c.Value);
+        };
+
+        scheduler.Schedule(20, record, &third);
+        scheduler.Schedule(10, record, &first);
+        scheduler.Schedule(10, record, &second);
+        scheduler.Now = 20;
+
+        // Act
+        scheduler.RunDue(memory);
+
+        // Assert
+        EXPECT_EQ(order, (std::vector<int> { 1, 2, 3 }));
+        EXPECT_EQ(scheduler.NextDeadline(), Scheduler::NEVER);
+    }
+
+    TEST_F(SchedulerFixture, Cancel_RemovesEvent)
+    {
+        // Arrange
+        TestDevice device;
+        auto id = scheduler.Schedule(10, &TestDevice::Tick, &device);
+        scheduler.Schedule(20, &TestDevice::Tick, &device);
+
+        // Act
+        auto cancelled = scheduler.Cancel(id);
+        auto again = scheduler.Cancel(id);
+        cpu.Execute(30, memory, scheduler);
+
+        // Assert
+        EXPECT_TRUE(cancelled);
+        EXPECT_FALSE(again);
+        EXPECT_EQ(device.Deadlines, (std::vector<uint64> { 20 }));
+    }
+
+    TEST_F(SchedulerFixture, Execute_NothingScheduled_RunsWholeBudget)
+    {
+        // Act
+        auto cyclesUsed = cpu.Execute(100, memory, scheduler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 100u);
+        EXPECT_EQ(scheduler.Now, 100u);
+        EXPECT_FALSE(cpu.DebugFlags.CycleOverflow);
+    }
+
+    TEST_F(SchedulerFixture, Execute_PeriodicEvent_RunsAtEveryDeadline)
+    {
+        // Arrange
+        TestDevice device;
+        device.Period = 7;
+        scheduler.Schedule(7, &TestDevice::Tick, &device);
+
+        // Act
+        auto cyclesUsed = cpu.Execute(50, memory, scheduler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 50u);
+        EXPECT_EQ(device.Deadlines, (std::vector<uint64> { 7, 14, 21, 28, 35, 42, 49 }));
+
+        // Events run after the instruction that reaches their deadline
+        for (size_t i = 0; i < device.Times.size(); ++i)
+        {
+            EXPECT_GE(device.Times[i], device.Deadlines[i]);
+            EXPECT_LT(device.Times[i] - device.Deadlines[i], 3u);
+        }
+
+        EXPECT_FALSE(cpu.DebugFlags.CycleOverflow);
+    }
+
+    TEST_F(SchedulerFixture, Execute_RunsPastBudget_SetsCycleOverflow)
+    {
+        // Act
+        auto cyclesUsed = cpu.Execute(4, memory, scheduler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 5u);
+        EXPECT_TRUE(cpu.DebugFlags.CycleOverflow);
+    }
+
+    TEST_F(SchedulerFixture, Execute_IrqRaised_EntersHandlerAndReturns)
+    {
+        // Arrange
+        TestDevice device;
+        device.Irq = 1;
+        scheduler.Schedule(5, &TestDevice::Tick, &device);
+
+        // Act
+        auto cyclesUsed = cpu.Execute(5 + CPU::INTERRUPT_CYCLES, memory, scheduler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 12u);
+        EXPECT_EQ(cpu.PC, 0x0300);
+        EXPECT_TRUE(cpu.StatusFlags.IRQDisableFlag);
+        EXPECT_EQ(cpu.SP, 0xFF - 3);
+        EXPECT_EQ(memory.ReadByte(0x01FF), 0x02);      // PC high
+        EXPECT_EQ(memory.ReadByte(0x01FE), 0x00);      // PC low
+        EXPECT_EQ(memory.ReadByte(0x01FD) & 0b00110000, 0b00100000);
+
+        // Act
+        scheduler.ClearIrq();
+        cyclesUsed = cpu.Execute(2 + 6, memory, scheduler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 8u);
+        EXPECT_EQ(cpu.X, 0x11);
+        EXPECT_EQ(cpu.PC, 0x0200);
+        EXPECT_EQ(cpu.SP, 0xFF);
+        EXPECT_FALSE(cpu.StatusFlags.IRQDisableFlag);
+    }
+
+    TEST_F(SchedulerFixture, Execute_IrqMasked_TakenOnceUnmasked)
+    {
+        // Arrange
+        cpu.StatusFlags.IRQDisableFlag = 1;
+        scheduler.RaiseIrq();
+
+        // Act
+        cpu.Execute(20, memory, scheduler);
+
+        // Assert
+        EXPECT_EQ(cpu.X, 0x00);
+        EXPECT_LT(cpu.PC, 0x0300);
+
+        // Arrange, PHP / PLP with the mask bit clear
+        memory.WriteByte(0x0200, CPU::INS_PLP);
+        memory.WriteByte(0x0100 | cpu.SP, 0x00);
+        memory.WriteByte(0x0201, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0202, 0x0201);
+        cpu.PC = 0x0200;
+        cpu.SP -= 1;
+
+        // Act
+        auto cyclesUsed = cpu.Execute(4 + CPU::INTERRUPT_CYCLES, memory, scheduler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 11u);
+        EXPECT_EQ(cpu.PC, 0x0300);
+    }
+
+    TEST_F(SchedulerFixture, Execute_NmiRaised_TakenWhileIrqMasked)
+    {
+        // Arrange
+        cpu.StatusFlags.IRQDisableFlag = 1;
+        scheduler.RaiseNmi();
+
+        // Act
+        auto cyclesUsed = cpu.Execute(CPU::INTERRUPT_CYCLES + 2, memory, scheduler);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 9u);
+        EXPECT_EQ(cpu.X, 0x22);
+        EXPECT_FALSE(scheduler.NmiPending);
+    }
+
+}
\ No newline at end of file
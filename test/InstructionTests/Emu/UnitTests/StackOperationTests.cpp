@@ -205,6 +205,29 @@ namespace Emu::UnitTests
     TEST_F(StackOperationsFixture, INS_PHP)
     { TestPushRegisterToStack(CPU::INS_PHP, 0x44, &CPU::Status); }
 
+    TEST_F(StackOperationsFixture, INS_PHP_AfterLoad_PushesLoadFlags)
+    {
+        // Arrange
+        uint32 cyclesExpected = 2u + 3u + 2u + 3u;
+
+        cpu.Status = 0b10000001;
+        memory.WriteByte(0xFFFC, CPU::INS_LDA_IM);
+        memory.WriteByte(0xFFFD, 0x00);
+        memory.WriteByte(0xFFFE, CPU::INS_PHP);
+        memory.WriteByte(0xFFFF, CPU::INS_LDX_IM);
+        memory.WriteByte(0x0000, 0x80);
+        memory.WriteByte(0x0001, CPU::INS_PHP);
+
+        // Act
+        auto cyclesUsed = cpu.Execute(cyclesExpected, memory);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, cyclesExpected);
+        EXPECT_EQ(memory.ReadByte(0x01FF), 0b00000011);
+        EXPECT_EQ(memory.ReadByte(0x01FE), 0b10000001);
+        EXPECT_EQ(cpu.Status, 0b10000001);
+    }
+
 
     TEST_F(StackOperationsFixture, INS_PLA_WithPositiveValue)
     { TestPopStackToRegister(CPU::INS_PLA, 0x45, &CPU::A); }
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <Emu/Symbols.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    TEST(SymbolsTests, ParseVice_ReadsLabelsWithAndWithoutMemorySpace)
+    {
+        // Arrange
+        SymbolTable symbols;
+
+        // Act
+        symbols.ParseVice(
+            "al 00C000 .reset\n"
+            "al C:c010 .irq\r\n"
+            "al 00C000 .also_reset\n"
+            "break c000\n"
+            "al 12345 .too_big\n");
+
+        // Assert
+        EXPECT_EQ(symbols.Size(), 2u);
+        EXPECT_STREQ(symbols.Find(0xC000), "reset");
+        EXPECT_STREQ(symbols.Find(0xC010), "irq");
+        EXPECT_EQ(symbols.Find(0xC001), nullptr);
+    }
+
+    TEST(SymbolsTests, ParseCa65Debug_ReadsLabelSymbolsOnly)
+    {
+        // Arrange
+        SymbolTable symbols;
+
+        // Act
+        symbols.ParseCa65Debug(
+            "version\tmajor=2,minor=0\n"
+            "seg\tid=0,name=\"CODE\",start=0x000200,size=0x0010,addrsize=absolute,type=ro\n"
+            "sym\tid=0,name=\"main\",addrsize=absolute,scope=0,def=3,ref=9,val=0x200,seg=0,type=lab\n"
+            "sym\tid=1,name=\"print\",addrsize=absolute,scope=0,def=5,val=0x0300,seg=0,type=lab\n"
+            "sym\tid=2,name=\"COUNT\",addrsize=zeropage,scope=0,def=7,val=0x10,type=equ\n");
+
+        // Assert
+        EXPECT_EQ(symbols.Size(), 2u);
+        EXPECT_STREQ(symbols.Find(0x0200), "main");
+        EXPECT_STREQ(symbols.Find(0x0300), "print");
+        EXPECT_EQ(symbols.Find(0x0010), nullptr);
+    }
+
+    TEST(SymbolsTests, Load_MissingFile_ReturnsFalse)
+    {
+        // Arrange
+        SymbolTable symbols;
+
+        // Act
+        auto loaded = symbols.Load("does/not/exist.lbl");
+
+        // Assert
+        EXPECT_FALSE(loaded);
+        EXPECT_EQ(symbols.Size(), 0u);
+    }
+
+}
\ No newline at end of file
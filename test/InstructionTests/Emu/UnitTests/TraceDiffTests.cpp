@@ -0,0 +1,265 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include <Emu/CPU.hpp>
+#include <Emu/TraceDiff.hpp>
+#include <Emu/TraceRecorder.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class TraceDiffFixture : public testing::Test
+    {
+    public:
+        std::filesystem::path leftPath;
+        std::filesystem::path rightPath;
+
+        static constexpr uint32 LOOP_INSTRUCTIONS = 4;
+        static constexpr uint32 LOOP_CYCLES = 3 + 4 + 3 + 3;
+
+        void SetUp() override
+        {
+            auto name = std::string("Emu6502_") + testing::UnitTest::GetInstance()->current_test_info()->name();
+            leftPath = std::filesystem::temp_directory_path() / (name + ".left.trace");
+            rightPath = std::filesystem::temp_directory_path() / (name + ".right.trace");
+        }
+
+        void TearDown() override
+        {
+            std::error_code error;
+            std::filesystem::remove(leftPath, error);
+            std::filesystem::remove(rightPath, error);
+        }
+
+        // Counts through $0010 by table lookup: LDX $10 / LDA $3000,X / STA $10 / JMP $0200
+        static void Load(CPU & cpu, Memory & memory)
+        {
+            cpu.Reset(memory, 0x0200);
+
+            for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+                memory.WriteByte(0x3000 + i, static_cast<Byte>(i + 1));
+
+            memory.WriteByte(0x0200, CPU::INS_LDX_ZP);
+            memory.WriteByte(0x0201, 0x10);
+            memory.WriteByte(0x0202, CPU::INS_LDA_ABSX);
+            memory.WriteWord(0x0203, 0x3000);
+            memory.WriteByte(0x0205, CPU::INS_STA_ZP);
+            memory.WriteByte(0x0206, 0x10);
+            memory.WriteByte(0x0207, CPU::INS_JMP_ABS);
+            memory.WriteWord(0x0208, 0x0200);
+        }
+
+        // Records passes of the loop from startCycle, writing value to $0010 after the first
+        // pokeAfter of them when pokeAfter is not 0
+        static void Record(std::filesystem::path const & path, uint32 passes, uint32 pokeAfter = 0, Byte value = 0, uint64 startCycle = 0)
+        {
+            Memory memory;
+            CPU cpu;
+            Load(cpu, memory);
+            cpu.TotalCycles = startCycle;
+
+            TraceRecorder recorder(cpu, memory, path.string().c_str(), true);
+
+            if (pokeAfter != 0)
+            {
+                cpu.ExecuteProfiled(pokeAfter * LOOP_CYCLES, memory, recorder);
+                memory.WriteByte(0x0010, value);
+                passes -= pokeAfter;
+            }
+
+            cpu.ExecuteProfiled(passes * LOOP_CYCLES, memory, recorder);
+        }
+
+        static std::string NestestLine(TraceRecord const & record)
+        {
+            return fmt::format("{:04X}  {:02X} {:02X} {:02X}  LDA $0000 = 00                  A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X} PPU:  0, 21 CYC:{}\r\n",
+                record.PC, record.OpCode, record.Operand1, record.Operand2,
+                record.A, record.X, record.Y, record.Status | 0b00100000, record.SP, record.Cycle + 7);
+        }
+    };
+
+
+    TEST_F(TraceDiffFixture, Compare_SameRun_Matches)
+    {
+        // Arrange
+        Record(leftPath, 3000);
+        Record(rightPath, 3000);
+
+        TraceFile left, right;
+        ASSERT_TRUE(left.Open(leftPath.string().c_str()));
+        ASSERT_TRUE(right.Open(rightPath.string().c_str()));
+
+        // Act
+        auto result = TraceDiff::Compare(left, right);
+
+        // Assert
+        EXPECT_FALSE(result.Diverged);
+        EXPECT_TRUE(result.Complete);
+        EXPECT_EQ(result.Index, 3000u * LOOP_INSTRUCTIONS);
+    }
+
+    TEST_F(TraceDiffFixture, Compare_StartedAtDifferentCycles_ComparesFromFirstRecord)
+    {
+        // Arrange
+        Record(leftPath, 100);
+        Record(rightPath, 101, 0, 0, 5000);
+
+        TraceFile left, right;
+        ASSERT_TRUE(left.Open(leftPath.string().c_str()));
+        ASSERT_TRUE(right.Open(rightPath.string().c_str()));
+
+        // Act
+        auto result = TraceDiff::Compare(left, right);
+
+        // Assert
+        EXPECT_TRUE(result.Diverged);
+        EXPECT_EQ(result.Fields, 0u);
+        EXPECT_EQ(result.Index, 100u * LOOP_INSTRUCTIONS);
+        EXPECT_EQ(result.Right.PC, 0x0200);
+        EXPECT_EQ(result.Right.Cycle, 5000u + 100u * LOOP_CYCLES);
+    }
+
+    TEST_F(TraceDiffFixture, Compare_RegisterDiffers_ReportsFirstDivergenceWithHistory)
+    {
+        // Arrange, the poke changes X and the Zero flag from the LDA of pass 1024, record 4097,
+        // the second of the second block
+        Record(leftPath, 1100);
+        Record(rightPath, 1100, 1024, 0x55);
+
+        TraceFile left, right;
+        ASSERT_TRUE(left.Open(leftPath.string().c_str()));
+        ASSERT_TRUE(right.Open(rightPath.string().c_str()));
+
+        // Act
+        auto result = TraceDiff::Compare(left, right);
+
+        // Assert
+        EXPECT_TRUE(result.Diverged);
+        EXPECT_EQ(result.Index, 1024u * LOOP_INSTRUCTIONS + 1);
+        EXPECT_EQ(result.Fields, TraceDiff::FIELD_X | TraceDiff::FIELD_STATUS);
+        EXPECT_EQ(result.Left.OpCode, CPU::INS_LDA_ABSX);
+        EXPECT_EQ(result.Left.X, 0x00);
+        EXPECT_EQ(result.Right.X, 0x55);
+
+        ASSERT_EQ(result.History.size(), 8u);
+        EXPECT_EQ(result.History.back().OpCode, CPU::INS_LDX_ZP);
+        EXPECT_EQ(result.History.back().Cycle, 1024u * LOOP_CYCLES);
+        EXPECT_EQ(result.History.front().Cycle, 1022u * LOOP_CYCLES + 3);
+
+        auto report = result.Format();
+        EXPECT_NE(report.find("record 4097"), std::string::npos);
+        EXPECT_NE(report.find("X:55"), std::string::npos);
+    }
+
+    TEST_F(TraceDiffFixture, Compare_IgnoredField_Matches)
+    {
+        // Arrange
+        Record(leftPath, 300);
+        Record(rightPath, 300, 200, 0x10 + 200);
+
+        TraceFile left, right;
+        ASSERT_TRUE(left.Open(leftPath.string().c_str()));
+        ASSERT_TRUE(right.Open(rightPath.string().c_str()));
+
+        TraceDiff::Options options;
+        options.Fields &= ~(TraceDiff::FIELD_A | TraceDiff::FIELD_X | TraceDiff::FIELD_STATUS);
+
+        // Act
+        auto result = TraceDiff::Compare(left, right, options);
+
+        // Assert
+        EXPECT_FALSE(result.Diverged);
+    }
+
+    TEST_F(TraceDiffFixture, Compare_AgainstNestestLog_MatchesWithStatusMask)
+    {
+        // Arrange
+        Record(leftPath, 2000);
+
+        TraceFile left;
+        ASSERT_TRUE(left.Open(leftPath.string().c_str()));
+
+        std::string log;
+        for (auto const & record : left.Records())
+        {
+            auto line = record;
+            auto length = CPU::OpCodeTable[line.OpCode].Length;
+            line.Operand1 = length >= 2 ? line.Operand1 : 0;
+            line.Operand2 = length >= 3 ? line.Operand2 : 0;
+            log += NestestLine(line);
+        }
+
+        TextTrace right;
+        ASSERT_TRUE(right.Open(RomImage(std::vector<Byte>(log.begin(), log.end()))));
+
+        TraceDiff::Options options;
+        options.StatusMask = 0b11001111;
+
+        // Act
+        auto masked = TraceDiff::Compare(left, right, options);
+        auto unmasked = TraceDiff::Compare(left, right);
+
+        // Assert
+        EXPECT_FALSE(masked.Diverged);
+        EXPECT_TRUE(masked.Complete);
+        EXPECT_EQ(masked.Index, 2000u * LOOP_INSTRUCTIONS);
+
+        EXPECT_TRUE(unmasked.Diverged);
+        EXPECT_EQ(unmasked.Index, 0u);
+        EXPECT_EQ(unmasked.Fields, TraceDiff::FIELD_STATUS);
+    }
+
+    TEST(TextTraceTests, ParseLine_NestestLine_ReadsRecord)
+    {
+        // Arrange
+        std::string line = "C72D  20 3B C7  JSR $C73B                       A:00 X:00 Y:00 P:26 SP:FB PPU: 31, 63 CYC:3721";
+        TraceRecord record;
+
+        // Act
+        auto parsed = TextTrace::ParseLine(line.data(), line.size(), record);
+
+        // Assert
+        EXPECT_TRUE(parsed);
+        EXPECT_EQ(record, (TraceRecord { 3721, 0xC72D, 0x20, 0x3B, 0xC7, 0x00, 0x00, 0x00, 0x26, 0xFB }));
+    }
+
+    TEST(TextTraceTests, ParseLine_OneByteInstruction_LeavesOperandsZero)
+    {
+        // Arrange
+        std::string line = "C72F  EA        NOP                             A:00 X:00 Y:00 P:26 SP:F9 PPU: 31, 72 CYC:3724\r";
+        TraceRecord record;
+
+        // Act
+        auto parsed = TextTrace::ParseLine(line.data(), line.size(), record);
+
+        // Assert
+        EXPECT_TRUE(parsed);
+        EXPECT_EQ(record, (TraceRecord { 3724, 0xC72F, 0xEA, 0x00, 0x00, 0x00, 0x00, 0x00, 0x26, 0xF9 }));
+    }
+
+    TEST(TextTraceTests, ReadChunk_BadLine_ReturnsFalse)
+    {
+        // Arrange
+        std::string log =
+            "C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7\n"
+            "C5F5  A2 00     LDX #$00                        A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 30 CYC:10\n"
+            "not a log line\n";
+
+        TextTrace trace;
+        ASSERT_TRUE(trace.Open(RomImage(std::vector<Byte>(log.begin(), log.end()))));
+        auto block = std::make_unique<TraceBlock>();
+        auto at = trace.Begin();
+
+        // Act
+        auto read = trace.ReadChunk(at, *block);
+
+        // Assert
+        EXPECT_FALSE(read);
+        EXPECT_EQ(block->Count, 2u);
+        EXPECT_EQ(block->PC[1], 0xC5F5);
+        EXPECT_EQ(block->Operand1[1], 0x00);
+    }
+
+}
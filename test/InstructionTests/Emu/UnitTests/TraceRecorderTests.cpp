@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include <Emu/CPU.hpp>
+#include <Emu/TraceRecorder.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class TraceRecorderFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+        std::filesystem::path path;
+
+        // Instructions and cycles in one pass of the loop written by Load, and the cycle each
+        // instruction starts at within the pass
+        static constexpr uint32 LOOP_INSTRUCTIONS = 4;
+        static constexpr uint32 LOOP_CYCLES = 3 + 4 + 3 + 3;
+        static constexpr uint32 LOOP_OFFSETS[LOOP_INSTRUCTIONS] = { 0, 3, 7, 10 };
+
+        void SetUp() override
+        {
+            path = std::filesystem::temp_directory_path()
+                / (std::string("Emu6502_") + testing::UnitTest::GetInstance()->current_test_info()->name() + ".trace");
+
+            Load(cpu, memory);
+        }
+
+        void TearDown() override
+        {
+            std::error_code error;
+            std::filesystem::remove(path, error);
+        }
+
+        // Counts through $0010 by table lookup: LDX $10 / LDA $3000,X / STA $10 / JMP $0200
+        static void Load(CPU & cpu, Memory & memory)
+        {
+            cpu.Reset(memory, 0x0200);
+
+            for (uint32 i = 0; i < Memory::PAGE_SIZE; ++i)
+                memory.WriteByte(0x3000 + i, static_cast<Byte>(i + 1));
+
+            memory.WriteByte(0x0200, CPU::INS_LDX_ZP);
+            memory.WriteByte(0x0201, 0x10);
+            memory.WriteByte(0x0202, CPU::INS_LDA_ABSX);
+            memory.WriteWord(0x0203, 0x3000);
+            memory.WriteByte(0x0205, CPU::INS_STA_ZP);
+            memory.WriteByte(0x0206, 0x10);
+            memory.WriteByte(0x0207, CPU::INS_JMP_ABS);
+            memory.WriteWord(0x0208, 0x0200);
+        }
+
+        std::vector<TraceRecord> Read()
+        {
+            TraceFile trace;
+            EXPECT_TRUE(trace.Open(path.string().c_str()));
+            return trace.Records();
+        }
+    };
+
+
+    TEST_F(TraceRecorderFixture, Recorder_RecordsEachInstructionBeforeItRuns)
+    {
+        // Arrange
+        TraceRecorder recorder(cpu, memory, path.string().c_str());
+        ASSERT_TRUE(recorder.IsOpen());
+
+        // Act
+        cpu.ExecuteProfiled(LOOP_CYCLES + 3, memory, recorder);
+        EXPECT_TRUE(recorder.Stop());
+        auto records = Read();
+
+        // Assert, the Zero flag from LDX is still pending when LDA is recorded. Operand bytes an
+        // instruction does not use are 0
+        ASSERT_EQ(records.size(), 5u);
+        EXPECT_EQ(records[0], (TraceRecord { 0, 0x0200, CPU::INS_LDX_ZP, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF }));
+        EXPECT_EQ(records[1], (TraceRecord { 3, 0x0202, CPU::INS_LDA_ABSX, 0x00, 0x30, 0x00, 0x00, 0x00, 0b00000010, 0xFF }));
+        EXPECT_EQ(records[2], (TraceRecord { 7, 0x0205, CPU::INS_STA_ZP, 0x10, 0x00, 0x01, 0x00, 0x00, 0x00, 0xFF }));
+        EXPECT_EQ(records[3], (TraceRecord { 10, 0x0207, CPU::INS_JMP_ABS, 0x00, 0x02, 0x01, 0x00, 0x00, 0x00, 0xFF }));
+        EXPECT_EQ(records[4], (TraceRecord { 13, 0x0200, CPU::INS_LDX_ZP, 0x10, 0x00, 0x01, 0x00, 0x00, 0x00, 0xFF }));
+    }
+
+    TEST_F(TraceRecorderFixture, Recorder_InstructionAtEndOfPage_ReadsOperandsFromNextPage)
+    {
+        // Arrange, JMP $0200 with its opcode in the last byte of page 2
+        cpu.Reset(memory, 0x02FF);
+        memory.WriteByte(0x02FF, CPU::INS_JMP_ABS);
+        memory.WriteWord(0x0300, 0x0200);
+        TraceRecorder recorder(cpu, memory, path.string().c_str());
+
+        // Act
+        cpu.ExecuteProfiled(3, memory, recorder);
+        EXPECT_TRUE(recorder.Stop());
+        auto records = Read();
+
+        // Assert
+        ASSERT_EQ(records.size(), 1u);
+        EXPECT_EQ(records[0], (TraceRecord { 0, 0x02FF, CPU::INS_JMP_ABS, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0xFF }));
+        EXPECT_EQ(cpu.PC, 0x0200);
+    }
+
+    TEST_F(TraceRecorderFixture, Recorder_ManyBlocksThroughSmallRing_RecordsEveryInstruction)
+    {
+        // Arrange
+        static constexpr uint32 PASSES = TraceBlock::CAPACITY + 17;
+        cpu.ExecuteTable(LOOP_CYCLES, memory);
+        TraceRecorder recorder(cpu, memory, path.string().c_str(), false, 2);
+
+        // Act
+        cpu.ExecuteProfiled(PASSES * LOOP_CYCLES, memory, recorder);
+        EXPECT_TRUE(recorder.Stop());
+        auto records = Read();
+
+        // Assert
+        ASSERT_EQ(records.size(), PASSES * LOOP_INSTRUCTIONS);
+        EXPECT_EQ(recorder.Recorded, records.size());
+
+        for (uint32 i = 0; i < records.size(); ++i)
+        {
+            auto pass = 1 + i / LOOP_INSTRUCTIONS;
+            auto step = i % LOOP_INSTRUCTIONS;
+
+            ASSERT_EQ(records[i].Cycle, pass * LOOP_CYCLES + LOOP_OFFSETS[step]);
+            ASSERT_EQ(records[i].X, static_cast<Byte>(step == 0 ? pass - 1 : pass));
+        }
+    }
+
+    TEST_F(TraceRecorderFixture, Recorder_Packed_MatchesUnpacked)
+    {
+        // Arrange
+        Memory unpackedMemory;
+        CPU unpackedCpu;
+        Load(unpackedCpu, unpackedMemory);
+        auto unpackedPath = path;
+        unpackedPath += ".raw";
+
+        // Act
+        {
+            TraceRecorder packed(cpu, memory, path.string().c_str(), true);
+            TraceRecorder unpacked(unpackedCpu, unpackedMemory, unpackedPath.string().c_str(), false);
+            cpu.ExecuteProfiled(10000 * LOOP_CYCLES, memory, packed);
+            unpackedCpu.ExecuteProfiled(10000 * LOOP_CYCLES, unpackedMemory, unpacked);
+        }
+
+        TraceFile packedTrace, unpackedTrace;
+        ASSERT_TRUE(packedTrace.Open(path.string().c_str()));
+        ASSERT_TRUE(unpackedTrace.Open(unpackedPath.string().c_str()));
+
+        // Assert
+        EXPECT_TRUE(packedTrace.Packed);
+        EXPECT_FALSE(unpackedTrace.Packed);
+        EXPECT_EQ(packedTrace.Records(), unpackedTrace.Records());
+        EXPECT_LT(packedTrace.Image.Size, unpackedTrace.Image.Size);
+
+        packedTrace = { };
+        unpackedTrace = { };
+        std::error_code error;
+        std::filesystem::remove(unpackedPath, error);
+    }
+
+    TEST_F(TraceRecorderFixture, Recorder_CannotCreateFile_RecordsNothing)
+    {
+        // Arrange
+        auto missing = std::filesystem::temp_directory_path() / "Emu6502_missing" / "missing.trace";
+        TraceRecorder recorder(cpu, memory, missing.string().c_str());
+
+        // Act
+        auto used = cpu.ExecuteProfiled(LOOP_CYCLES, memory, recorder);
+
+        // Assert
+        EXPECT_FALSE(recorder.IsOpen());
+        EXPECT_EQ(used, LOOP_CYCLES);
+        EXPECT_FALSE(recorder.Stop());
+    }
+
+    TEST(TraceFileTests, Encode_CycleGap_StartsNewChunk)
+    {
+        // Arrange
+        auto block = std::make_unique<TraceBlock>();
+        block->Add({ 100, 0x0200, CPU::INS_TSX, 0, 0, 1, 2, 3, 0x24, 0xFD });
+        block->Add({ 102, 0x0201, CPU::INS_TSX, 0, 0, 1, 2, 3, 0x24, 0xFD });
+        block->Add({ 1000, 0x0300, CPU::INS_TSX, 0, 0, 1, 2, 3, 0x24, 0xFD });
+
+        std::vector<Byte> bytes;
+        TraceFile::EncodeHeader(false, bytes);
+        TraceFile::Encode(*block, false, bytes);
+
+        TraceFile trace;
+        auto chunks = 0u;
+        std::vector<TraceRecord> records;
+
+        // Act
+        ASSERT_TRUE(trace.Open(RomImage(bytes)));
+        auto complete = trace.ForEachChunk(*block, [&](TraceBlock const & chunk)
+        {
+            ++chunks;
+            for (uint32 i = 0; i < chunk.Count; ++i)
+                records.push_back(chunk.Record(i));
+        });
+
+        // Assert
+        EXPECT_TRUE(complete);
+        EXPECT_EQ(chunks, 2u);
+        ASSERT_EQ(records.size(), 3u);
+        EXPECT_EQ(records[1].Cycle, 102u);
+        EXPECT_EQ(records[2].Cycle, 1000u);
+        EXPECT_EQ(records[2].PC, 0x0300);
+    }
+
+    TEST(TraceFileTests, Open_NotATrace_ReturnsFalse)
+    {
+        // Arrange
+        std::vector<Byte> bytes = { 'E', 'M', 'U', 'S', 'T', 'A', 'T', 'E' };
+        bytes.resize(32);
+        TraceFile trace;
+
+        // Act
+        auto opened = trace.Open(RomImage(bytes));
+
+        // Assert
+        EXPECT_FALSE(opened);
+    }
+
+    TEST(TraceFileTests, ForEachChunk_CutShort_ReturnsFalse)
+    {
+        // Arrange
+        auto block = std::make_unique<TraceBlock>();
+        for (uint32 i = 0; i < 100; ++i)
+            block->Add({ i * 2u, static_cast<Word>(0x0200 + i), CPU::INS_TSX, 0, 0, 0, 0, 0, 0, 0xFF });
+
+        std::vector<Byte> bytes;
+        TraceFile::EncodeHeader(true, bytes);
+        TraceFile::Encode(*block, true, bytes);
+        bytes.resize(bytes.size() - 1);
+
+        TraceFile trace;
+        ASSERT_TRUE(trace.Open(RomImage(bytes)));
+
+        // Act
+        auto complete = trace.ForEachChunk(*block, [](TraceBlock const &) { });
+
+        // Assert
+        EXPECT_FALSE(complete);
+    }
+
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <Emu/CPU.hpp>
+#include <Emu/Lockstep.hpp>
+#include <Emu/TrapLog.hpp>
+
+
+namespace Emu::UnitTests
+{
+
+    class TrapLogFixture : public testing::Test
+    {
+    public:
+        Memory memory;
+        CPU cpu;
+        TrapLog traps { 4 };
+
+        void SetUp() override
+        {
+            cpu.Reset(memory, 0x0200);
+            traps.Attach(cpu);
+
+            // LDA #$01 then an opcode that is not implemented
+            memory.WriteByte(0x0200, CPU::INS_LDA_IM);
+            memory.WriteByte(0x0201, 0x01);
+            memory.WriteByte(0x0202, 0x02);
+        }
+
+        void TearDown() override
+        { }
+    };
+
+
+    TEST_F(TrapLogFixture, Execute_UnhandledOpCode_RecordsPCOpCodeAndCycle)
+    {
+        // Act
+        auto cyclesUsed = cpu.Execute(10, memory);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 3u);
+        EXPECT_TRUE(cpu.DebugFlags.UnhandledInstruction);
+        ASSERT_EQ(traps.Count(), 1u);
+
+        auto trap = traps.Snapshot()[0];
+        EXPECT_EQ(trap.PC, 0x0202);
+        EXPECT_EQ(trap.OpCode, 0x02);
+        EXPECT_EQ(trap.Cycle, cpu.TotalCycles);
+        EXPECT_EQ(trap.Cycle, 3u);
+    }
+
+    TEST_F(TrapLogFixture, Execute_EveryBackEnd_RecordsSameTrap)
+    {
+        // Arrange
+        BlockCache cache;
+        std::vector<std::function<uint32()>> backEnds {
+            [&] { return cpu.ExecuteTable(10, memory); },
+            [&] { return cpu.Execute(10, memory, cache); },
+        };
+
+        for (auto & execute : backEnds)
+        {
+            cpu.ResetRegisters(0x0200);
+            cpu.TotalCycles = 100;
+            traps.Clear();
+
+            // Act
+            execute();
+
+            // Assert
+            ASSERT_EQ(traps.Count(), 1u);
+            EXPECT_EQ(traps.Snapshot()[0].PC, 0x0202);
+            EXPECT_EQ(traps.Snapshot()[0].Cycle, 103u);
+        }
+    }
+
+    TEST_F(TrapLogFixture, Execute_RunOutOfBudgetOnTrap_RecordsCyclePastBudget)
+    {
+        // Arrange
+        cpu.PC = 0x0202;
+
+        // Act
+        cpu.ExecuteUntil(0, memory);
+        auto cyclesUsed = cpu.Execute(1, memory);
+
+        // Assert
+        EXPECT_EQ(cyclesUsed, 1u);
+        ASSERT_EQ(traps.Count(), 1u);
+        EXPECT_EQ(traps.Snapshot()[0].Cycle, 1u);
+    }
+
+    TEST_F(TrapLogFixture, Record_PastCapacity_KeepsMostRecent)
+    {
+        // Act
+        for (uint64 cycle = 1; cycle <= 6; ++cycle)
+            TrapLog::Record(&traps, { cycle, 0x0300, 0x03 });
+
+        // Assert
+        EXPECT_EQ(traps.Count(), 6u);
+        EXPECT_EQ(traps.Dropped(), 2u);
+
+        auto retained = traps.Snapshot();
+        ASSERT_EQ(retained.size(), 4u);
+        EXPECT_EQ(retained.front().Cycle, 3u);
+        EXPECT_EQ(retained.back().Cycle, 6u);
+
+        auto text = traps.Format();
+        EXPECT_EQ(text.rfind("2 earlier traps dropped\nInstruction not handled: 03 at $0300, cycle 3\n", 0), 0u);
+    }
+
+    TEST_F(TrapLogFixture, Lockstep_UnhandledOpCode_RecordedForEachLane)
+    {
+        // Arrange
+        auto lockstep = std::make_unique<Lockstep<32>>(memory, 0x0200);
+        for (auto & lane : lockstep->Cpus)
+            traps.Attach(lane);
+
+        // Act
+        lockstep->Run(100);
+
+        // Assert
+        ASSERT_EQ(traps.Count(), 32u);
+        for (auto const & trap : traps.Snapshot())
+        {
+            EXPECT_EQ(trap.PC, 0x0202);
+            EXPECT_EQ(trap.OpCode, 0x02);
+            EXPECT_EQ(trap.Cycle, 3u);
+        }
+    }
+
+}
\ No newline at end of file